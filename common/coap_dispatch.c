@@ -0,0 +1,113 @@
+/**
+ * @ingroup     climote
+ * @{
+ *
+ * @file
+ * @brief       Implements path lookup in sorted CoAP resource tables
+ *
+ * @author      smlng <s@mlng.net>
+ *
+ * @}
+ */
+
+#include <string.h>
+
+#include "coap_dispatch.h"
+
+/**
+ * @brief path of the resource at idx, i.e., the first member of the struct
+ */
+static const char *_path(const void *table, size_t size, size_t idx)
+{
+    const char *path = *(const char *const *)((const uint8_t *)table + idx * size);
+    return (path[0] == '/') ? path + 1 : path;
+}
+
+int coap_dispatch_cmp(const char *path, const coap_dispatch_seg_t *segs,
+                      unsigned numof)
+{
+    const unsigned char *p = (const unsigned char *)path;
+    if (*p == '/') {
+        p++;
+    }
+    for (unsigned i = 0; i < numof; i++) {
+        /* segments are joined by '/' */
+        if (i > 0) {
+            if (*p != '/') {
+                return (int)*p - '/';
+            }
+            p++;
+        }
+        for (size_t j = 0; j < segs[i].len; j++, p++) {
+            if (*p == '\0') {
+                return -1;
+            }
+            if (*p != segs[i].p[j]) {
+                return (int)*p - (int)segs[i].p[j];
+            }
+        }
+    }
+    return (int)*p;
+}
+
+/**
+ * @brief linear scan, stops at the first path sorting after the segments
+ */
+static int _find_linear(const void *table, size_t numof, size_t size,
+                        const coap_dispatch_seg_t *segs, unsigned nsegs)
+{
+    for (size_t i = 0; i < numof; i++) {
+        int res = coap_dispatch_cmp(_path(table, size, i), segs, nsegs);
+        if (res == 0) {
+            return (int)i;
+        }
+        if (res > 0) {
+            break;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief binary search for the lower bound, such that duplicates are found
+ *        from the first one
+ */
+static int _find_binary(const void *table, size_t numof, size_t size,
+                        const coap_dispatch_seg_t *segs, unsigned nsegs)
+{
+    size_t lo = 0;
+    size_t hi = numof;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (coap_dispatch_cmp(_path(table, size, mid), segs, nsegs) < 0) {
+            lo = mid + 1;
+        }
+        else {
+            hi = mid;
+        }
+    }
+    if ((lo < numof) &&
+        (coap_dispatch_cmp(_path(table, size, lo), segs, nsegs) == 0)) {
+        return (int)lo;
+    }
+    return -1;
+}
+
+int coap_dispatch_find(const void *table, size_t numof, size_t size,
+                       const coap_dispatch_seg_t *segs, unsigned nsegs)
+{
+    if (numof <= COAP_DISPATCH_LINEAR_MAX) {
+        return _find_linear(table, numof, size, segs, nsegs);
+    }
+    return _find_binary(table, numof, size, segs, nsegs);
+}
+
+size_t coap_dispatch_check(const void *table, size_t numof, size_t size)
+{
+    for (size_t i = 1; i < numof; i++) {
+        if (strcmp(_path(table, size, i - 1), _path(table, size, i)) > 0) {
+            return i;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,152 @@
+/**
+ * @ingroup     climote
+ * @{
+ *
+ * @file
+ * @brief       Implements CoAP ETag validation
+ *
+ * @author      smlng <s@mlng.net>
+ *
+ * @}
+ */
+
+#include <string.h>
+
+#include "xtimer.h"
+
+#include "coap_etag.h"
+
+#define OPT_ETAG            (4U)
+#define OPT_ETAG_MAX_LEN    (8U)
+#define PAYLOAD_MARKER      (0xff)
+
+static uint32_t salt = 0;
+
+void coap_etag_from_gen(uint32_t gen, uint8_t *etag)
+{
+    if (salt == 0) {
+        /* the first request arrives at a random time after boot */
+        salt = (2166136261U ^ xtimer_now_usec()) * 16777619U;
+        salt = salt ? salt : 1;
+    }
+    gen ^= salt;
+    for (unsigned i = 0; i < COAP_ETAG_LEN; i++) {
+        etag[i] = gen >> (8 * (COAP_ETAG_LEN - 1 - i));
+    }
+}
+
+/**
+ * @brief read the extended option delta or length
+ *
+ * @return 0 on success, -1 on error
+ */
+static int _ext(const uint8_t **pos, const uint8_t *end, unsigned *val)
+{
+    if (*val == 13) {
+        if (*pos >= end) {
+            return -1;
+        }
+        *val = 13 + **pos;
+        *pos += 1;
+    }
+    else if (*val == 14) {
+        if ((end - *pos) < 2) {
+            return -1;
+        }
+        *val = 269 + (((unsigned)(*pos)[0] << 8) | (*pos)[1]);
+        *pos += 2;
+    }
+    else if (*val == 15) {
+        return -1;
+    }
+    return 0;
+}
+
+int coap_etag_match(const uint8_t *opts, size_t len,
+                    const uint8_t *etag, size_t etag_len)
+{
+    const uint8_t *pos = opts;
+    const uint8_t *end = opts + len;
+    unsigned num = 0;
+    while ((pos < end) && (*pos != PAYLOAD_MARKER)) {
+        unsigned delta = *pos >> 4;
+        unsigned olen = *pos & 0xf;
+        pos++;
+        if ((_ext(&pos, end, &delta) != 0) || (_ext(&pos, end, &olen) != 0) ||
+            ((size_t)(end - pos) < olen)) {
+            return 0;
+        }
+        num += delta;
+        /* options are sorted, a request may carry several tags */
+        if (num > OPT_ETAG) {
+            return 0;
+        }
+        if ((num == OPT_ETAG) && (olen == etag_len) &&
+            (memcmp(pos, etag, etag_len) == 0)) {
+            return 1;
+        }
+        pos += olen;
+    }
+    return 0;
+}
+
+/**
+ * @brief write an option delta or length with its extended bytes
+ *
+ * @return number of extended bytes
+ */
+static size_t _put_ext(unsigned val, uint8_t *nibble, uint8_t *ext)
+{
+    if (val < 13) {
+        *nibble = val;
+        return 0;
+    }
+    if (val < 269) {
+        *nibble = 13;
+        ext[0] = val - 13;
+        return 1;
+    }
+    *nibble = 14;
+    ext[0] = (val - 269) >> 8;
+    ext[1] = (val - 269) & 0xff;
+    return 2;
+}
+
+ssize_t coap_etag_insert(uint8_t *msg, size_t len, size_t max,
+                         const uint8_t *etag, size_t etag_len)
+{
+    if ((len < 4) || (etag_len == 0) || (etag_len > OPT_ETAG_MAX_LEN)) {
+        return -1;
+    }
+    size_t opts = 4 + (msg[0] & 0x0f);
+    if (opts > len) {
+        return -1;
+    }
+    /* header of the first option, its delta becomes relative to the tag */
+    uint8_t hdr[5];
+    size_t old_len = 0, new_len = 0;
+    if ((opts < len) && (msg[opts] != PAYLOAD_MARKER)) {
+        const uint8_t *pos = msg + opts + 1;
+        unsigned delta = msg[opts] >> 4;
+        unsigned olen = msg[opts] & 0xf;
+        if ((_ext(&pos, msg + len, &delta) != 0) ||
+            (_ext(&pos, msg + len, &olen) != 0) || (delta < OPT_ETAG)) {
+            return -1;
+        }
+        old_len = pos - (msg + opts);
+        uint8_t dn, ln;
+        new_len = 1 + _put_ext(delta - OPT_ETAG, &dn, hdr + 1);
+        new_len += _put_ext(olen, &ln, hdr + new_len);
+        hdr[0] = (dn << 4) | ln;
+    }
+    size_t grow = 1 + etag_len + new_len - old_len;
+    if ((len + grow) > max) {
+        return -1;
+    }
+    memmove(msg + opts + grow + old_len, msg + opts + old_len,
+            len - opts - old_len);
+    msg[opts] = (OPT_ETAG << 4) | etag_len;
+    memcpy(msg + opts + 1, etag, etag_len);
+    memcpy(msg + opts + 1 + etag_len, hdr, new_len);
+    return len + grow;
+}
@@ -0,0 +1,269 @@
+/**
+ * @ingroup     climote
+ * @{
+ *
+ * @file
+ * @brief       Implements CoAP group communication helpers
+ *
+ * @author      smlng <s@mlng.net>
+ *
+ * @}
+ */
+
+#include <string.h>
+
+#include "msg.h"
+#include "mutex.h"
+#include "net/gnrc/netapi.h"
+#include "net/gnrc/pktbuf.h"
+#include "xtimer.h"
+#ifdef MODULE_PERIPH_CPUID
+#include "periph/cpuid.h"
+#endif
+
+#include "coap_group.h"
+
+#define LEISURE_KEY         "leisure="
+#define LEISURE_KEY_LEN     (sizeof(LEISURE_KEY) - 1)
+
+#define GROUP_QUEUE_SIZE    (8U)
+#define GROUP_MSG_FLUSH     (0x4346)    /**< timer of the group thread */
+#define GROUP_RECORD_US     (US_PER_SEC)/**< handlers respond within */
+#define GROUP_MIN_DELAY_US  (US_PER_MS) /**< xtimer spins below some us */
+
+enum {
+    SLOT_FREE = 0,
+    SLOT_RECORDED,                      /**< group request received */
+    SLOT_QUEUED,                        /**< response waiting */
+};
+
+/**
+ * @brief a group request and its deferred response
+ */
+typedef struct {
+    ipv6_addr_t addr;                   /**< address of the client */
+    uint16_t port;                      /**< port of the client */
+    uint8_t state;                      /**< SLOT_FREE, ... */
+    uint8_t tkl;                        /**< token length */
+    uint8_t mid[2];                     /**< message ID of the request */
+    uint8_t token[8];                   /**< token of the request */
+    uint32_t time;                      /**< reception, or due if queued */
+    uint16_t len;                       /**< length of rsp */
+    uint8_t rsp[COAP_GROUP_RSP_MAX];    /**< response */
+} group_slot_t;
+
+static char group_stack[COAP_GROUP_STACKSIZE];
+static msg_t group_queue[GROUP_QUEUE_SIZE];
+static kernel_pid_t group_pid = KERNEL_PID_UNDEF;
+static group_slot_t slots[COAP_GROUP_NUMOF];
+static mutex_t slots_lock = MUTEX_INIT;
+static xtimer_t flush_timer;
+static msg_t flush_msg = { .type = GROUP_MSG_FLUSH };
+
+static uint32_t state = 0;
+
+/**
+ * @brief xorshift seeded per node, nodes must not pick the same delays
+ */
+static uint32_t _random(void)
+{
+    if (state == 0) {
+        uint32_t seed = 2166136261U ^ xtimer_now_usec();
+#ifdef MODULE_PERIPH_CPUID
+        uint8_t id[CPUID_LEN];
+        cpuid_get(id);
+        for (unsigned i = 0; i < CPUID_LEN; i++) {
+            seed = (seed ^ id[i]) * 16777619U;
+        }
+#endif
+        state = seed ? seed : 1;
+    }
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+uint32_t coap_leisure_from_query(const char *query, size_t len)
+{
+    size_t pos = 0;
+    while (pos < len) {
+        /* skip separators, then compare the key of this parameter */
+        while ((pos < len) && ((query[pos] == '?') || (query[pos] == '&'))) {
+            pos++;
+        }
+        if (((len - pos) > LEISURE_KEY_LEN) &&
+            (strncmp(query + pos, LEISURE_KEY, LEISURE_KEY_LEN) == 0)) {
+            uint32_t ms = 0;
+            for (pos += LEISURE_KEY_LEN; (pos < len) &&
+                 (query[pos] >= '0') && (query[pos] <= '9'); pos++) {
+                ms = ms * 10 + (query[pos] - '0');
+                if (ms > COAP_LEISURE_MAX_MS) {
+                    return COAP_LEISURE_MAX_MS;
+                }
+            }
+            return ms;
+        }
+        while ((pos < len) && (query[pos] != '&')) {
+            pos++;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief get message ID and token of a message
+ *
+ * @return token length, -1 if msg is too short
+ */
+static int _header(const uint8_t *msg, size_t len, const uint8_t **token)
+{
+    if ((len < 4) || ((msg[0] & 0x0f) > 8) || (len < (4U + (msg[0] & 0x0f)))) {
+        return -1;
+    }
+    unsigned tkl = msg[0] & 0x0f;
+    *token = msg + 4;
+    return tkl;
+}
+
+/**
+ * @brief arm the timer for the earliest queued response, call with lock held
+ */
+static void _arm(uint32_t now)
+{
+    group_slot_t *next = NULL;
+    for (unsigned i = 0; i < COAP_GROUP_NUMOF; i++) {
+        if ((slots[i].state == SLOT_QUEUED) &&
+            ((next == NULL) || ((int32_t)(slots[i].time - next->time) < 0))) {
+            next = &slots[i];
+        }
+    }
+    if (next == NULL) {
+        xtimer_remove(&flush_timer);
+        return;
+    }
+    int32_t delay = next->time - now;
+    xtimer_set_msg(&flush_timer, (delay > (int32_t)GROUP_MIN_DELAY_US) ?
+                   (uint32_t)delay : GROUP_MIN_DELAY_US, &flush_msg, group_pid);
+}
+
+void coap_group_input(const coap_udp_dgram_t *dgram)
+{
+    const uint8_t *token;
+    int tkl;
+    /* requests to a group only, i.e., code class 0 but not empty */
+    if (!ipv6_addr_is_multicast(&dgram->dst) || (dgram->data == NULL) ||
+        ((tkl = _header(dgram->data, dgram->len, &token)) < 0) ||
+        (dgram->data[1] == 0) || ((dgram->data[1] >> 5) != 0)) {
+        return;
+    }
+    uint32_t now = xtimer_now_usec();
+    mutex_lock(&slots_lock);
+    /* a free or stale slot, else the oldest record, never a queued one */
+    group_slot_t *slot = NULL;
+    for (unsigned i = 0; i < COAP_GROUP_NUMOF; i++) {
+        group_slot_t *s = &slots[i];
+        if ((s->state == SLOT_FREE) || ((s->state == SLOT_RECORDED) &&
+            ((now - s->time) >= GROUP_RECORD_US))) {
+            slot = s;
+            break;
+        }
+        if ((s->state == SLOT_RECORDED) &&
+            ((slot == NULL) || ((int32_t)(s->time - slot->time) < 0))) {
+            slot = s;
+        }
+    }
+    if (slot != NULL) {
+        memcpy(&slot->addr, &dgram->src, sizeof(slot->addr));
+        slot->port = dgram->port;
+        memcpy(slot->mid, dgram->data + 2, sizeof(slot->mid));
+        slot->tkl = tkl;
+        memcpy(slot->token, token, tkl);
+        slot->time = now;
+        slot->state = SLOT_RECORDED;
+    }
+    mutex_unlock(&slots_lock);
+}
+
+int coap_group_defer(const uint8_t *rsp, size_t len, uint32_t leisure_ms)
+{
+    const uint8_t *token;
+    int tkl = _header(rsp, len, &token);
+    if ((leisure_ms == 0) || (tkl < 0) || (len > COAP_GROUP_RSP_MAX) ||
+        (group_pid <= KERNEL_PID_UNDEF)) {
+        return -1;
+    }
+    uint32_t now = xtimer_now_usec();
+    int res = -1;
+    mutex_lock(&slots_lock);
+    for (unsigned i = 0; i < COAP_GROUP_NUMOF; i++) {
+        group_slot_t *s = &slots[i];
+        if ((s->state == SLOT_RECORDED) && ((now - s->time) < GROUP_RECORD_US) &&
+            (memcmp(s->mid, rsp + 2, sizeof(s->mid)) == 0) &&
+            (s->tkl == tkl) && (memcmp(s->token, token, tkl) == 0)) {
+            memcpy(s->rsp, rsp, len);
+            s->len = len;
+            s->time = now + (_random() % (leisure_ms * US_PER_MS));
+            s->state = SLOT_QUEUED;
+            _arm(now);
+            res = 0;
+            break;
+        }
+    }
+    mutex_unlock(&slots_lock);
+    return res;
+}
+
+void coap_group_flush(void)
+{
+    uint32_t now = xtimer_now_usec();
+    mutex_lock(&slots_lock);
+    for (unsigned i = 0; i < COAP_GROUP_NUMOF; i++) {
+        group_slot_t *s = &slots[i];
+        if ((s->state == SLOT_QUEUED) && ((int32_t)(s->time - now) <= 0)) {
+            coap_udp_send(&s->addr, s->port, s->rsp, s->len);
+            s->state = SLOT_FREE;
+        }
+    }
+    _arm(now);
+    mutex_unlock(&slots_lock);
+}
+
+static void *_group_thread(void *arg)
+{
+    (void)arg;
+    static gnrc_netreg_entry_t entry;
+
+    msg_init_queue(group_queue, GROUP_QUEUE_SIZE);
+    coap_udp_register(&entry, thread_getpid());
+    while (1) {
+        msg_t msg;
+        msg_receive(&msg);
+        switch (msg.type) {
+            case GNRC_NETAPI_MSG_TYPE_RCV: {
+                coap_udp_dgram_t dgram;
+                if (coap_udp_read(msg.content.ptr, &dgram) == 0) {
+                    coap_group_input(&dgram);
+                }
+                gnrc_pktbuf_release(msg.content.ptr);
+                break;
+            }
+            case GROUP_MSG_FLUSH:
+                coap_group_flush();
+                break;
+            default:
+                break;
+        }
+    }
+    return NULL;
+}
+
+int coap_group_init(void)
+{
+    if (group_pid <= KERNEL_PID_UNDEF) {
+        group_pid = thread_create(group_stack, sizeof(group_stack),
+                                  COAP_GROUP_PRIO, THREAD_CREATE_STACKTEST,
+                                  _group_thread, NULL, "coap_group");
+    }
+    return group_pid;
+}
@@ -0,0 +1,101 @@
+/**
+ * @ingroup     climote
+ * @{
+ *
+ * @file
+ * @brief       Implements plain CoAP datagrams over GNRC UDP
+ *
+ * @author      smlng <s@mlng.net>
+ *
+ * @}
+ */
+
+#include <errno.h>
+#include <string.h>
+
+#include "byteorder.h"
+#include "net/gnrc/netapi.h"
+#include "net/gnrc/pktbuf.h"
+#include "net/ipv6/hdr.h"
+#include "net/udp.h"
+
+#include "coap_udp.h"
+
+int coap_udp_register(gnrc_netreg_entry_t *entry, kernel_pid_t pid)
+{
+    return coap_udp_register_port(entry, COAP_UDP_PORT, pid);
+}
+
+int coap_udp_register_port(gnrc_netreg_entry_t *entry, uint16_t port,
+                           kernel_pid_t pid)
+{
+#ifdef GNRC_NETREG_ENTRY_INIT_PID
+    gnrc_netreg_entry_t init = GNRC_NETREG_ENTRY_INIT_PID(port, pid);
+#else
+    gnrc_netreg_entry_t init = { NULL, port, pid };
+#endif
+    *entry = init;
+    return gnrc_netreg_register(GNRC_NETTYPE_UDP, entry);
+}
+
+int coap_udp_read(gnrc_pktsnip_t *pkt, coap_udp_dgram_t *dgram)
+{
+    gnrc_pktsnip_t *udp = gnrc_pktsnip_search_type(pkt, GNRC_NETTYPE_UDP);
+    gnrc_pktsnip_t *ip = gnrc_pktsnip_search_type(pkt, GNRC_NETTYPE_IPV6);
+    if ((udp == NULL) || (ip == NULL) || (udp->size < sizeof(udp_hdr_t)) ||
+        (ip->size < sizeof(ipv6_hdr_t))) {
+        return -1;
+    }
+    const ipv6_hdr_t *ip_hdr = ip->data;
+    const udp_hdr_t *udp_hdr = udp->data;
+    memcpy(&dgram->src, &ip_hdr->src, sizeof(dgram->src));
+    memcpy(&dgram->dst, &ip_hdr->dst, sizeof(dgram->dst));
+    dgram->port = byteorder_ntohs(udp_hdr->src_port);
+    /* gnrc_udp marks the header, without payload pkt is the header itself */
+    dgram->data = (pkt != udp) ? pkt->data : NULL;
+    dgram->len = (pkt != udp) ? pkt->size : 0;
+    return 0;
+}
+
+int coap_udp_send(const ipv6_addr_t *dst, uint16_t port,
+                  const void *data, size_t len)
+{
+    return coap_udp_send_from(COAP_UDP_PORT, dst, port, data, len);
+}
+
+int coap_udp_send_from(uint16_t src, const ipv6_addr_t *dst, uint16_t port,
+                       const void *data, size_t len)
+{
+    gnrc_pktsnip_t *payload, *udp, *ip;
+
+    if ((payload = gnrc_pktbuf_add(NULL, (void *)data, len,
+                                   GNRC_NETTYPE_UNDEF)) == NULL) {
+        return -ENOMEM;
+    }
+    if ((udp = gnrc_pktbuf_add(payload, NULL, sizeof(udp_hdr_t),
+                               GNRC_NETTYPE_UDP)) == NULL) {
+        gnrc_pktbuf_release(payload);
+        return -ENOMEM;
+    }
+    /* length and checksum are filled in by gnrc_udp and gnrc_ipv6 */
+    udp_hdr_t *udp_hdr = udp->data;
+    memset(udp_hdr, 0, sizeof(*udp_hdr));
+    udp_hdr->src_port = byteorder_htons(src);
+    udp_hdr->dst_port = byteorder_htons(port);
+    if ((ip = gnrc_pktbuf_add(udp, NULL, sizeof(ipv6_hdr_t),
+                              GNRC_NETTYPE_IPV6)) == NULL) {
+        gnrc_pktbuf_release(udp);
+        return -ENOMEM;
+    }
+    /* so are source, next header and hop limit */
+    ipv6_hdr_t *ip_hdr = ip->data;
+    memset(ip_hdr, 0, sizeof(*ip_hdr));
+    ipv6_hdr_set_version(ip_hdr);
+    memcpy(&ip_hdr->dst, dst, sizeof(ip_hdr->dst));
+    if (gnrc_netapi_dispatch_send(GNRC_NETTYPE_UDP, GNRC_NETREG_DEMUX_CTX_ALL,
+                                  ip) == 0) {
+        gnrc_pktbuf_release(ip);
+        return -ENOTCONN;
+    }
+    return len;
+}
@@ -0,0 +1,231 @@
+/**
+ * @ingroup     climote
+ * @{
+ *
+ * @file
+ * @brief       Implements CoAP over DTLS with cached sessions
+ *
+ * @author      smlng <s@mlng.net>
+ *
+ * @}
+ */
+
+#ifdef MODULE_TINYDTLS
+
+#include <string.h>
+
+#include "dtls.h"
+#include "log.h"
+#include "xtimer.h"
+#ifdef MODULE_GNRC_SOCK_UDP
+#include "net/sock/udp.h"
+#endif
+
+#include "coaps.h"
+#include "dlog.h"
+
+#if !defined(COAPS_PSK_ID) || !defined(COAPS_PSK_KEY)
+#error "COAPS=1 needs COAPS_PSK_ID and COAPS_PSK_KEY, there is no default key"
+#endif
+
+/**
+ * @brief a cached session and when it was last used
+ */
+typedef struct {
+    session_t session;
+    uint32_t last;
+    uint8_t used;
+} coaps_session_t;
+
+static dtls_context_t *ctx = NULL;
+static coaps_send_t coaps_send = NULL;
+static coaps_handler_t coaps_handler = NULL;
+static coaps_session_t cache[COAPS_SESSIONS];
+static coaps_stats_t stats;
+static uint8_t plain[COAPS_BUF_SIZE];
+
+static void _session(session_t *s, const ipv6_addr_t *addr, uint16_t port)
+{
+    memset(s, 0, sizeof(*s));
+    s->size = sizeof(s->addr) + sizeof(s->port);
+    memcpy(&s->addr, addr, sizeof(s->addr));
+    s->port = port;
+}
+
+static coaps_session_t *_find(const session_t *s)
+{
+    for (unsigned i = 0; i < COAPS_SESSIONS; i++) {
+        if (cache[i].used && dtls_session_equals(&cache[i].session, s)) {
+            return &cache[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief add a new session, drop the least recently used one if full
+ */
+static void _add(const session_t *s)
+{
+    coaps_session_t *slot = &cache[0];
+    uint32_t now = xtimer_now_usec();
+    for (unsigned i = 0; i < COAPS_SESSIONS; i++) {
+        if (!cache[i].used) {
+            slot = &cache[i];
+            break;
+        }
+        if ((now - cache[i].last) > (now - slot->last)) {
+            slot = &cache[i];
+        }
+    }
+    if (slot->used) {
+        dtls_peer_t *peer = dtls_get_peer(ctx, &slot->session);
+        if (peer) {
+            dtls_reset_peer(ctx, peer);
+        }
+        stats.evicted++;
+    }
+    slot->session = *s;
+    slot->last = now;
+    slot->used = 1;
+}
+
+static int _write(struct dtls_context_t *c, session_t *s, uint8 *buf, size_t len)
+{
+    (void) c;
+    return coaps_send(&s->addr, s->port, buf, len);
+}
+
+static int _read(struct dtls_context_t *c, session_t *s, uint8 *buf, size_t len)
+{
+    if (len > sizeof(plain)) {
+        return 0;
+    }
+    stats.requests++;
+    /* tinydtls decrypts into its own buffer, handle request in ours */
+    memcpy(plain, buf, len);
+    ssize_t res = coaps_handler(plain, len, sizeof(plain));
+    if (res > 0) {
+        dtls_write(c, s, plain, res);
+    }
+    return 0;
+}
+
+static int _event(struct dtls_context_t *c, session_t *s,
+                  dtls_alert_level_t level, unsigned short code)
+{
+    (void) c;
+    if (code == DTLS_EVENT_CONNECTED) {
+        stats.handshakes++;
+        if (_find(s) == NULL) {
+            _add(s);
+        }
+    }
+    else if (level == DTLS_ALERT_LEVEL_FATAL) {
+        stats.alerts++;
+        coaps_session_t *cs = _find(s);
+        if (cs) {
+            cs->used = 0;
+        }
+    }
+    return 0;
+}
+
+static int _psk(struct dtls_context_t *c, const session_t *s,
+                dtls_credentials_type_t type,
+                const unsigned char *desc, size_t desc_len,
+                unsigned char *result, size_t result_len)
+{
+    (void) c;
+    (void) s;
+    switch (type) {
+        case DTLS_PSK_HINT:
+            return 0;
+        case DTLS_PSK_KEY:
+            if ((desc_len != (sizeof(COAPS_PSK_ID) - 1)) ||
+                (memcmp(desc, COAPS_PSK_ID, desc_len) != 0)) {
+                DLOG_WARNING("[COAPS] unknown PSK identity\n");
+                return dtls_alert_fatal_create(DTLS_ALERT_ILLEGAL_PARAMETER);
+            }
+            if (result_len < (sizeof(COAPS_PSK_KEY) - 1)) {
+                return dtls_alert_fatal_create(DTLS_ALERT_INTERNAL_ERROR);
+            }
+            memcpy(result, COAPS_PSK_KEY, sizeof(COAPS_PSK_KEY) - 1);
+            return sizeof(COAPS_PSK_KEY) - 1;
+        default:
+            return dtls_alert_fatal_create(DTLS_ALERT_INTERNAL_ERROR);
+    }
+}
+
+static dtls_handler_t handlers = {
+    .write = _write,
+    .read = _read,
+    .event = _event,
+    .get_psk_info = _psk,
+};
+
+int coaps_init(coaps_send_t send, coaps_handler_t handler)
+{
+    coaps_send = send;
+    coaps_handler = handler;
+    dtls_init();
+    ctx = dtls_new_context(NULL);
+    if (ctx == NULL) {
+        LOG_ERROR("[COAPS] failed to create DTLS context\n");
+        return -1;
+    }
+    dtls_set_handler(ctx, &handlers);
+    return 0;
+}
+
+void coaps_input(const ipv6_addr_t *addr, uint16_t port,
+                 uint8_t *buf, size_t len)
+{
+    session_t s;
+    _session(&s, addr, port);
+    coaps_session_t *cs = _find(&s);
+    if (cs) {
+        cs->last = xtimer_now_usec();
+    }
+    dtls_handle_message(ctx, &s, buf, len);
+}
+
+const coaps_stats_t *coaps_stats(void)
+{
+    return &stats;
+}
+
+#ifdef MODULE_GNRC_SOCK_UDP
+static sock_udp_t sock;
+static sock_udp_ep_t remote;
+
+static int _sock_send(const ipv6_addr_t *addr, uint16_t port,
+                      const uint8_t *buf, size_t len)
+{
+    sock_udp_ep_t ep = remote;
+    memcpy(ep.addr.ipv6, addr, sizeof(ep.addr.ipv6));
+    ep.port = port;
+    return sock_udp_send(&sock, buf, len, &ep);
+}
+
+void coaps_run(coaps_handler_t handler)
+{
+    static uint8_t buf[COAPS_BUF_SIZE + COAPS_RECORD_OVERHEAD];
+    sock_udp_ep_t local = SOCK_IPV6_EP_ANY;
+    local.port = COAPS_PORT;
+    if ((sock_udp_create(&sock, &local, NULL, 0) < 0) ||
+        (coaps_init(_sock_send, handler) < 0)) {
+        LOG_ERROR("[COAPS] failed to start server\n");
+        return;
+    }
+    while (1) {
+        ssize_t res = sock_udp_recv(&sock, buf, sizeof(buf),
+                                    SOCK_NO_TIMEOUT, &remote);
+        if (res > 0) {
+            coaps_input((ipv6_addr_t *)remote.addr.ipv6, remote.port, buf, res);
+        }
+    }
+}
+#endif /* MODULE_GNRC_SOCK_UDP */
+
+#endif /* MODULE_TINYDTLS */
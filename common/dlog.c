@@ -0,0 +1,194 @@
+/**
+ * @ingroup     climote
+ * @{
+ *
+ * @file
+ * @brief       Implements deferred, rate limited logging
+ *
+ * @author      smlng <s@mlng.net>
+ *
+ * @}
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "irq.h"
+#include "msg.h"
+#include "thread.h"
+#include "xtimer.h"
+
+#include "dlog.h"
+
+#define DLOG_TOKEN_US   (US_PER_SEC / DLOG_RATE)
+
+/**
+ * @brief a pending line
+ */
+typedef struct {
+    const char *fmt;
+    intptr_t arg[4];
+    uint32_t repeat;            /**< times folded into this line */
+} dlog_line_t;
+
+static dlog_line_t ring[DLOG_RING_SIZE];
+static unsigned head;           /**< next line written */
+static unsigned tail;           /**< next line printed */
+static dlog_line_t last_call;   /**< format and arguments of the previous call */
+static unsigned tokens = DLOG_BURST;
+static uint32_t bucket_last;
+static dlog_stats_t stats;
+
+static kernel_pid_t dlog_pid = KERNEL_PID_UNDEF;
+static char dlog_stack[DLOG_STACKSIZE];
+
+/**
+ * @brief refill the token bucket, call with irqs disabled
+ */
+static void _refill(uint32_t now)
+{
+    uint32_t n = (now - bucket_last) / DLOG_TOKEN_US;
+    if (n == 0) {
+        return;
+    }
+    if ((tokens + n) >= DLOG_BURST) {
+        tokens = DLOG_BURST;
+        bucket_last = now;
+    }
+    else {
+        tokens += n;
+        bucket_last += n * DLOG_TOKEN_US;
+    }
+}
+
+void dlog_put(const char *fmt, intptr_t a0, intptr_t a1, intptr_t a2,
+              intptr_t a3)
+{
+    uint32_t now = xtimer_now_usec();
+    int wake = 0;
+    intptr_t arg[4] = { a0, a1, a2, a3 };
+    unsigned state = irq_disable();
+    dlog_line_t *last = &ring[(head - 1) & (DLOG_RING_SIZE - 1)];
+    /* a repeat only if the previous call and the pending line are this one,
+     * with the same values, any other line is queued on its own */
+    int same = (last_call.fmt == fmt) &&
+               (memcmp(last_call.arg, arg, sizeof(arg)) == 0);
+    last_call.fmt = fmt;
+    memcpy(last_call.arg, arg, sizeof(arg));
+    if (same && (head != tail) && (last->fmt == fmt) &&
+        (memcmp(last->arg, arg, sizeof(arg)) == 0)) {
+        last->repeat++;
+        stats.repeated++;
+    }
+    else {
+        _refill(now);
+        if ((tokens == 0) || ((head - tail) >= DLOG_RING_SIZE)) {
+            stats.dropped++;
+            irq_restore(state);
+            return;
+        }
+        tokens--;
+        wake = (head == tail);
+        last = &ring[head & (DLOG_RING_SIZE - 1)];
+        last->fmt = fmt;
+        memcpy(last->arg, arg, sizeof(arg));
+        last->repeat = 0;
+        head++;
+        stats.lines++;
+    }
+    irq_restore(state);
+    /* never blocks, a wakeup already queued is as good */
+    if (wake && (dlog_pid != KERNEL_PID_UNDEF)) {
+        msg_t m;
+        m.type = 0;
+        msg_try_send(&m, dlog_pid);
+    }
+}
+
+/**
+ * @brief check that fmt only uses the conversions documented in dlog.h
+ */
+static int _fmt_supported(const char *fmt)
+{
+    unsigned args = 0;
+    while ((fmt = strchr(fmt, '%')) != NULL) {
+        fmt++;
+        if (*fmt == '%') {
+            fmt++;
+            continue;
+        }
+        fmt += strspn(fmt, "-+ #0123456789.");
+        if ((fmt[0] == 'h') && (fmt[1] == 'h')) {
+            fmt += 2;
+        }
+        else if ((fmt[0] == 'h') || (fmt[0] == 'l')) {
+            fmt++;
+        }
+        if ((*fmt == '\0') || (strchr("diuxXocsp", *fmt) == NULL) ||
+            (++args > 4)) {
+            return 0;
+        }
+        fmt++;
+    }
+    return 1;
+}
+
+static void *dlog_thread(void *arg)
+{
+    (void) arg;
+    msg_t queue[2];
+    uint32_t reported = 0;
+
+    msg_init_queue(queue, 2);
+    while (1) {
+        dlog_line_t line;
+        unsigned state = irq_disable();
+        int pending = (head != tail);
+        if (pending) {
+            line = ring[tail & (DLOG_RING_SIZE - 1)];
+            tail++;
+        }
+        uint32_t dropped = stats.dropped;
+        irq_restore(state);
+
+        if (pending && !_fmt_supported(line.fmt)) {
+            /* the arguments do not match, do not let printf() guess */
+            printf("[LOG] unsupported format: %s", line.fmt);
+        }
+        else if (pending) {
+            printf(line.fmt, line.arg[0], line.arg[1], line.arg[2],
+                   line.arg[3]);
+            if (line.repeat) {
+                printf("[LOG] last line repeated %lu times\n",
+                       (unsigned long)line.repeat);
+            }
+        }
+        else if (dropped != reported) {
+            printf("[LOG] %lu lines dropped\n",
+                   (unsigned long)(dropped - reported));
+            reported = dropped;
+        }
+        else {
+            msg_t m;
+            msg_receive(&m);
+        }
+    }
+    return NULL;
+}
+
+int dlog_init(void)
+{
+    if (dlog_pid == KERNEL_PID_UNDEF) {
+        dlog_pid = thread_create(dlog_stack, sizeof(dlog_stack), DLOG_PRIO,
+                                 THREAD_CREATE_STACKTEST, dlog_thread, NULL,
+                                 "log");
+    }
+    return dlog_pid;
+}
+
+void dlog_stats(dlog_stats_t *out)
+{
+    unsigned state = irq_disable();
+    *out = stats;
+    irq_restore(state);
+}
@@ -0,0 +1,107 @@
+/**
+ * @ingroup     climote
+ * @{
+ *
+ * @file
+ * @brief       Implements the integer filter chain
+ *
+ * @author      smlng <s@mlng.net>
+ *
+ * @}
+ */
+
+#include <assert.h>
+#include <string.h>
+
+#include "filter.h"
+
+/* TMP006 range is -40 to 125 C. A read that succeeds with a value 5 C off
+ * the last one is a glitch, e.g., a bit error on the I2C bus, while a real
+ * change persists and is accepted after spike_max samples */
+const filter_cfg_t filter_temperature = {
+    .stages = FILTER_RANGE | FILTER_SPIKE,
+    .min = -4000, .max = 12500,
+    .spike = 500, .spike_max = 3,
+};
+
+/* humidity may leave 0 to 100 % only by measurement error, a jump of 10 %
+ * within one sample is a glitch as well, e.g., a droplet on the sensor */
+const filter_cfg_t filter_humidity = {
+    .stages = FILTER_CLAMP | FILTER_SPIKE,
+    .min = 0, .max = 10000,
+    .spike = 1000, .spike_max = 3,
+};
+
+void filter_init(filter_t *f)
+{
+    memset(f, 0, sizeof(*f));
+}
+
+/**
+ * @brief put val into median window and return the median
+ */
+static int32_t _median(filter_t *f, uint8_t size, int32_t val)
+{
+    unsigned i;
+    if (f->fill == size) {
+        /* remove oldest sample from sorted window */
+        int32_t old = f->win[f->pos];
+        for (i = 0; f->sorted[i] != old; i++) {}
+        for (; i < (unsigned)(f->fill - 1); i++) {
+            f->sorted[i] = f->sorted[i + 1];
+        }
+        f->fill--;
+    }
+    /* insertion into sorted window */
+    for (i = f->fill; (i > 0) && (f->sorted[i - 1] > val); i--) {
+        f->sorted[i] = f->sorted[i - 1];
+    }
+    f->sorted[i] = val;
+    f->fill++;
+    f->win[f->pos] = val;
+    f->pos = (f->pos + 1) % size;
+    return f->sorted[f->fill / 2];
+}
+
+int filter_apply(filter_t *f, const filter_cfg_t *cfg, int32_t *val)
+{
+    int32_t v = *val;
+
+    if (cfg->stages & (FILTER_RANGE | FILTER_CLAMP)) {
+        if ((v < cfg->min) || (v > cfg->max)) {
+            if (!(cfg->stages & FILTER_CLAMP)) {
+                f->rejected++;
+                return 1;
+            }
+            v = (v < cfg->min) ? cfg->min : cfg->max;
+        }
+    }
+    if ((cfg->stages & FILTER_SPIKE) && f->init) {
+        int32_t diff = (v > f->last) ? (v - f->last) : (f->last - v);
+        /* a persisting jump is a level shift, not a spike */
+        if ((diff > cfg->spike) && (f->spikes < cfg->spike_max)) {
+            f->spikes++;
+            f->rejected++;
+            return 1;
+        }
+    }
+    f->spikes = 0;
+    f->last = v;
+    if (cfg->stages & FILTER_MEDIAN) {
+        assert((cfg->median > 0) && (cfg->median <= FILTER_MEDIAN_SIZE));
+        v = _median(f, cfg->median, v);
+    }
+    if (cfg->stages & FILTER_EMA) {
+        if (!f->init) {
+            f->ema = v * (1 << FILTER_EMA_FRAC);
+        }
+        else {
+            f->ema += (v * (1 << FILTER_EMA_FRAC) - f->ema) >> cfg->ema_shift;
+        }
+        /* round to nearest */
+        v = (f->ema + (1 << (FILTER_EMA_FRAC - 1))) >> FILTER_EMA_FRAC;
+    }
+    f->init = 1;
+    *val = v;
+    return 0;
+}
@@ -0,0 +1,89 @@
+/**
+ * @ingroup     climote
+ * @{
+ *
+ * @file
+ * @brief       Path lookup in sorted CoAP resource tables
+ *
+ * Resource tables are arrays of structs whose first member is the path as
+ * `const char *`, e.g., gcoap_resource_t. Paths are compared in ASCII order,
+ * a leading '/' is ignored. Tables must be sorted, check this on startup with
+ * coap_dispatch_check(). A lookup compares the Uri-Path options in place,
+ * without assembling the path. Small tables are scanned, larger ones are
+ * searched binary, see tests/bench/bench_dispatch.c for the crossover.
+ *
+ * @author      smlng <s@mlng.net>
+ *
+ */
+
+#ifndef COAP_DISPATCH_H
+#define COAP_DISPATCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief tables up to this size are scanned linearly
+ */
+#ifndef COAP_DISPATCH_LINEAR_MAX
+#define COAP_DISPATCH_LINEAR_MAX    (8U)
+#endif
+
+/**
+ * @brief one path segment, i.e., the value of an Uri-Path option
+ */
+typedef struct {
+    const uint8_t *p;   /**< segment, not zero terminated */
+    size_t len;         /**< length of segment */
+} coap_dispatch_seg_t;
+
+/**
+ * @brief compare a path with a path given as segments
+ *
+ * @param[in] path  path like "/a/b" or "a/b"
+ * @param[in] segs  path segments
+ * @param[in] numof number of segments
+ *
+ * @return <0, 0, >0 if path sorts before, equal or after the segments
+ */
+int coap_dispatch_cmp(const char *path, const coap_dispatch_seg_t *segs,
+                      unsigned numof);
+
+/**
+ * @brief find the first resource of a sorted table matching a path
+ *
+ * Resources with the same path (e.g., for different methods) are adjacent,
+ * check following entries if the first one does not fit.
+ *
+ * @param[in] table     sorted resource table
+ * @param[in] numof     number of resources in table
+ * @param[in] size      size of a resource in bytes
+ * @param[in] segs      path segments
+ * @param[in] nsegs     number of segments
+ *
+ * @return index of first matching resource, -1 if not found
+ */
+int coap_dispatch_find(const void *table, size_t numof, size_t size,
+                       const coap_dispatch_seg_t *segs, unsigned nsegs);
+
+/**
+ * @brief check that a resource table is sorted by path
+ *
+ * @param[in] table     resource table
+ * @param[in] numof     number of resources in table
+ * @param[in] size      size of a resource in bytes
+ *
+ * @return 0 if sorted, otherwise index of the first out of order resource
+ */
+size_t coap_dispatch_check(const void *table, size_t numof, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* COAP_DISPATCH_H */
+/** @} */
@@ -0,0 +1,76 @@
+/**
+ * @ingroup     climote
+ * @{
+ *
+ * @file
+ * @brief       CoAP ETag validation (RFC 7252, 5.10.6) of sensor resources
+ *
+ * The ETag of a resource is the generation of the sensor snapshot it is built
+ * from, salted per boot such that tags of an earlier boot do not validate.
+ * The time of a snapshot changes with its generation only, i.e., it needs
+ * no part in the tag. A GET carrying the current
+ * tag is answered with 2.03 Valid and no payload. Neither gcoap nor
+ * microcoap know the option, hence the helpers work on raw option bytes.
+ *
+ * @author      smlng <s@mlng.net>
+ *
+ */
+
+#ifndef COAP_ETAG_H
+#define COAP_ETAG_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define COAP_ETAG_LEN           (4U)        /**< length of generated tags */
+
+/**
+ * @brief get the ETag of a snapshot generation
+ *
+ * @param[in]  gen  generation, see sensor_reg_snapshot_t
+ * @param[out] etag buffer of COAP_ETAG_LEN bytes
+ */
+void coap_etag_from_gen(uint32_t gen, uint8_t *etag);
+
+/**
+ * @brief check if the options of a request carry an ETag
+ *
+ * @param[in] opts      options of the request, i.e., right after the token
+ * @param[in] len       max length of the options, parsing stops at the
+ *                      payload marker
+ * @param[in] etag      tag to look for
+ * @param[in] etag_len  length of etag
+ *
+ * @return 1 if the tag is found, 0 otherwise
+ */
+int coap_etag_match(const uint8_t *opts, size_t len,
+                    const uint8_t *etag, size_t etag_len);
+
+/**
+ * @brief insert an ETag option into a complete message
+ *
+ * The tag becomes the first option, i.e., the message must not carry options
+ * numbered below 4 (If-Match, Uri-Host), as responses of gcoap do not.
+ *
+ * @param[in,out] msg   message, e.g., built by gcoap_finish()
+ * @param[in] len       length of msg
+ * @param[in] max       size of msg
+ * @param[in] etag      tag, at most 8 bytes
+ * @param[in] etag_len  length of etag
+ *
+ * @return new length of msg, negative if it does not fit or is malformed
+ */
+ssize_t coap_etag_insert(uint8_t *msg, size_t len, size_t max,
+                         const uint8_t *etag, size_t etag_len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* COAP_ETAG_H */
+/** @} */
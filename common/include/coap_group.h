@@ -0,0 +1,128 @@
+/**
+ * @ingroup     climote
+ * @{
+ *
+ * @file
+ * @brief       CoAP group communication (RFC 7390) helpers
+ *
+ * Nodes join the All CoAP Nodes groups and answer group requests after a
+ * random delay within the Leisure period (RFC 7252, 8.2), such that the
+ * replies of a whole segment do not collide. The requester sets the period
+ * with the query `?leisure=<ms>`.
+ *
+ * Neither sock nor POSIX sockets tell handlers the destination of a request,
+ * so a thread of its own watches all datagrams to the CoAP port, see
+ * coap_udp.h, and records the requests sent to a group. It runs before the
+ * CoAP servers. A handler passes its response to coap_group_defer(), which
+ * keeps it if the request was recorded and sends it from the group thread
+ * once due. Responses to unicast requests, to requests the thread missed,
+ * and responses larger than COAP_GROUP_RSP_MAX go out at once. The server
+ * thread never waits.
+ *
+ * @author      smlng <s@mlng.net>
+ *
+ */
+
+#ifndef COAP_GROUP_H
+#define COAP_GROUP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "thread.h"
+
+#include "coap_udp.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define COAP_GROUP_LINK         "ff02::fd"  /**< All CoAP Nodes, link-local */
+#define COAP_GROUP_SITE         "ff05::fd"  /**< All CoAP Nodes, site-local */
+
+#ifndef COAP_LEISURE_MAX_MS
+#define COAP_LEISURE_MAX_MS     (5000U)     /**< upper bound of leisure */
+#endif
+
+/**
+ * @brief group requests recorded and responses pending at a time
+ */
+#ifndef COAP_GROUP_NUMOF
+#define COAP_GROUP_NUMOF        (4U)
+#endif
+
+/**
+ * @brief largest response kept for later
+ */
+#ifndef COAP_GROUP_RSP_MAX
+#define COAP_GROUP_RSP_MAX      (128U)
+#endif
+
+#ifndef COAP_GROUP_STACKSIZE
+#define COAP_GROUP_STACKSIZE    (THREAD_STACKSIZE_DEFAULT)
+#endif
+
+/**
+ * @brief above gcoap and the CoAP thread of the mote, i.e., a request is
+ *        recorded before it is handled
+ */
+#ifndef COAP_GROUP_PRIO
+#define COAP_GROUP_PRIO         (THREAD_PRIORITY_MAIN - 2)
+#endif
+
+/**
+ * @brief start the group thread, after joining the groups
+ *
+ * @return PID of the thread, negative on error
+ */
+int coap_group_init(void);
+
+/**
+ * @brief get the leisure period requested by a query
+ *
+ * @param[in] query query string, e.g., "?leisure=2000&x=y", or the value
+ *                  of a single Uri-Query option, need not be null terminated
+ * @param[in] len   length of query
+ *
+ * @return leisure in ms, at most COAP_LEISURE_MAX_MS, 0 if not requested
+ */
+uint32_t coap_leisure_from_query(const char *query, size_t len);
+
+/**
+ * @brief record a datagram if it is a request sent to a group
+ *
+ * Called by the group thread for every datagram to the CoAP port.
+ *
+ * @param[in] dgram     received datagram
+ */
+void coap_group_input(const coap_udp_dgram_t *dgram);
+
+/**
+ * @brief send the response to a group request after a random time within
+ *        the leisure period
+ *
+ * The request is found by message ID and token of the response, both are
+ * echoed by microcoap and gcoap.
+ *
+ * @param[in] rsp           response, copied
+ * @param[in] len           length of rsp
+ * @param[in] leisure_ms    leisure period in ms
+ *
+ * @return 0 if the response is deferred, the caller must not send it
+ * @return -1 if the caller has to send it now, e.g., for unicast requests
+ */
+int coap_group_defer(const uint8_t *rsp, size_t len, uint32_t leisure_ms);
+
+/**
+ * @brief send the deferred responses which are due
+ *
+ * Called by the group thread when its timer fires.
+ */
+void coap_group_flush(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* COAP_GROUP_H */
+/** @} */
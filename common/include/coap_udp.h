@@ -0,0 +1,113 @@
+/**
+ * @ingroup     climote
+ * @{
+ *
+ * @file
+ * @brief       Plain CoAP datagrams over GNRC UDP
+ *
+ * Threads register for datagrams to the CoAP port with gnrc_netreg and get
+ * them as GNRC_NETAPI_MSG_TYPE_RCV messages, other messages can wait in the
+ * same queue. Unlike sock or POSIX sockets the packet keeps its IPv6 header,
+ * i.e., group requests can be told from unicast ones. Every registered
+ * thread gets every datagram and must release it.
+ *
+ * Headers are built by hand, such that the same code works with the RIOT
+ * versions of all applications. The _port and _from variants serve other
+ * protocols on plain UDP the same way, e.g., SNTP of timesync.h.
+ *
+ * @author      smlng <s@mlng.net>
+ *
+ */
+
+#ifndef COAP_UDP_H
+#define COAP_UDP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "net/gnrc/netreg.h"
+#include "net/gnrc/pkt.h"
+#include "net/ipv6/addr.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define COAP_UDP_PORT       (5683U)     /**< default CoAP port */
+
+/**
+ * @brief a received datagram, data points into the packet
+ */
+typedef struct {
+    ipv6_addr_t src;                    /**< source address */
+    ipv6_addr_t dst;                    /**< destination, may be a group */
+    uint16_t port;                      /**< source port */
+    const uint8_t *data;                /**< UDP payload */
+    size_t len;                         /**< length of data */
+} coap_udp_dgram_t;
+
+/**
+ * @brief register a thread for datagrams to COAP_UDP_PORT
+ *
+ * @param[out] entry    netreg entry, must stay valid while registered
+ * @param[in] pid       thread to get the datagrams
+ *
+ * @return 0 on success, negative on error
+ */
+int coap_udp_register(gnrc_netreg_entry_t *entry, kernel_pid_t pid);
+
+/**
+ * @brief register a thread for datagrams to another port
+ *
+ * @param[out] entry    netreg entry, must stay valid while registered
+ * @param[in] port      local port
+ * @param[in] pid       thread to get the datagrams
+ *
+ * @return 0 on success, negative on error
+ */
+int coap_udp_register_port(gnrc_netreg_entry_t *entry, uint16_t port,
+                           kernel_pid_t pid);
+
+/**
+ * @brief get addresses and payload of a received packet
+ *
+ * @param[in] pkt       packet of a GNRC_NETAPI_MSG_TYPE_RCV message
+ * @param[out] dgram    datagram, valid until pkt is released
+ *
+ * @return 0 on success, -1 if pkt is no UDP over IPv6 datagram
+ */
+int coap_udp_read(gnrc_pktsnip_t *pkt, coap_udp_dgram_t *dgram);
+
+/**
+ * @brief send a datagram from COAP_UDP_PORT, from any thread
+ *
+ * @param[in] dst       destination address
+ * @param[in] port      destination port
+ * @param[in] data      UDP payload
+ * @param[in] len       length of data
+ *
+ * @return len on success, negative on error
+ */
+int coap_udp_send(const ipv6_addr_t *dst, uint16_t port,
+                  const void *data, size_t len);
+
+/**
+ * @brief send a datagram from another port, from any thread
+ *
+ * @param[in] src       source port
+ * @param[in] dst       destination address
+ * @param[in] port      destination port
+ * @param[in] data      UDP payload
+ * @param[in] len       length of data
+ *
+ * @return len on success, negative on error
+ */
+int coap_udp_send_from(uint16_t src, const ipv6_addr_t *dst, uint16_t port,
+                       const void *data, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* COAP_UDP_H */
+/** @} */
@@ -0,0 +1,145 @@
+/**
+ * @ingroup     climote
+ * @{
+ *
+ * @file
+ * @brief       CoAP over DTLS (coaps) with cached sessions
+ *
+ * Wraps a tinydtls server context with a pre-shared key. A collector does
+ * the handshake once and then keeps its session, every further request only
+ * costs the record protection, i.e., COAPS_RECORD_OVERHEAD bytes and one
+ * AES-CCM pass. Up to COAPS_SESSIONS sessions are kept, when another client
+ * connects the least recently used session is dropped.
+ *
+ * The transport is left to the application: it passes received datagrams to
+ * coaps_input() and sends on behalf of the DTLS layer with its send callback.
+ * Applications with sock_udp can just run coaps_run().
+ *
+ * @author      smlng <s@mlng.net>
+ *
+ */
+
+#ifndef COAPS_H
+#define COAPS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "net/ipv6/addr.h"
+#include "thread.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define COAPS_PORT              (5684U)
+
+/**
+ * @brief header (13), explicit nonce (8) and CCM-8 tag (8) per record
+ */
+#define COAPS_RECORD_OVERHEAD   (29U)
+
+/**
+ * @brief number of cached sessions, one less than tinydtls peers to leave
+ *        room for a handshake in progress
+ */
+#ifndef COAPS_SESSIONS
+#define COAPS_SESSIONS          (DTLS_PEER_MAX - 1)
+#endif
+
+/**
+ * @brief pre-shared key and its identity, there is no default
+ *
+ * Set COAPS_PSK_ID and COAPS_PSK_KEY when building. Only debug builds
+ * (PROFILE=debug) without them get COAPS_PSK_DEBUG, i.e., a key known to
+ * everybody reading this file, to try coaps on native.
+ */
+#ifdef COAPS_PSK_DEBUG
+#ifndef COAPS_PSK_ID
+#define COAPS_PSK_ID            "climote"
+#endif
+#ifndef COAPS_PSK_KEY
+#define COAPS_PSK_KEY           "climote-debug-only"
+#endif
+#endif
+
+/**
+ * @brief stack of the coaps server thread, tinydtls needs plenty
+ */
+#ifndef COAPS_THREAD_STACKSIZE
+#define COAPS_THREAD_STACKSIZE  (3 * THREAD_STACKSIZE_DEFAULT)
+#endif
+
+#ifndef COAPS_BUF_SIZE
+#define COAPS_BUF_SIZE          (256U)
+#endif
+
+/**
+ * @brief send a DTLS record to a peer
+ *
+ * @return number of bytes sent, negative on error
+ */
+typedef int (*coaps_send_t)(const ipv6_addr_t *addr, uint16_t port,
+                            const uint8_t *buf, size_t len);
+
+/**
+ * @brief handle a plaintext CoAP request in place
+ *
+ * @param[in,out] buf   request, overwritten with the response
+ * @param[in] len       length of request
+ * @param[in] max       size of buf
+ *
+ * @return length of response, <= 0 for no response
+ */
+typedef ssize_t (*coaps_handler_t)(uint8_t *buf, size_t len, size_t max);
+
+/**
+ * @brief coaps statistics
+ */
+typedef struct {
+    uint32_t handshakes;    /**< completed handshakes */
+    uint32_t requests;      /**< requests over established sessions */
+    uint32_t evicted;       /**< sessions dropped for new clients */
+    uint32_t alerts;        /**< fatal alerts, e.g., wrong key */
+} coaps_stats_t;
+
+/**
+ * @brief init DTLS context
+ *
+ * @param[in] send      send callback of the transport
+ * @param[in] handler   CoAP request handler
+ *
+ * @return 0 on success, negative on error
+ */
+int coaps_init(coaps_send_t send, coaps_handler_t handler);
+
+/**
+ * @brief process a datagram received on COAPS_PORT
+ *
+ * @param[in] addr      source address
+ * @param[in] port      source port
+ * @param[in] buf       datagram
+ * @param[in] len       length of datagram
+ */
+void coaps_input(const ipv6_addr_t *addr, uint16_t port,
+                 uint8_t *buf, size_t len);
+
+/**
+ * @brief run a coaps server on sock_udp, does not return
+ *
+ * @param[in] handler   CoAP request handler
+ */
+void coaps_run(coaps_handler_t handler);
+
+/**
+ * @brief get statistics
+ */
+const coaps_stats_t *coaps_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* COAPS_H */
+/** @} */
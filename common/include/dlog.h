@@ -0,0 +1,139 @@
+/**
+ * @ingroup     climote
+ * @{
+ *
+ * @file
+ * @brief       Deferred, rate limited logging
+ *
+ * DLOG_*() only stores the format string and up to four arguments in a ring
+ * buffer, a low priority thread does the printf() later. Request handlers,
+ * the sensor thread and interrupts thus never wait for the UART. Levels above
+ * LOG_LEVEL are compiled out, like LOG_*(). A line repeating the previous
+ * pending one, with the same format and arguments, is folded into it, lines
+ * beyond DLOG_RATE per second or with a full ring are dropped and counted.
+ *
+ * The format must be a string literal and arguments are stored as intptr_t,
+ * so only these conversions are supported:
+ *
+ * - `d i u x X o c` with flags, width and precision, `h` or `l` modifiers
+ * - `p`, and `s` for strings of static storage only
+ * - `%%`
+ *
+ * The compiler checks arguments against the format like for printf(). The
+ * log thread prints lines using any other conversion, e.g., `f`, `ll`, `z`
+ * or `*`, or more than four arguments as a warning with the bare format.
+ *
+ * @author      smlng <s@mlng.net>
+ *
+ */
+
+#ifndef DLOG_H
+#define DLOG_H
+
+#include <stdint.h>
+
+#include "log.h"
+#include "thread.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief number of pending lines, must be a power of 2
+ */
+#ifndef DLOG_RING_SIZE
+#define DLOG_RING_SIZE      (16U)
+#endif
+
+/**
+ * @brief sustained lines per second, a line takes ~5ms at 115200 baud
+ */
+#ifndef DLOG_RATE
+#define DLOG_RATE           (20U)
+#endif
+
+/**
+ * @brief lines accepted at once before DLOG_RATE applies
+ */
+#ifndef DLOG_BURST
+#define DLOG_BURST          (8U)
+#endif
+
+#ifndef DLOG_STACKSIZE
+#define DLOG_STACKSIZE      (THREAD_STACKSIZE_DEFAULT + \
+                             THREAD_EXTRA_STACKSIZE_PRINTF)
+#endif
+
+#ifndef DLOG_PRIO
+#define DLOG_PRIO           (THREAD_PRIORITY_IDLE - 1)
+#endif
+
+/**
+ * @brief log counters
+ */
+typedef struct {
+    uint32_t lines;     /**< lines queued */
+    uint32_t repeated;  /**< lines folded into the previous one */
+    uint32_t dropped;   /**< lines lost to the rate limit or a full ring */
+} dlog_stats_t;
+
+/**
+ * @brief queue a line, use DLOG() instead
+ */
+void dlog_put(const char *fmt, intptr_t a0, intptr_t a1, intptr_t a2,
+              intptr_t a3);
+
+/**
+ * @brief never called, lets the compiler check the arguments of DLOG()
+ */
+static inline __attribute__((format(printf, 1, 2)))
+void _dlog_check(const char *fmt, ...)
+{
+    (void)fmt;
+}
+
+/* pad missing arguments with 0, the last one keeps __VA_ARGS__ non-empty */
+#define _DLOG_PUT(fmt, a0, a1, a2, a3, ...) \
+    dlog_put(fmt, (intptr_t)(a0), (intptr_t)(a1), (intptr_t)(a2), \
+             (intptr_t)(a3))
+
+/**
+ * @brief log a line with format and up to four arguments at level
+ */
+#define DLOG(level, ...) do { \
+        if ((level) <= LOG_LEVEL) { \
+            if (0) { \
+                _dlog_check(__VA_ARGS__); \
+            } \
+            _DLOG_PUT(__VA_ARGS__, 0, 0, 0, 0, 0); \
+        } \
+    } while (0)
+
+#define DLOG_ERROR(...)     DLOG(LOG_ERROR, __VA_ARGS__)
+#define DLOG_WARNING(...)   DLOG(LOG_WARNING, __VA_ARGS__)
+#define DLOG_INFO(...)      DLOG(LOG_INFO, __VA_ARGS__)
+#define DLOG_DEBUG(...)     DLOG(LOG_DEBUG, __VA_ARGS__)
+
+/**
+ * @brief start the thread printing queued lines
+ *
+ * Lines queued before are kept and printed then.
+ *
+ * @return PID of the log thread, < 0 on error
+ */
+int dlog_init(void);
+
+/**
+ * @brief get log counters
+ *
+ * @param[out] stats    counters since boot
+ */
+void dlog_stats(dlog_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DLOG_H */
+/** @} */
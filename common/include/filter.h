@@ -0,0 +1,108 @@
+/**
+ * @ingroup     climote
+ * @{
+ *
+ * @file
+ * @brief       Integer filter chain for noisy sensor samples
+ *
+ * Every sample passes the enabled stages in this order: valid range check,
+ * spike rejection, windowed median and exponential moving average (EMA).
+ * All stages work incrementally in integer arithmetic, the cost per sample
+ * is constant and bounded by FILTER_MEDIAN_SIZE.
+ *
+ * @author      smlng <s@mlng.net>
+ *
+ */
+
+#ifndef FILTER_H
+#define FILTER_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief max window size of the median stage
+ */
+#ifndef FILTER_MEDIAN_SIZE
+#define FILTER_MEDIAN_SIZE      (7U)
+#endif
+
+/**
+ * @brief fractional bits of the EMA state
+ */
+#define FILTER_EMA_FRAC         (8U)
+
+/**
+ * @name filter stages
+ * @{
+ */
+#define FILTER_RANGE            (0x01)  /**< reject samples out of [min, max] */
+#define FILTER_CLAMP            (0x02)  /**< clamp samples to [min, max] */
+#define FILTER_SPIKE            (0x04)  /**< reject jumps larger than spike */
+#define FILTER_MEDIAN           (0x08)  /**< median of last samples */
+#define FILTER_EMA              (0x10)  /**< exponential moving average */
+/** @} */
+
+/**
+ * @brief filter configuration
+ */
+typedef struct {
+    uint8_t stages;         /**< enabled stages, see FILTER_* */
+    int32_t min;            /**< lower bound of valid samples */
+    int32_t max;            /**< upper bound of valid samples */
+    int32_t spike;          /**< max difference to last accepted sample */
+    uint8_t spike_max;      /**< accept after this many rejects in a row */
+    uint8_t median;         /**< median window size, odd */
+    uint8_t ema_shift;      /**< EMA weight of a new sample is 1/2^shift */
+} filter_cfg_t;
+
+/**
+ * @brief filter state
+ */
+typedef struct {
+    int32_t last;                           /**< last accepted sample */
+    int32_t win[FILTER_MEDIAN_SIZE];        /**< median window, by age */
+    int32_t sorted[FILTER_MEDIAN_SIZE];     /**< median window, sorted */
+    int32_t ema;                            /**< EMA, FILTER_EMA_FRAC bits */
+    uint32_t rejected;                      /**< count of rejected samples */
+    uint8_t pos;                            /**< oldest sample in win */
+    uint8_t fill;                           /**< samples in win */
+    uint8_t spikes;                         /**< rejected spikes in a row */
+    uint8_t init;                           /**< 1 after first sample */
+} filter_t;
+
+/**
+ * @name filter presets of the sensors shared by all applications
+ * @{
+ */
+extern const filter_cfg_t filter_temperature;   /**< in 0.01 C */
+extern const filter_cfg_t filter_humidity;      /**< in 0.01 % */
+/** @} */
+
+/**
+ * @brief reset filter state
+ *
+ * @param[out] f    filter state
+ */
+void filter_init(filter_t *f);
+
+/**
+ * @brief pass a sample through the filter chain
+ *
+ * @param[in]    f      filter state
+ * @param[in]    cfg    filter configuration
+ * @param[inout] val    raw sample in, filtered sample out
+ *
+ * @return 0 if accepted, 1 if rejected and val must be dropped
+ */
+int filter_apply(filter_t *f, const filter_cfg_t *cfg, int32_t *val);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FILTER_H */
+/** @} */
@@ -0,0 +1,94 @@
+/**
+ * @ingroup     climote
+ * @{
+ *
+ * @file
+ * @brief       Cached node info payload
+ *
+ * Address, EUI-64, firmware, application and sensor inventory are formatted
+ * once into a JSON object, requests only copy it and append the uptime, e.g.
+ *
+ *     {"addr":"fd17:cafe:cafe:2::1","eui64":"0a1b2c3d4e5f6071",
+ *      "fw":"2018.01","app":"monica-demo","sensors":"temperature,humidity",
+ *      "up":3600}
+ *
+ * At most every NODE_INFO_REFRESH a request reads the current address, which
+ * is cheap, and the payload is rebuilt only if it differs from the cached one,
+ * e.g., the node got or changed its global address. node_info_invalidate()
+ * forces a rebuild with the next request.
+ *
+ * @author      smlng <s@mlng.net>
+ *
+ */
+
+#ifndef NODE_INFO_H
+#define NODE_INFO_H
+
+#include <stddef.h>
+
+#include "thread.h"
+#include "xtimer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief max length of the payload, including the uptime
+ */
+#ifndef NODE_INFO_LEN
+#define NODE_INFO_LEN       (192U)
+#endif
+
+/**
+ * @brief interval to compare the cached address with the current one
+ */
+#ifndef NODE_INFO_REFRESH
+#define NODE_INFO_REFRESH   (5U * US_PER_SEC)
+#endif
+
+/**
+ * @brief get the address to report, the GNRC API differs per application
+ *
+ * @param[out] buf  buffer for the address string
+ * @param[in] len   size of buf
+ *
+ * @return length of the address, 0 if there is no global address
+ */
+typedef size_t (*node_info_addr_t)(char *buf, size_t len);
+
+/**
+ * @brief set the interface and address getter, the payload is built lazily
+ *
+ * @param[in] iface     interface to read the EUI-64 from
+ * @param[in] addr      address getter
+ */
+void node_info_init(kernel_pid_t iface, node_info_addr_t addr);
+
+/**
+ * @brief rebuild the payload with the next request
+ */
+void node_info_invalidate(void);
+
+/**
+ * @brief shell command rebuilding and printing the payload, e.g., after the
+ *        addresses were changed with ifconfig
+ */
+int node_info_cmd(int argc, char **argv);
+
+/**
+ * @brief get the node info payload
+ *
+ * @param[out] buf  buffer for the payload, null terminated
+ * @param[in] max   size of buf
+ *
+ * @return length of the payload, 0 if it does not fit into buf
+ */
+size_t node_info_get(char *buf, size_t max);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NODE_INFO_H */
+/** @} */
@@ -0,0 +1,255 @@
+/**
+ * @ingroup     climote
+ * @{
+ *
+ * @file
+ * @brief       Table driven sensor registry
+ *
+ * Applications describe their sensors in a constant table, the registry does
+ * the periodic sampling, averaging and formatting for all of them. Averages
+ * are published as one consistent snapshot, readers never block on a sensor.
+ *
+ * Sensors with an adaption config sample faster while their value changes
+ * quickly and slower while it is stable. The change per sample is tracked
+ * as a moving average of absolute differences. Above the threshold the
+ * period is halved at once, below a quarter of it the period grows by a
+ * quarter per sample, always within [min, max]. The gap between both bounds
+ * keeps a steady slope from toggling the period.
+ *
+ * @author      smlng <s@mlng.net>
+ *
+ */
+
+#ifndef SENSOR_REG_H
+#define SENSOR_REG_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "filter.h"
+#include "thread.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief max number of sensors in a table
+ */
+#ifndef SENSOR_REG_NUMOF
+#define SENSOR_REG_NUMOF        (4U)
+#endif
+
+/**
+ * @brief max number of samples averaged per sensor
+ */
+#ifndef SENSOR_REG_RING_SIZE
+#define SENSOR_REG_RING_SIZE    (16U)
+#endif
+
+/**
+ * @brief weight of a new difference in the change average is 1/2^shift
+ */
+#ifndef SENSOR_REG_ADAPT_SHIFT
+#define SENSOR_REG_ADAPT_SHIFT  (2U)
+#endif
+
+/**
+ * @brief longest sampling period in ms, the timer counts us in 32 bit
+ */
+#define SENSOR_REG_PERIOD_MAX   (UINT32_MAX / 1000U)
+
+#ifndef SENSOR_REG_STACKSIZE
+#define SENSOR_REG_STACKSIZE    (2 * THREAD_STACKSIZE_DEFAULT)
+#endif
+
+#ifndef SENSOR_REG_PRIO
+#define SENSOR_REG_PRIO         (THREAD_PRIORITY_MAIN - 1)
+#endif
+
+/**
+ * @brief adaptive sampling configuration
+ */
+typedef struct {
+    uint32_t min;               /**< shortest sampling period in ms */
+    uint32_t max;               /**< longest sampling period in ms */
+    int32_t threshold;          /**< mean change per sample, in value units,
+                                     above which the period is shortened */
+} sensor_adapt_t;
+
+/**
+ * @brief sensor description
+ */
+typedef struct {
+    const char *name;           /**< resource name, e.g. "temperature" */
+    const char *unit;           /**< unit of the value, e.g. "C" */
+    int (*init)(void);          /**< init the device, 0 on success, optional */
+    int (*read)(int32_t *val);  /**< read one sample, 0 on success */
+    uint16_t factor;            /**< value = physical value * factor */
+    uint32_t period;            /**< (initial) sampling period in ms */
+    uint8_t samples;            /**< number of samples to average */
+    const filter_cfg_t *filter; /**< filter applied to samples, optional */
+    const sensor_adapt_t *adapt;/**< adaptive sampling, optional */
+} sensor_reg_t;
+
+/**
+ * @brief sampling counters of a sensor
+ */
+typedef struct {
+    uint32_t samples;           /**< samples read */
+    uint32_t rejected;          /**< samples rejected by the filter */
+    uint32_t faster;            /**< times the period was shortened */
+    uint32_t slower;            /**< times the period was extended */
+    uint32_t period;            /**< current sampling period in ms */
+} sensor_reg_stats_t;
+
+/**
+ * @brief consistent averages of all sensors
+ */
+typedef struct {
+    uint32_t gen;                       /**< incremented whenever a value
+                                             changes, never 0 after init */
+    uint32_t time;                      /**< time of the last change, unix
+                                             seconds, 0 if not synchronized */
+    int32_t value[SENSOR_REG_NUMOF];    /**< averages in table order */
+} sensor_reg_snapshot_t;
+
+/**
+ * @brief init all sensors and start periodic sampling
+ *
+ * @param[in] sensors   sensor table, must stay valid
+ * @param[in] numof     number of sensors in table
+ *
+ * @return PID of the sensor thread, negative on error
+ */
+int sensor_reg_init(const sensor_reg_t *sensors, unsigned numof);
+
+/**
+ * @brief init all sensors without starting the sensor thread
+ *
+ * Sampling is then driven by the caller through sensor_reg_tick(), e.g., from
+ * an event loop shared with other periodic tasks.
+ *
+ * @param[in] sensors   sensor table, must stay valid
+ * @param[in] numof     number of sensors in table
+ *
+ * @return 0 on success, negative on error
+ */
+int sensor_reg_setup(const sensor_reg_t *sensors, unsigned numof);
+
+/**
+ * @brief sample all sensors that are due and publish new averages
+ *
+ * @return time until the next sensor is due in us
+ */
+uint32_t sensor_reg_tick(void);
+
+/**
+ * @brief get number of registered sensors
+ */
+unsigned sensor_reg_numof(void);
+
+/**
+ * @brief get sensor description
+ *
+ * @param[in] idx   index in sensor table
+ *
+ * @return sensor description, NULL if idx is invalid
+ */
+const sensor_reg_t *sensor_reg_get(unsigned idx);
+
+/**
+ * @brief change the sampling period of a sensor
+ *
+ * Call from the thread driving sensor_reg_tick(), the sensor is sampled next
+ * one period from now. Call sensor_reg_tick() again to get the new wait time.
+ * A fixed period suspends adaptive sampling until it is reset with 0. It is
+ * clamped to the adaptive range of the sensor, if any, and to
+ * SENSOR_REG_PERIOD_MAX.
+ *
+ * @param[in] idx       index in sensor table
+ * @param[in] period    period in ms, 0 for the period of the table
+ */
+void sensor_reg_set_period(unsigned idx, uint32_t period);
+
+/**
+ * @brief get the current sampling period of a sensor
+ *
+ * @param[in] idx   index in sensor table
+ *
+ * @return period in ms
+ */
+uint32_t sensor_reg_period(unsigned idx);
+
+/**
+ * @brief get sampling counters of a sensor
+ *
+ * @param[in]  idx      index in sensor table
+ * @param[out] stats    counters since init
+ */
+void sensor_reg_stats(unsigned idx, sensor_reg_stats_t *stats);
+
+/**
+ * @brief shell command printing the sampling counters of all sensors
+ */
+int sensor_reg_cmd(int argc, char **argv);
+
+/**
+ * @brief find sensor by name
+ *
+ * @param[in] name  name, need not be null terminated
+ * @param[in] len   length of name
+ *
+ * @return index of sensor, -1 if not found
+ */
+int sensor_reg_find(const char *name, size_t len);
+
+/**
+ * @brief get consistent averages of all sensors
+ *
+ * @param[out] snap averages
+ */
+void sensor_reg_snapshot(sensor_reg_snapshot_t *snap);
+
+/**
+ * @brief get average of a single sensor
+ *
+ * @param[in] idx   index in sensor table
+ *
+ * @return average
+ */
+int32_t sensor_reg_value(unsigned idx);
+
+/**
+ * @brief format value of a sensor as decimal, e.g., 2150 -> "21.50"
+ *
+ * @param[in]  idx      index in sensor table
+ * @param[in]  value    value to format
+ * @param[out] buf      output buffer
+ * @param[in]  len      size of buf
+ *
+ * @return length of string in buf
+ */
+size_t sensor_reg_fmt(unsigned idx, int32_t value, char *buf, size_t len);
+
+/**
+ * @brief format snapshot as JSON like object, e.g.,
+ *        "{'temperature': 2150, 'humidity': 4500, 'time': 1517400000}"
+ *
+ * The time is the one of the last change of the averages, see
+ * sensor_reg_snapshot_t, it is left out while the node is not synchronized.
+ *
+ * @param[in]  snap     averages to format
+ * @param[out] buf      output buffer
+ * @param[in]  len      size of buf
+ *
+ * @return length of string in buf
+ */
+size_t sensor_reg_json(const sensor_reg_snapshot_t *snap, char *buf, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SENSOR_REG_H */
+/** @} */
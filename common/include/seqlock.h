@@ -0,0 +1,106 @@
+/**
+ * @ingroup     climote
+ * @{
+ *
+ * @file
+ * @brief       Sequence counter for single writer, lock-free snapshots
+ *
+ * The writer makes the counter odd while it updates the protected data and
+ * even again afterwards, readers copy the data and retry if the counter was
+ * odd or changed meanwhile. Readers never block the writer and vice versa.
+ *
+ * On a single core a reader can only observe an odd counter if it preempted
+ * the writer, so writers with lower priority than their readers must keep
+ * the update short and interrupts disabled, see seqlock_write_begin().
+ *
+ * @author      smlng <s@mlng.net>
+ *
+ */
+
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <stdint.h>
+
+#include "irq.h"
+#include "thread.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief sequence counter
+ */
+typedef struct {
+    uint32_t seq;       /**< odd while an update is in progress */
+} seqlock_t;
+
+/**
+ * @brief static initializer
+ */
+#define SEQLOCK_INIT    { 0 }
+
+/**
+ * @brief start an update, data must not be written before
+ *
+ * @param[in] sl    sequence counter
+ *
+ * @return irq state to pass to seqlock_write_end()
+ */
+static inline unsigned seqlock_write_begin(seqlock_t *sl)
+{
+    unsigned state = irq_disable();
+    __atomic_store_n(&sl->seq, sl->seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    return state;
+}
+
+/**
+ * @brief finish an update, data must not be written afterwards
+ *
+ * @param[in] sl    sequence counter
+ * @param[in] state irq state returned by seqlock_write_begin()
+ */
+static inline void seqlock_write_end(seqlock_t *sl, unsigned state)
+{
+    __atomic_store_n(&sl->seq, sl->seq + 1, __ATOMIC_RELEASE);
+    irq_restore(state);
+}
+
+/**
+ * @brief start reading, waits until no update is in progress
+ *
+ * @param[in] sl    sequence counter
+ *
+ * @return sequence to pass to seqlock_read_retry()
+ */
+static inline uint32_t seqlock_read_begin(const seqlock_t *sl)
+{
+    uint32_t seq;
+    while ((seq = __atomic_load_n(&sl->seq, __ATOMIC_ACQUIRE)) & 1) {
+        thread_yield();
+    }
+    return seq;
+}
+
+/**
+ * @brief check if data read since seqlock_read_begin() is consistent
+ *
+ * @param[in] sl    sequence counter
+ * @param[in] seq   sequence returned by seqlock_read_begin()
+ *
+ * @return 0 if consistent, 1 if the read has to be repeated
+ */
+static inline int seqlock_read_retry(const seqlock_t *sl, uint32_t seq)
+{
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return (__atomic_load_n(&sl->seq, __ATOMIC_RELAXED) != seq);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SEQLOCK_H */
+/** @} */
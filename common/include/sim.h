@@ -0,0 +1,73 @@
+/**
+ * @ingroup     climote
+ * @{
+ *
+ * @file
+ * @brief       Deterministic synthetic sensor data for simulated nodes
+ *
+ * Used instead of real sensor drivers on boards without them, e.g., native.
+ * Every node derives its own phase and noise sequence from SIM_SEED and its
+ * CPU ID, so a fleet started with the same seeds produces the same data.
+ *
+ * @author      smlng <s@mlng.net>
+ *
+ */
+
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef SIM_SEED
+#define SIM_SEED            (0x2409U)
+#endif
+
+/**
+ * @brief synthetic waveform, a sine with superimposed noise
+ */
+typedef struct {
+    int16_t offset;     /**< mean value */
+    int16_t amplitude;  /**< amplitude of the sine */
+    uint16_t noise;     /**< max deviation of the uniform noise */
+    uint32_t period;    /**< period of the sine in seconds */
+} sim_wave_t;
+
+/**
+ * @brief simulated temperature in Celsius (C) with factor 100
+ */
+#define SIM_WAVE_TEMPERATURE    { 2150, 350, 20, 600 }
+
+/**
+ * @brief simulated humidity in percent (%) with factor 100
+ */
+#define SIM_WAVE_HUMIDITY       { 4500, 1200, 50, 900 }
+
+/**
+ * @brief simulated raw MQ135 ADC value
+ */
+#define SIM_WAVE_AIRQUALITY     { 20000, 6000, 400, 1800 }
+
+/**
+ * @brief seed the simulation from SIM_SEED and the CPU ID of the node
+ */
+void sim_init(void);
+
+/**
+ * @brief get current value of a waveform
+ *
+ * @param[in] wave  waveform parameters
+ *
+ * @return simulated sample
+ */
+int16_t sim_sample(const sim_wave_t *wave);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SIM_H */
+/** @} */
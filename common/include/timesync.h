@@ -0,0 +1,133 @@
+/**
+ * @ingroup     climote
+ * @{
+ *
+ * @file
+ * @brief       Wall clock time synchronized via SNTP
+ *
+ * A low priority thread asks the SNTP server, typically the border router,
+ * for the time every TIMESYNC_INTERVAL and every TIMESYNC_RETRY until the
+ * first answer. In between the time is extrapolated with xtimer. Without a
+ * local NTP daemon use ctrl/sntpd.py.
+ *
+ * The thread uses GNRC UDP directly, see coap_udp.h, i.e., it needs no sock
+ * and also runs on the mote.
+ *
+ * @author      smlng <s@mlng.net>
+ *
+ */
+
+#ifndef TIMESYNC_H
+#define TIMESYNC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "thread.h"
+#include "xtimer.h"
+
+#include "coap_udp.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief address of the SNTP server
+ */
+#ifndef TIMESYNC_SERVER
+#define TIMESYNC_SERVER     "fd17:cafe:cafe:2::1"
+#endif
+
+#ifndef TIMESYNC_PORT
+#define TIMESYNC_PORT       (123U)
+#endif
+
+/**
+ * @brief local port the answers are sent to
+ */
+#ifndef TIMESYNC_LOCAL_PORT
+#define TIMESYNC_LOCAL_PORT (123U)
+#endif
+
+/**
+ * @brief interval between synchronizations, xtimer drifts some ppm
+ */
+#ifndef TIMESYNC_INTERVAL
+#define TIMESYNC_INTERVAL   (3600U * US_PER_SEC)
+#endif
+
+/**
+ * @brief interval between tries while not synchronized
+ */
+#ifndef TIMESYNC_RETRY
+#define TIMESYNC_RETRY      (10U * US_PER_SEC)
+#endif
+
+/**
+ * @brief time to wait for an answer
+ */
+#ifndef TIMESYNC_TIMEOUT
+#define TIMESYNC_TIMEOUT    (1U * US_PER_SEC)
+#endif
+
+#ifndef TIMESYNC_STACKSIZE
+#define TIMESYNC_STACKSIZE  (THREAD_STACKSIZE_DEFAULT)
+#endif
+
+#ifndef TIMESYNC_PRIO
+#define TIMESYNC_PRIO       (THREAD_PRIORITY_MAIN + 1)
+#endif
+
+/**
+ * @brief length of a formatted time, e.g., "2018-01-31T12:00:00Z"
+ */
+#define TIMESYNC_STR_LEN    (sizeof("2018-01-31T12:00:00Z"))
+
+/**
+ * @brief start the synchronization thread
+ *
+ * @return PID of the thread, < 0 on error
+ */
+int timesync_init(void);
+
+/**
+ * @brief send a request to TIMESYNC_SERVER, called by the thread
+ *
+ * @return 0 on success, -1 on error
+ */
+int timesync_request(void);
+
+/**
+ * @brief handle a datagram to TIMESYNC_LOCAL_PORT, called by the thread
+ *
+ * @param[in] dgram     the datagram
+ *
+ * @return 0 if it answered the pending request, -1 otherwise
+ */
+int timesync_input(const coap_udp_dgram_t *dgram);
+
+/**
+ * @brief get the current time
+ *
+ * @return seconds since 1970-01-01 UTC, 0 if not synchronized yet
+ */
+uint32_t timesync_now(void);
+
+/**
+ * @brief format a time as ISO 8601 in UTC, e.g., "2018-01-31T12:00:00Z"
+ *
+ * @param[in]  time     seconds since 1970-01-01 UTC
+ * @param[out] buf      output buffer, at least TIMESYNC_STR_LEN
+ * @param[in]  len      size of buf
+ *
+ * @return length of string in buf, 0 if buf is too small
+ */
+size_t timesync_fmt(uint32_t time, char *buf, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TIMESYNC_H */
+/** @} */
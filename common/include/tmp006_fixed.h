@@ -0,0 +1,49 @@
+/**
+ * @ingroup     climote
+ * @{
+ *
+ * @file
+ * @brief       Integer only TMP006 temperature conversion
+ *
+ * Fixed point replacement for tmp006_convert(), which needs float and pow()
+ * and thus soft-float on Cortex-M0+. Results are in Celsius (C) * 100 and
+ * within 0.02 C of the float reference for object temperatures up to 200 C.
+ *
+ * @author      smlng <s@mlng.net>
+ *
+ */
+
+#ifndef TMP006_FIXED_H
+#define TMP006_FIXED_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief convert raw die temperature register to ambient temperature
+ *
+ * @param[in] rawt  raw die temperature as read from the TMP006
+ *
+ * @return ambient temperature in Celsius (C) * 100
+ */
+int32_t tmp006_fixed_ambient(int16_t rawt);
+
+/**
+ * @brief convert raw sensor voltage and die temperature to object temperature
+ *
+ * @param[in] rawv  raw sensor voltage as read from the TMP006
+ * @param[in] rawt  raw die temperature as read from the TMP006
+ *
+ * @return object temperature in Celsius (C) * 100
+ */
+int32_t tmp006_fixed_object(int16_t rawv, int16_t rawt);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TMP006_FIXED_H */
+/** @} */
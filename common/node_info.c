@@ -0,0 +1,157 @@
+/**
+ * @ingroup     climote
+ * @{
+ *
+ * @file
+ * @brief       Implements the cached node info payload
+ *
+ * @author      smlng <s@mlng.net>
+ *
+ * @}
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "log.h"
+#include "mutex.h"
+#include "net/gnrc/netapi.h"
+#include "net/ipv6/addr.h"
+
+#include "node_info.h"
+#include "sensor_reg.h"
+
+#ifndef RIOT_VERSION
+#define RIOT_VERSION        "unknown"
+#endif
+
+#ifndef RIOT_APPLICATION
+#define RIOT_APPLICATION    "unknown"
+#endif
+
+#define EUI64_LEN           (8U)
+/* room kept for the uptime appended per request */
+#define UP_FMT              ",\"up\":%lu}"
+#define UP_LEN              (sizeof(",\"up\":4294967295}") - 1)
+
+static mutex_t lock = MUTEX_INIT;
+static kernel_pid_t info_iface = KERNEL_PID_UNDEF;
+static node_info_addr_t info_addr;
+static char info[NODE_INFO_LEN - UP_LEN];
+static size_t info_len;
+static int info_valid;
+static char info_addr_str[IPV6_ADDR_MAX_STR_LEN];   /**< address in info */
+static size_t info_addr_len;
+static uint32_t info_checked;
+
+/**
+ * @brief append a string, fails if it does not fit
+ */
+static int _append(size_t *pos, const char *str, size_t len)
+{
+    if ((*pos + len) > sizeof(info)) {
+        return -1;
+    }
+    memcpy(info + *pos, str, len);
+    *pos += len;
+    return 0;
+}
+
+/**
+ * @brief format everything but the uptime with addr, call with lock held
+ */
+static void _build(const char *addr, size_t addr_len)
+{
+    char eui[2 * EUI64_LEN + 1] = "";
+    uint8_t raw[EUI64_LEN];
+
+    if ((info_iface != KERNEL_PID_UNDEF) &&
+        (gnrc_netapi_get(info_iface, NETOPT_ADDRESS_LONG, 0,
+                         raw, sizeof(raw)) == (int)sizeof(raw))) {
+        for (unsigned i = 0; i < EUI64_LEN; i++) {
+            snprintf(&eui[2 * i], 3, "%02x", raw[i]);
+        }
+    }
+    memcpy(info_addr_str, addr, addr_len);
+    info_addr_len = addr_len;
+    info_valid = 1;
+
+    int res = snprintf(info, sizeof(info), "{\"addr\":\"%.*s\",\"eui64\":\"%s\","
+                       "\"fw\":\"%s\",\"app\":\"%s\",\"sensors\":\"",
+                       (int)addr_len, addr, eui, RIOT_VERSION, RIOT_APPLICATION);
+    if ((res < 0) || ((size_t)res >= sizeof(info))) {
+        LOG_WARNING("[INFO] payload exceeds NODE_INFO_LEN\n");
+        info_len = 0;
+        return;
+    }
+    size_t pos = res;
+    /* list as many sensors as fit, keep one byte for the closing quote */
+    for (unsigned i = 0; i < sensor_reg_numof(); i++) {
+        const char *name = sensor_reg_get(i)->name;
+        size_t mark = pos;
+        if (((i > 0) && (_append(&pos, ",", 1) < 0)) ||
+            (_append(&pos, name, strlen(name)) < 0) ||
+            (pos == sizeof(info))) {
+            pos = mark;
+            break;
+        }
+    }
+    info[pos++] = '"';
+    info_len = pos;
+}
+
+void node_info_init(kernel_pid_t iface, node_info_addr_t addr)
+{
+    mutex_lock(&lock);
+    info_iface = iface;
+    info_addr = addr;
+    info_valid = 0;
+    mutex_unlock(&lock);
+}
+
+void node_info_invalidate(void)
+{
+    mutex_lock(&lock);
+    info_valid = 0;
+    mutex_unlock(&lock);
+}
+
+size_t node_info_get(char *buf, size_t max)
+{
+    mutex_lock(&lock);
+    uint32_t now = xtimer_now_usec();
+    if (!info_valid || ((now - info_checked) >= NODE_INFO_REFRESH)) {
+        char addr[IPV6_ADDR_MAX_STR_LEN];
+        size_t addr_len = info_addr ? info_addr(addr, sizeof(addr)) : 0;
+        info_checked = now;
+        if (!info_valid || (addr_len != info_addr_len) ||
+            (memcmp(addr, info_addr_str, addr_len) != 0)) {
+            _build(addr, addr_len);
+        }
+    }
+    size_t len = 0;
+    if ((info_len > 0) && (max > info_len)) {
+        memcpy(buf, info, info_len);
+        unsigned long up = (unsigned long)(xtimer_now_usec64() / US_PER_SEC);
+        int res = snprintf(buf + info_len, max - info_len, UP_FMT, up);
+        if ((res > 0) && ((size_t)res < (max - info_len))) {
+            len = info_len + res;
+        }
+    }
+    mutex_unlock(&lock);
+    return len;
+}
+
+int node_info_cmd(int argc, char **argv)
+{
+    (void) argc;
+    (void) argv;
+    char buf[NODE_INFO_LEN];
+    node_info_invalidate();
+    if (node_info_get(buf, sizeof(buf)) == 0) {
+        puts("no node info");
+        return 1;
+    }
+    puts(buf);
+    return 0;
+}
@@ -0,0 +1,363 @@
+/**
+ * @ingroup     climote
+ * @{
+ *
+ * @file
+ * @brief       Implements the sensor registry
+ *
+ * @author      smlng <s@mlng.net>
+ *
+ * @}
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "log.h"
+#include "seqlock.h"
+#include "thread.h"
+#include "xtimer.h"
+
+#include "dlog.h"
+#include "sensor_reg.h"
+#include "timesync.h"
+
+/**
+ * @brief sampling state of a sensor, only accessed by the sensor thread
+ */
+typedef struct {
+    int32_t ring[SENSOR_REG_RING_SIZE]; /**< last samples */
+    int32_t sum;                        /**< sum of all samples in ring */
+    filter_t filter;                    /**< state of the filter chain */
+    uint8_t pos;                        /**< next position in ring */
+    uint32_t next;                      /**< time of next sample in us */
+    uint32_t period;                    /**< sampling period in ms */
+    int32_t prev;                       /**< previous accepted sample */
+    int32_t change;                     /**< average change per sample, 4
+                                             fractional bits */
+    uint8_t fixed;                      /**< 1 if period was set explicitly */
+    sensor_reg_stats_t stats;           /**< counters, period is unused */
+} sensor_state_t;
+
+static const sensor_reg_t *table = NULL;
+static unsigned table_numof = 0;
+static sensor_state_t state[SENSOR_REG_NUMOF];
+
+static uint64_t start;                  /**< time of init in us */
+
+static sensor_reg_snapshot_t snapshot;
+static seqlock_t snapshot_lock = SEQLOCK_INIT;
+
+static char sensor_thread_stack[SENSOR_REG_STACKSIZE];
+
+unsigned sensor_reg_numof(void)
+{
+    return table_numof;
+}
+
+const sensor_reg_t *sensor_reg_get(unsigned idx)
+{
+    return (idx < table_numof) ? &table[idx] : NULL;
+}
+
+void sensor_reg_set_period(unsigned idx, uint32_t period)
+{
+    assert(idx < table_numof);
+    const sensor_adapt_t *cfg = table[idx].adapt;
+    if ((period > 0) && cfg) {
+        period = (period < cfg->min) ? cfg->min :
+                 (period > cfg->max) ? cfg->max : period;
+    }
+    if (period > SENSOR_REG_PERIOD_MAX) {
+        period = SENSOR_REG_PERIOD_MAX;
+    }
+    state[idx].period = (period > 0) ? period : table[idx].period;
+    state[idx].fixed = (period > 0);
+    state[idx].next = xtimer_now_usec() + state[idx].period * US_PER_MS;
+}
+
+uint32_t sensor_reg_period(unsigned idx)
+{
+    assert(idx < table_numof);
+    return state[idx].period;
+}
+
+void sensor_reg_stats(unsigned idx, sensor_reg_stats_t *stats)
+{
+    assert(idx < table_numof);
+    /* written by the sensor thread only, single counters may be one off */
+    *stats = state[idx].stats;
+    stats->rejected = state[idx].filter.rejected;
+    stats->period = state[idx].period;
+}
+
+int sensor_reg_cmd(int argc, char **argv)
+{
+    (void) argc;
+    (void) argv;
+    uint32_t elapsed = (uint32_t)((xtimer_now_usec64() - start) / US_PER_MS);
+    printf("%-12s %7s %8s %8s %6s %6s %6s\n", "sensor", "period", "samples",
+           "rejected", "faster", "slower", "saved");
+    for (unsigned i = 0; i < table_numof; i++) {
+        sensor_reg_stats_t s;
+        sensor_reg_stats(i, &s);
+        /* samples saved compared to sampling at the table period */
+        uint32_t fixed = elapsed / table[i].period;
+        int saved = (fixed > 0) ? (int)(100 - (100ULL * s.samples) / fixed) : 0;
+        printf("%-12s %7lu %8lu %8lu %6lu %6lu %5d%%\n", table[i].name,
+               (unsigned long)s.period, (unsigned long)s.samples,
+               (unsigned long)s.rejected, (unsigned long)s.faster,
+               (unsigned long)s.slower, saved);
+    }
+    return 0;
+}
+
+int sensor_reg_find(const char *name, size_t len)
+{
+    for (unsigned i = 0; i < table_numof; i++) {
+        /* name comes from a packet, it may contain '\0' */
+        if ((strlen(table[i].name) == len) &&
+            (memcmp(table[i].name, name, len) == 0)) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+void sensor_reg_snapshot(sensor_reg_snapshot_t *snap)
+{
+    uint32_t seq;
+    do {
+        seq = seqlock_read_begin(&snapshot_lock);
+        *snap = snapshot;
+    } while (seqlock_read_retry(&snapshot_lock, seq));
+}
+
+int32_t sensor_reg_value(unsigned idx)
+{
+    sensor_reg_snapshot_t snap;
+    sensor_reg_snapshot(&snap);
+    return (idx < table_numof) ? snap.value[idx] : 0;
+}
+
+static size_t _clamp(int res, size_t len)
+{
+    if ((res < 0) || (len == 0)) {
+        return 0;
+    }
+    return ((size_t)res < len) ? (size_t)res : len - 1;
+}
+
+size_t sensor_reg_fmt(unsigned idx, int32_t value, char *buf, size_t len)
+{
+    assert(idx < table_numof);
+    uint16_t factor = table[idx].factor;
+    if (factor <= 1) {
+        return _clamp(snprintf(buf, len, "%ld", (long)value), len);
+    }
+    int digits = 0;
+    for (unsigned f = factor; f > 1; f /= 10) {
+        digits++;
+    }
+    unsigned long v = labs((long)value);
+    return _clamp(snprintf(buf, len, "%s%lu.%0*lu", (value < 0) ? "-" : "",
+                           v / factor, digits, v % factor), len);
+}
+
+size_t sensor_reg_json(const sensor_reg_snapshot_t *snap, char *buf, size_t len)
+{
+    size_t pos = _clamp(snprintf(buf, len, "{"), len);
+    for (unsigned i = 0; i < table_numof; i++) {
+        pos += _clamp(snprintf(buf + pos, len - pos, "%s'%s': %ld",
+                               (i > 0) ? ", " : "", table[i].name,
+                               (long)snap->value[i]), len - pos);
+    }
+    if (snap->time) {
+        pos += _clamp(snprintf(buf + pos, len - pos, ", 'time': %lu",
+                               (unsigned long)snap->time), len - pos);
+    }
+    pos += _clamp(snprintf(buf + pos, len - pos, "}"), len - pos);
+    return pos;
+}
+
+/**
+ * @brief adapt the sampling period to the change per sample
+ */
+static void _adapt(unsigned idx, int32_t val)
+{
+    const sensor_adapt_t *cfg = table[idx].adapt;
+    sensor_state_t *s = &state[idx];
+    int32_t diff = val - s->prev;
+    s->prev = val;
+    /* 4 fractional bits, small steady changes must add up */
+    diff = ((diff < 0) ? -diff : diff) << 4;
+    s->change += (diff - s->change) / (1 << SENSOR_REG_ADAPT_SHIFT);
+    if (s->fixed) {
+        return;
+    }
+    uint32_t period = s->period;
+    if (s->change > (cfg->threshold << 4)) {
+        period = (period / 2 > cfg->min) ? period / 2 : cfg->min;
+    }
+    else if (s->change < (cfg->threshold << 2)) {
+        period = (period + period / 4 < cfg->max) ? period + period / 4 : cfg->max;
+    }
+    if (period < s->period) {
+        s->stats.faster++;
+        DLOG_DEBUG("[SENSOR] %s: period %lu ms\n", table[idx].name,
+                   (unsigned long)period);
+    }
+    else if (period > s->period) {
+        s->stats.slower++;
+    }
+    s->period = period;
+}
+
+/**
+ * @brief take one sample of a sensor and update its running sum
+ *
+ * @return 1 if the ring wrapped around, 0 otherwise
+ */
+static int _sample(unsigned idx)
+{
+    sensor_state_t *s = &state[idx];
+    int32_t val;
+    s->stats.samples++;
+    if (table[idx].read(&val) != 0) {
+        DLOG_ERROR("[SENSOR] %s: read failed\n", table[idx].name);
+        return 0;
+    }
+    if (table[idx].filter && filter_apply(&s->filter, table[idx].filter, &val)) {
+        DLOG_DEBUG("[SENSOR] %s: rejected %ld\n", table[idx].name, (long)val);
+        return 0;
+    }
+    if (table[idx].adapt) {
+        _adapt(idx, val);
+    }
+    s->sum += val - s->ring[s->pos];
+    s->ring[s->pos] = val;
+    s->pos = (s->pos + 1) % table[idx].samples;
+    return (s->pos == 0);
+}
+
+/**
+ * @brief publish averages of all sensors
+ */
+static void _publish(void)
+{
+    int32_t avg[SENSOR_REG_NUMOF];
+    for (unsigned i = 0; i < table_numof; i++) {
+        avg[i] = state[i].sum / (int32_t)table[i].samples;
+    }
+    /* only the sensor thread writes, it may read without the lock. The
+     * generation doubles as CoAP ETag, it must change only with the values,
+     * or once with the time on the first synchronization */
+    uint32_t time = timesync_now();
+    int changed = (snapshot.gen == 0) ||
+        (memcmp(snapshot.value, avg, table_numof * sizeof(avg[0])) != 0) ||
+        ((snapshot.time == 0) && (time != 0));
+    if (!changed) {
+        return;
+    }
+    unsigned irq = seqlock_write_begin(&snapshot_lock);
+    snapshot.gen++;
+    snapshot.time = time;
+    memcpy(snapshot.value, avg, sizeof(avg));
+    seqlock_write_end(&snapshot_lock, irq);
+}
+
+uint32_t sensor_reg_tick(void)
+{
+    uint32_t now = xtimer_now_usec();
+    uint32_t sleep = UINT32_MAX;
+    int sampled = 0;
+    for (unsigned i = 0; i < table_numof; i++) {
+        sensor_state_t *s = &state[i];
+        if ((int32_t)(s->next - now) <= 0) {
+            if (_sample(i)) {
+                DLOG_INFO("[SENSOR] %s: %ld\n", table[i].name,
+                          (long)(s->sum / (int32_t)table[i].samples));
+            }
+            s->next += s->period * US_PER_MS;
+            /* do not try to catch up on missed samples */
+            if ((int32_t)(s->next - now) <= 0) {
+                s->next = now + s->period * US_PER_MS;
+            }
+            sampled = 1;
+        }
+        if ((s->next - now) < sleep) {
+            sleep = s->next - now;
+        }
+    }
+    if (sampled) {
+        _publish();
+    }
+    return sleep;
+}
+
+/**
+ * @brief sensor thread, samples every sensor when it is due
+ *
+ * @param[in] arg   unused
+ */
+static void *sensor_thread(void *arg)
+{
+    (void) arg;
+    while (1) {
+        xtimer_usleep(sensor_reg_tick());
+    }
+    return NULL;
+}
+
+int sensor_reg_setup(const sensor_reg_t *sensors, unsigned numof)
+{
+    assert(numof <= SENSOR_REG_NUMOF);
+    table = sensors;
+    table_numof = numof;
+    start = xtimer_now_usec64();
+    uint32_t now = xtimer_now_usec();
+    for (unsigned i = 0; i < numof; i++) {
+        assert((sensors[i].samples > 0) &&
+               (sensors[i].samples <= SENSOR_REG_RING_SIZE));
+        assert(!sensors[i].adapt || ((sensors[i].adapt->min > 0) &&
+               (sensors[i].adapt->min <= sensors[i].adapt->max)));
+        if (sensors[i].init && (sensors[i].init() != 0)) {
+            LOG_ERROR("[SENSOR] %s: init failed\n", sensors[i].name);
+            return -1;
+        }
+        /* fill ring with a first sample */
+        int32_t val = 0;
+        filter_init(&state[i].filter);
+        if (sensors[i].read(&val) != 0) {
+            LOG_ERROR("[SENSOR] %s: read failed\n", sensors[i].name);
+        }
+        else if (sensors[i].filter) {
+            filter_apply(&state[i].filter, sensors[i].filter, &val);
+        }
+        for (unsigned j = 0; j < sensors[i].samples; j++) {
+            state[i].ring[j] = val;
+        }
+        state[i].sum = val * sensors[i].samples;
+        state[i].pos = 0;
+        state[i].prev = val;
+        state[i].change = 0;
+        state[i].fixed = 0;
+        state[i].period = sensors[i].period;
+        state[i].next = now + sensors[i].period * US_PER_MS;
+    }
+    _publish();
+    return 0;
+}
+
+int sensor_reg_init(const sensor_reg_t *sensors, unsigned numof)
+{
+    if (sensor_reg_setup(sensors, numof) != 0) {
+        return -1;
+    }
+    /* start sensor thread for periodic measurements */
+    return thread_create(sensor_thread_stack, sizeof(sensor_thread_stack),
+                         SENSOR_REG_PRIO, THREAD_CREATE_STACKTEST,
+                         sensor_thread, NULL, "sensor_thread");
+}
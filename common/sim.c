@@ -0,0 +1,85 @@
+/**
+ * @ingroup     climote
+ * @{
+ *
+ * @file
+ * @brief       Implements deterministic synthetic sensor data
+ *
+ * @author      smlng <s@mlng.net>
+ *
+ * @}
+ */
+
+#include <stdint.h>
+
+#include "xtimer.h"
+#ifdef MODULE_PERIPH_CPUID
+#include "periph/cpuid.h"
+#endif
+
+#include "sim.h"
+
+#define SIM_PHASE_STEPS     (1024U)
+
+/* first quarter of a sine in 16 steps, Q15 */
+static const int16_t sin_q15[] = {
+    0, 3212, 6393, 9512, 12539, 15446, 18204, 20787,
+    23170, 25329, 27245, 28898, 30273, 31356, 32137, 32609, 32767
+};
+
+static uint32_t state = SIM_SEED;
+static uint32_t phase_ms = 0;
+
+static uint32_t _xorshift(void)
+{
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+/**
+ * @brief sine with phase in [0, SIM_PHASE_STEPS), Q15
+ */
+static int32_t _sin(uint32_t phase)
+{
+    uint32_t quadrant = phase >> 8;
+    uint32_t pos = phase & 0xff;
+    if (quadrant & 1) {
+        pos = 256 - pos;
+    }
+    uint32_t idx = pos >> 4;
+    int32_t val = sin_q15[idx];
+    if (idx < 16) {
+        val += ((sin_q15[idx + 1] - val) * (int32_t)(pos & 0xf)) >> 4;
+    }
+    return (quadrant & 2) ? -val : val;
+}
+
+void sim_init(void)
+{
+    uint32_t seed = 2166136261U ^ SIM_SEED;
+#ifdef MODULE_PERIPH_CPUID
+    uint8_t id[CPUID_LEN];
+    cpuid_get(id);
+    for (unsigned i = 0; i < CPUID_LEN; i++) {
+        seed = (seed ^ id[i]) * 16777619U;
+    }
+#endif
+    /* xorshift must not be seeded with 0 */
+    state = seed ? seed : SIM_SEED;
+    phase_ms = _xorshift();
+}
+
+int16_t sim_sample(const sim_wave_t *wave)
+{
+    uint32_t period_ms = wave->period * 1000U;
+    uint32_t now_ms = (uint32_t)(xtimer_now_usec64() / 1000U) + phase_ms;
+    uint32_t phase = (uint32_t)(((uint64_t)(now_ms % period_ms) *
+                                 SIM_PHASE_STEPS) / period_ms);
+    int32_t val = wave->offset + ((wave->amplitude * _sin(phase)) >> 15);
+    if (wave->noise) {
+        val += (int32_t)(_xorshift() % (2U * wave->noise + 1)) - wave->noise;
+    }
+    return (int16_t)val;
+}
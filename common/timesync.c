@@ -0,0 +1,208 @@
+/**
+ * @ingroup     climote
+ * @{
+ *
+ * @file
+ * @brief       Implements SNTP time synchronization
+ *
+ * @author      smlng <s@mlng.net>
+ *
+ * @}
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "irq.h"
+#include "log.h"
+#include "msg.h"
+#include "net/gnrc/netapi.h"
+#include "net/gnrc/pktbuf.h"
+#include "net/ipv6/addr.h"
+
+#include "coap_udp.h"
+#include "dlog.h"
+#include "timesync.h"
+
+#define NTP_PACKET_LEN      (48U)
+#define NTP_OFFSET_ORIG     (24U)   /**< originate timestamp */
+#define NTP_OFFSET_XMIT     (40U)   /**< transmit timestamp */
+#define NTP_MODE_CLIENT     (3U)
+#define NTP_MODE_SERVER     (4U)
+#define NTP_VERSION         (4U)
+/* seconds from 1900 (NTP) to 1970 (unix) */
+#define NTP_UNIX_OFFSET     (2208988800UL)
+
+#define TIMESYNC_QUEUE_SIZE     (4U)
+#define TIMESYNC_MSG_REQUEST    (0x5453)    /**< timer: ask the server */
+#define TIMESYNC_MSG_TIMEOUT    (0x5454)    /**< timer: no answer */
+
+static uint64_t base_unix;      /**< unix time in us at base_local */
+static uint64_t base_local;     /**< xtimer time in us of the last sync */
+static int synced;
+static uint64_t sent;           /**< nonce of the pending request, 0 if none */
+
+static char timesync_stack[TIMESYNC_STACKSIZE];
+static msg_t timesync_queue[TIMESYNC_QUEUE_SIZE];
+static xtimer_t timer;
+static msg_t timer_msg;
+
+uint32_t timesync_now(void)
+{
+    uint64_t now = xtimer_now_usec64();
+    unsigned irq = irq_disable();
+    uint64_t unix_us = base_unix + (now - base_local);
+    int valid = synced;
+    irq_restore(irq);
+    return valid ? (uint32_t)(unix_us / US_PER_SEC) : 0;
+}
+
+size_t timesync_fmt(uint32_t time, char *buf, size_t len)
+{
+    /* civil date from days since 1970, valid for unsigned 32 bit times */
+    uint32_t days = time / 86400U;
+    uint32_t secs = time % 86400U;
+    uint32_t z = days + 719468U;
+    uint32_t era = z / 146097U;
+    uint32_t doe = z - era * 146097U;
+    uint32_t yoe = (doe - doe / 1460U + doe / 36524U - doe / 146096U) / 365U;
+    uint32_t doy = doe - (365U * yoe + yoe / 4U - yoe / 100U);
+    uint32_t mp = (5U * doy + 2U) / 153U;
+    unsigned day = doy - (153U * mp + 2U) / 5U + 1U;
+    unsigned month = (mp < 10U) ? mp + 3U : mp - 9U;
+    unsigned year = yoe + era * 400U + (month <= 2U);
+
+    int res = snprintf(buf, len, "%04u-%02u-%02uT%02u:%02u:%02uZ", year,
+                       month, day, (unsigned)(secs / 3600U),
+                       (unsigned)((secs / 60U) % 60U), (unsigned)(secs % 60U));
+    return ((res > 0) && ((size_t)res < len)) ? (size_t)res : 0;
+}
+
+static uint32_t _get_u32(const uint8_t *buf)
+{
+    return ((uint32_t)buf[0] << 24) | ((uint32_t)buf[1] << 16) |
+           ((uint32_t)buf[2] << 8) | buf[3];
+}
+
+int timesync_request(void)
+{
+    ipv6_addr_t server;
+    if (ipv6_addr_from_str(&server, TIMESYNC_SERVER) == NULL) {
+        return -1;
+    }
+    uint8_t pkt[NTP_PACKET_LEN];
+    memset(pkt, 0, sizeof(pkt));
+    pkt[0] = (NTP_VERSION << 3) | NTP_MODE_CLIENT;
+    /* the send time doubles as nonce, the server echoes it as originate */
+    uint64_t now = xtimer_now_usec64();
+    memcpy(&pkt[NTP_OFFSET_XMIT], &now, sizeof(now));
+    sent = now;
+    if (coap_udp_send_from(TIMESYNC_LOCAL_PORT, &server, TIMESYNC_PORT,
+                           pkt, sizeof(pkt)) < 0) {
+        sent = 0;
+        return -1;
+    }
+    return 0;
+}
+
+int timesync_input(const coap_udp_dgram_t *dgram)
+{
+    const uint8_t *rsp = dgram->data;
+    /* answers to earlier requests, or without one pending, are stale */
+    if ((sent == 0) || (rsp == NULL) || (dgram->len != NTP_PACKET_LEN) ||
+        (memcmp(&rsp[NTP_OFFSET_ORIG], &sent, sizeof(sent)) != 0)) {
+        return -1;
+    }
+    uint64_t recvd = xtimer_now_usec64();
+    if (((rsp[0] & 0x7) != NTP_MODE_SERVER) || (rsp[1] == 0)) {
+        /* kiss-o'-death (stratum 0), keep waiting for the timeout */
+        return -1;
+    }
+    uint64_t secs = _get_u32(&rsp[NTP_OFFSET_XMIT]);
+    uint32_t frac = _get_u32(&rsp[NTP_OFFSET_XMIT + 4]);
+    if (secs < NTP_UNIX_OFFSET) {
+        /* NTP era 1, i.e., after 2036 */
+        secs += (1ULL << 32);
+    }
+    /* the server sent its time about half a round trip ago */
+    uint64_t unix_us = (secs - NTP_UNIX_OFFSET) * US_PER_SEC +
+                       (((uint64_t)frac * US_PER_SEC) >> 32) +
+                       (recvd - sent) / 2;
+    unsigned irq = irq_disable();
+    base_unix = unix_us;
+    base_local = recvd;
+    synced = 1;
+    irq_restore(irq);
+    DLOG_INFO("[TIME] synchronized, rtt %lu us\n", (unsigned long)(recvd - sent));
+    sent = 0;
+    return 0;
+}
+
+/**
+ * @brief send the timer message of the given type to this thread in us
+ */
+static void _schedule(uint16_t type, uint32_t us)
+{
+    timer_msg.type = type;
+    xtimer_set_msg(&timer, us, &timer_msg, thread_getpid());
+}
+
+/**
+ * @brief ask the server, wait for the answer or retry later
+ */
+static void _ask(void)
+{
+    if (timesync_request() == 0) {
+        _schedule(TIMESYNC_MSG_TIMEOUT, TIMESYNC_TIMEOUT);
+    }
+    else {
+        _schedule(TIMESYNC_MSG_REQUEST, TIMESYNC_RETRY);
+    }
+}
+
+static void *timesync_thread(void *arg)
+{
+    (void) arg;
+    static gnrc_netreg_entry_t entry;
+
+    msg_init_queue(timesync_queue, TIMESYNC_QUEUE_SIZE);
+    if (coap_udp_register_port(&entry, TIMESYNC_LOCAL_PORT,
+                               thread_getpid()) < 0) {
+        LOG_ERROR("[TIME] failed to register port %u\n", TIMESYNC_LOCAL_PORT);
+        return NULL;
+    }
+    _ask();
+    while (1) {
+        msg_t msg;
+        msg_receive(&msg);
+        switch (msg.type) {
+            case GNRC_NETAPI_MSG_TYPE_RCV: {
+                coap_udp_dgram_t dgram;
+                if ((coap_udp_read(msg.content.ptr, &dgram) == 0) &&
+                    (timesync_input(&dgram) == 0)) {
+                    _schedule(TIMESYNC_MSG_REQUEST, TIMESYNC_INTERVAL);
+                }
+                gnrc_pktbuf_release(msg.content.ptr);
+                break;
+            }
+            case TIMESYNC_MSG_REQUEST:
+                _ask();
+                break;
+            case TIMESYNC_MSG_TIMEOUT:
+                sent = 0;
+                DLOG_WARNING("[TIME] no answer from " TIMESYNC_SERVER "\n");
+                _schedule(TIMESYNC_MSG_REQUEST, TIMESYNC_RETRY);
+                break;
+            default:
+                break;
+        }
+    }
+    return NULL;
+}
+
+int timesync_init(void)
+{
+    return thread_create(timesync_stack, sizeof(timesync_stack), TIMESYNC_PRIO,
+                         THREAD_CREATE_STACKTEST, timesync_thread, NULL,
+                         "timesync");
+}
@@ -0,0 +1,109 @@
+/**
+ * @ingroup     climote
+ * @{
+ *
+ * @file
+ * @brief       Implements integer only TMP006 temperature conversion
+ *
+ * Same model as tmp006_convert(), i.e., the TMP006 user guide (SBOU107):
+ *
+ *   S    = S0 * (1 + A1 * dT + A2 * dT^2)
+ *   Vos  = B0 + B1 * dT + B2 * dT^2
+ *   f    = (V - Vos) + C2 * (V - Vos)^2
+ *   Tobj = (Tdie^4 + f / S)^(1/4)
+ *
+ * with dT = Tdie - Tref. Temperatures are in centi Kelvin (cK), voltages in
+ * quarter nV, S is relative to S0 in Q30.
+ *
+ * @author      smlng <s@mlng.net>
+ *
+ * @}
+ */
+
+#include <stdint.h>
+
+#include "tmp006_fixed.h"
+
+#define CK_OFFSET   (27315)         /* 0 C in cK */
+#define TREF        (29815)         /* Tref in cK */
+#define A1_Q30      (18790)         /* A1 = 1.75e-3 / K, per cK in Q30 */
+#define A2_Q40      (-1845)         /* A2 = -1.678e-5 / K^2, per cK^2 in Q40 */
+#define B0          (-117600)       /* B0 = -2.94e-5 V in qnV */
+#define B1_X10      (-228)          /* B1 = -5.7e-7 V / K, qnV per cK * 10 */
+#define B2_X1E6     (1852)          /* B2 = 4.63e-9 V / K^2, qnV per cK^2 * 1e6 */
+#define C2_X1E11    (335)           /* C2 = 13.4 / V, per qnV * 1e11 */
+#define LSB         (625)           /* 156.25 nV per LSB in qnV */
+/* f / S0 in cK^4 per qnV, 2.5e-10 V * 1e8 / 6.4e-14, times 2^20 */
+#define F_S0_Q20    (390625000000LL << 20)
+
+/**
+ * @brief integer square root, floor(sqrt(x))
+ */
+static uint64_t _isqrt(uint64_t x)
+{
+    uint64_t res = 0;
+    uint64_t bit = 1ULL << 62;
+    while (bit > x) {
+        bit >>= 2;
+    }
+    while (bit) {
+        if (x >= res + bit) {
+            x -= res + bit;
+            res = (res >> 1) + bit;
+        }
+        else {
+            res >>= 1;
+        }
+        bit >>= 2;
+    }
+    return res;
+}
+
+int32_t tmp006_fixed_ambient(int16_t rawt)
+{
+    /* 1/128 C per LSB, round to nearest cK */
+    int32_t t = (int32_t)rawt * 25;
+    return (t + ((t < 0) ? -16 : 16)) / 32;
+}
+
+int32_t tmp006_fixed_object(int16_t rawv, int16_t rawt)
+{
+    int64_t tdie = tmp006_fixed_ambient(rawt) + CK_OFFSET;
+    int64_t td = tdie - TREF;
+    int64_t td2 = td * td;
+    /* sensitivity relative to S0, Q30 -> Q20 */
+    int64_t s = (1LL << 30) + td * A1_Q30 + ((td2 * A2_Q40) >> 10);
+    s >>= 10;
+    /* offset voltage and Seebeck corrected sensor voltage */
+    int64_t vos = B0 + (td * B1_X10) / 10 + (td2 * B2_X1E6) / 1000000;
+    int64_t dv = (int64_t)rawv * LSB - vos;
+    int64_t f = dv + (dv * dv * C2_X1E11) / 100000000000LL;
+    /* f / S in cK^4, saturate on overflow */
+    int64_t r = F_S0_Q20 / s;
+    int64_t term;
+    if ((f > INT64_MAX / r) || (f < -(INT64_MAX / r))) {
+        term = (f > 0) ? INT64_MAX : -INT64_MAX;
+    }
+    else {
+        term = f * r;
+    }
+    /* Tdie^4 from the unrounded die temperature in 1/32 cK */
+    uint64_t tdie32 = (uint64_t)((int32_t)rawt * 25 + CK_OFFSET * 32);
+    uint64_t t2 = (tdie32 * tdie32 + 512) >> 10;
+    uint64_t t4 = t2 * t2;
+    uint64_t sum;
+    if (term < 0) {
+        sum = ((uint64_t)(-term) < t4) ? t4 - (uint64_t)(-term) : 0;
+    }
+    else {
+        sum = ((UINT64_MAX - t4) > (uint64_t)term) ? t4 + (uint64_t)term
+                                                   : UINT64_MAX;
+    }
+    /* fourth root, round to nearest cK */
+    uint64_t t = _isqrt(_isqrt(sum));
+    uint64_t t1 = t + 1;
+    if ((t1 * t1 * t1 * t1 - sum) < (sum - t * t * t * t)) {
+        t = t1;
+    }
+    return (int32_t)t - CK_OFFSET;
+}
@@ -0,0 +1,272 @@
+#!/usr/bin/env python3
+"""
+CoAP to MQTT aggregation bridge
+
+Polls (or observes) the climate resources of all CoAP nodes listed in a nodes
+file, batches the readings per node and publishes them to MQTT. Publishes of
+the MQTT-SN (monica) nodes are picked up from the MQTT side of the RSMB broker
+and fed into the same pipeline, so the backend sees one uniform stream:
+
+    <prefix>/<node>  ->  [{"resource": ..., "value": ..., "ts": ...}, ...]
+
+The timestamp is taken from the payload if the node is time synchronized,
+otherwise it is the time of reception. Polls carry the ETag of the last
+response, a node whose values did not change answers 2.03 Valid without
+payload and the last reading is repeated with the time of reception.
+
+All readings pass through one bounded queue. Pollers block when it is full
+(backpressure), observe notifications and MQTT-SN ingest drop the oldest
+reading instead, because those producers cannot be slowed down.
+"""
+
+# coap stuff
+from aiocoap import *
+import asyncio
+import argparse
+import json
+import time
+# mqtt stuff
+import paho.mqtt.client as mqtt
+
+# coaps if a pre-shared key is given, DTLS sessions are kept per node
+scheme = 'coap'
+
+stats = {'polled': 0, 'valid': 0, 'observed': 0, 'ingested': 0, 'failed': 0,
+         'dropped': 0, 'published': 0, 'batches': 0}
+
+# monica publishes monica/<id>/<resource>, commands are not readings
+SN_TOPICS = ['monica/+/climate', 'monica/+/info']
+SN_IGNORE = 'cmd'
+
+
+def read_list(path):
+    """ read non-empty, non-comment lines of a text file """
+    with open(path) as f:
+        return [l.strip() for l in f if l.strip() and not l.startswith('#')]
+
+
+def parse_payload(payload):
+    """ parse plain text (mote) or JSON like (monica, lgv) payloads """
+    text = payload.decode('utf-8').strip()
+    try:
+        return float(text)
+    except ValueError:
+        pass
+    # monica and lgv use single quoted pseudo JSON
+    return json.loads(text.replace("'", '"'))
+
+
+def reading(node, res, payload):
+    """ reading of a payload, stamped by the node if it is synchronized """
+    value = parse_payload(payload)
+    ts = time.time()
+    if isinstance(value, dict) and 'time' in value:
+        ts = value.pop('time')
+    return (node, res, value, ts)
+
+
+def use_coaps(protocol, psk_id, psk):
+    """ switch to coaps, the nodes accept one PSK identity """
+    global scheme
+    scheme = 'coaps'
+    protocol.client_credentials.load_from_dict({'coaps://*': {'dtls': {
+        'psk': {'ascii': psk}, 'client-identity': {'ascii': psk_id}}}})
+
+
+def node_name(addr):
+    """ topic safe name of a node address """
+    return addr.split('%')[0].replace(':', '-')
+
+
+def enqueue_nowait(queue, item):
+    """ put item into queue, drop the oldest reading if queue is full """
+    while True:
+        try:
+            queue.put_nowait(item)
+            return
+        except asyncio.QueueFull:
+            queue.get_nowait()
+            stats['dropped'] += 1
+
+
+async def poll_node(protocol, queue, node, resources, interval):
+    """ periodically GET all resources of a node, revalidate by ETag """
+    etags = dict()      # resource -> (etag, value) of the last response
+    while True:
+        start = time.monotonic()
+        for res in resources:
+            req = Message(code=GET, uri='%s://[%s]/%s' % (scheme, node, res))
+            if res in etags:
+                req.opt.etags = [etags[res][0]]
+            try:
+                rsp = await protocol.request(req).response
+                if rsp.code == VALID and res in etags:
+                    # unchanged, the node did not send the payload again
+                    item = (node_name(node), res, etags[res][1], time.time())
+                    stats['valid'] += 1
+                else:
+                    item = reading(node_name(node), res, rsp.payload)
+                    if rsp.opt.etag is not None:
+                        etags[res] = (rsp.opt.etag, item[2])
+            except Exception as e:
+                stats['failed'] += 1
+                print('[poll] %s/%s failed: %s' % (node, res, e))
+                continue
+            # blocks if the batcher falls behind
+            await queue.put(item)
+            stats['polled'] += 1
+        await asyncio.sleep(max(0, interval - (time.monotonic() - start)))
+
+
+async def observe_node(protocol, queue, node, res, interval):
+    """ observe a resource, fall back to polling if node does not support it """
+    req = Message(code=GET, uri='%s://[%s]/%s' % (scheme, node, res),
+                  observe=0)
+    pr = protocol.request(req)
+    try:
+        rsp = await pr.response
+        enqueue_nowait(queue, reading(node_name(node), res, rsp.payload))
+        if not pr.observation.cancelled:
+            async for rsp in pr.observation:
+                enqueue_nowait(queue, reading(node_name(node), res,
+                                              rsp.payload))
+                stats['observed'] += 1
+    except Exception as e:
+        stats['failed'] += 1
+        print('[observe] %s/%s failed: %s' % (node, res, e))
+    print('[observe] %s/%s not observable, polling' % (node, res))
+    await poll_node(protocol, queue, node, [res], interval)
+
+
+async def batcher(queue, client, prefix, batch_size, batch_interval):
+    """ collect readings and publish one message per node and batch """
+    while True:
+        batch = [await queue.get()]
+        deadline = time.monotonic() + batch_interval
+        while len(batch) < batch_size:
+            timeout = deadline - time.monotonic()
+            if timeout <= 0:
+                break
+            try:
+                batch.append(await asyncio.wait_for(queue.get(), timeout))
+            except asyncio.TimeoutError:
+                break
+        per_node = dict()
+        for node, res, value, ts in batch:
+            per_node.setdefault(node, []).append(
+                {'resource': res, 'value': value, 'ts': ts})
+        for node, samples in per_node.items():
+            client.publish('%s/%s' % (prefix, node), json.dumps(samples), qos=1)
+            stats['published'] += len(samples)
+        stats['batches'] += 1
+
+
+async def report(period):
+    """ print bridge statistics """
+    while True:
+        await asyncio.sleep(period)
+        print('[stats] ' + ', '.join('%s=%d' % kv for kv in stats.items()))
+
+
+def mqttsn_ingest(loop, queue, host, port, topics):
+    """ subscribe to MQTT-SN publishes bridged by RSMB to its MQTT listener """
+    def on_connect(client, userdata, flags, rc):
+        for topic in topics:
+            client.subscribe(topic)
+
+    def on_message(client, userdata, msg):
+        # topic is monica/<id>/<what>, the node is named like its client ID
+        levels = msg.topic.split('/')
+        if SN_IGNORE in levels:
+            return
+        if len(levels) != 3:
+            stats['failed'] += 1
+            return
+        try:
+            item = reading('%s-%s' % (levels[0], levels[1]), levels[2],
+                           msg.payload)
+        except ValueError:
+            stats['failed'] += 1
+            return
+        stats['ingested'] += 1
+        loop.call_soon_threadsafe(enqueue_nowait, queue, item)
+
+    client = mqtt.Client()
+    client.on_connect = on_connect
+    client.on_message = on_message
+    client.connect_async(host, port)
+    client.loop_start()
+    return client
+
+
+def hostport(arg):
+    host, _, port = arg.rpartition(':')
+    return host.strip('[]'), int(port)
+
+
+async def main(args):
+    loop = asyncio.get_event_loop()
+    queue = asyncio.Queue(maxsize=args.queue)
+    # outgoing mqtt, bound the paho internal queue as well
+    host, port = hostport(args.broker)
+    client = mqtt.Client()
+    client.max_inflight_messages_set(args.inflight)
+    client.max_queued_messages_set(args.queue)
+    client.connect_async(host, port)
+    client.loop_start()
+    # incoming mqtt-sn
+    if args.sn_broker:
+        sn_host, sn_port = hostport(args.sn_broker)
+        mqttsn_ingest(loop, queue, sn_host, sn_port, args.sn_topic)
+    # incoming coap
+    protocol = await Context.create_client_context()
+    if args.psk:
+        use_coaps(protocol, args.psk_id, args.psk)
+    nodes = read_list(args.nodes)
+    resources = read_list(args.resources)
+    tasks = [batcher(queue, client, args.prefix, args.batch, args.window),
+             report(args.report)]
+    for node in nodes:
+        if args.observe:
+            tasks += [observe_node(protocol, queue, node, res, args.interval)
+                      for res in resources]
+        else:
+            tasks.append(poll_node(protocol, queue, node, resources,
+                                   args.interval))
+    await asyncio.gather(*tasks)
+
+
+if __name__ == "__main__":
+    p = argparse.ArgumentParser(description='CoAP/MQTT-SN to MQTT bridge')
+    p.add_argument('--nodes', default='shell/nodes.txt',
+                   help='file with one node address per line')
+    p.add_argument('--resources', default='shell/sensors.txt',
+                   help='file with one resource path per line')
+    p.add_argument('--broker', default='[::1]:1883',
+                   help='outgoing MQTT broker')
+    p.add_argument('--sn-broker', default=None,
+                   help='MQTT listener of the RSMB broker, e.g. [fd17:cafe:cafe:2::1]:1886')
+    p.add_argument('--sn-topic', action='append', default=None,
+                   help='MQTT-SN topics to ingest, repeat for more, default '
+                        + ' and '.join(SN_TOPICS))
+    p.add_argument('--prefix', default='climote', help='outgoing topic prefix')
+    p.add_argument('--interval', type=float, default=10.0,
+                   help='poll interval per node in seconds')
+    p.add_argument('--observe', action='store_true',
+                   help='observe resources instead of polling')
+    p.add_argument('--queue', type=int, default=1024,
+                   help='max readings queued before backpressure')
+    p.add_argument('--batch', type=int, default=64,
+                   help='max readings per batch')
+    p.add_argument('--window', type=float, default=1.0,
+                   help='max seconds to wait for a batch to fill')
+    p.add_argument('--inflight', type=int, default=20,
+                   help='max unacknowledged outgoing MQTT messages')
+    p.add_argument('--report', type=float, default=60.0,
+                   help='statistics report period in seconds')
+    p.add_argument('--psk', default=None,
+                   help='pre-shared key, use coaps (nodes built with COAPS=1)')
+    p.add_argument('--psk-id', default='climote', help='PSK identity')
+    args = p.parse_args()
+    args.sn_topic = args.sn_topic or SN_TOPICS
+    asyncio.get_event_loop().run_until_complete(main(args))
@@ -20,6 +20,23 @@ sensor_ipv6 = "[fd49:88e0:1ed6:2:7982:4d5e:5728:2002]"
 yFormatter = FormatStrFormatter('%.2f')
 app_samples = False
 
+# last (etag, value) per resource, unchanged values are not sent again
+etags = dict()
+
+@asyncio.coroutine
+def fetch(protocol, resource):
+    req = Message(code=GET)
+    req.set_request_uri('coap://'+sensor_ipv6+'/'+resource)
+    if resource in etags:
+        req.opt.etags = [etags[resource][0]]
+    res = yield from protocol.request(req).response
+    if res.code == VALID and resource in etags:
+        return etags[resource][1]
+    value = float(res.payload.decode('utf-8'))
+    if res.opt.etag is not None:
+        etags[resource] = (res.opt.etag, value)
+    return value
+
 @asyncio.coroutine
 def main():
     protocol = yield from Context.create_client_context()
@@ -59,23 +76,14 @@ def main():
     # save figure
     plt.draw()
     while True:
-        req_temperature = Message(code=GET)
-        req_humidity = Message(code=GET)
-        req_airquality = Message(code=GET)
-        req_temperature.set_request_uri('coap://'+sensor_ipv6+'/temperature')
-        req_humidity.set_request_uri('coap://'+sensor_ipv6+'/humidity')
-        req_airquality.set_request_uri('coap://'+sensor_ipv6+'/airquality')
         try:
-            res_temperature = yield from protocol.request(req_temperature).response
-            res_humidity = yield from protocol.request(req_humidity).response
-            res_airquality = yield from protocol.request(req_airquality).response
+            t_temp = yield from fetch(protocol, 'temperature')
+            t_humi = yield from fetch(protocol, 'humidity')
+            t_airq = yield from fetch(protocol, 'airquality')
         except Exception as e:
             print('Failed to fetch resource:')
             print(e)
         else:
-            t_temp = float(res_temperature.payload.decode('utf-8'))
-            t_humi = float(res_humidity.payload.decode('utf-8'))
-            t_airq = float(res_airquality.payload.decode('utf-8'))
             if not app_samples:
                 samples['temperature'].popleft()
                 samples['humidity'].popleft()
@@ -0,0 +1,401 @@
+#!/usr/bin/env python3
+"""
+CoAP caching proxy for the climote nodes
+
+Runs on the border router and answers all dashboards and scripts from one
+cache, so the radio load stays the same no matter how many clients watch.
+Clients either use the proxy as forward proxy (Proxy-Uri) or address a node
+resource by path, with ':' of the node address written as '-':
+
+    coap://[proxy]/fd17-cafe-cafe-3--1/monica/climate
+
+GET responses are cached for their Max-Age (CoAP default 60 s, at most
+--max-age). Stale entries with an ETag are revalidated upstream, clients
+sending a matching ETag get 2.03 Valid. Proxy-Uri and path requests for the
+same node resource share one entry. Concurrent requests for the same
+resource share one upstream fetch. An observing client makes the proxy
+observe upstream, one observation per resource serves all observers, with
+--observe the resources of all nodes in the nodes file are observed from the
+start. Resources the node does not let observe, e.g., /climate of monica and
+lgv, are fetched again every Max-Age instead and observers are notified of
+changes. Observations of resources the proxy cannot fetch are not accepted.
+Other methods are forwarded and expire the cached entry.
+
+Only the coap and coaps resources of the nodes in the nodes file are proxied,
+other targets get 4.03 Forbidden. Expired entries without observers are
+evicted every CACHE_SWEEP seconds.
+"""
+
+# coap stuff
+from aiocoap import *
+import aiocoap.interfaces
+import asyncio
+import argparse
+import ipaddress
+import math
+import time
+import urllib.parse
+
+# coaps if a pre-shared key is given, DTLS sessions are kept per node
+scheme = 'coap'
+
+stats = {'requests': 0, 'hits': 0, 'misses': 0, 'coalesced': 0,
+         'revalidated': 0, 'valid': 0, 'upstream': 0, 'notifications': 0,
+         'polled': 0, 'forwarded': 0, 'failed': 0, 'forbidden': 0,
+         'evicted': 0}
+
+DEFAULT_MAX_AGE = 60
+# seconds until a failed upstream observation is tried again
+OBSERVE_RETRY = 30
+# seconds between evictions of expired cache entries
+CACHE_SWEEP = 60
+
+
+def read_list(path):
+    """ read non-empty, non-comment lines of a text file """
+    with open(path) as f:
+        return [l.strip() for l in f if l.strip() and not l.startswith('#')]
+
+
+def node_addr(host):
+    """ normalized node address without zone, None if host is no address """
+    try:
+        return ipaddress.ip_address(host.split('%')[0])
+    except ValueError:
+        return None
+
+
+def use_coaps(protocol, psk_id, psk):
+    """ switch to coaps, the nodes accept one PSK identity """
+    global scheme
+    scheme = 'coaps'
+    protocol.client_credentials.load_from_dict({'coaps://*': {'dtls': {
+        'psk': {'ascii': psk}, 'client-identity': {'ascii': psk_id}}}})
+
+
+class Entry:
+    """ cached response of one resource """
+
+    def __init__(self, uri):
+        self.uri = uri              # upstream URI of the first request
+        self.response = None
+        self.expires = 0
+        self.fetch = None           # upstream fetch in progress
+        self.observers = set()      # downstream observations
+        self.observation = None     # upstream observation task
+        self.observing = False      # upstream notifications keep it current
+        self.pinned = False         # observed without downstream observers
+
+    def idle(self):
+        """ expired, and neither observed nor fetched """
+        return (not self.observers and not self.pinned and self.fetch is None
+                and (self.observation is None or self.observation.done())
+                and time.monotonic() >= self.expires)
+
+    def fresh(self):
+        if self.response is None:
+            return False
+        return self.observing or time.monotonic() < self.expires
+
+    def max_age(self):
+        return max(0, math.ceil(self.expires - time.monotonic()))
+
+    def store(self, response, cap):
+        if response.code not in (CONTENT, VALID):
+            return
+        max_age = response.opt.max_age
+        if max_age is None:
+            max_age = DEFAULT_MAX_AGE
+        self.expires = time.monotonic() + min(max_age, cap)
+        if response.code == VALID and self.response is not None:
+            # revalidated, the cached payload is still current
+            if response.opt.etag is not None:
+                self.response.opt.etag = response.opt.etag
+            return
+        self.response = response
+
+
+class Proxy(aiocoap.interfaces.ObservableResource):
+    """ root resource, handles every request to the proxy """
+
+    def __init__(self, protocol, iface, cap, nodes):
+        super().__init__()
+        self.protocol = protocol
+        self.iface = iface
+        self.cap = cap
+        self.nodes = set(node_addr(n) for n in nodes) - {None}
+        self.cache = dict()
+
+    def allowed(self, uri):
+        """ only the nodes are proxied, the proxy is no open relay """
+        try:
+            parts = urllib.parse.urlsplit(uri)
+            host = parts.hostname
+            parts.port
+        except ValueError:
+            return False
+        if parts.scheme not in ('coap', 'coaps') or host is None:
+            return False
+        return node_addr(host) in self.nodes
+
+    @staticmethod
+    def key(uri):
+        """ cache key of an allowed URI, the same for all spellings of it """
+        parts = urllib.parse.urlsplit(uri)
+        port = parts.port or (5684 if parts.scheme == 'coaps' else 5683)
+        path = '/' + urllib.parse.unquote(parts.path).strip('/')
+        return (parts.scheme, node_addr(parts.hostname), port, path,
+                urllib.parse.unquote(parts.query))
+
+    def entry(self, uri):
+        """ cache entry of an allowed URI, created on first use """
+        key = self.key(uri)
+        entry = self.cache.get(key)
+        if entry is None:
+            entry = self.cache[key] = Entry(uri)
+        return entry
+
+    def evict(self):
+        """ drop expired entries nobody observes """
+        for key in [k for k, e in self.cache.items() if e.idle()]:
+            del self.cache[key]
+            stats['evicted'] += 1
+
+    def target(self, request):
+        """ upstream URI of a request, None if there is none """
+        if request.opt.proxy_uri is not None:
+            return request.opt.proxy_uri
+        path = list(request.opt.uri_path)
+        if len(path) < 2:
+            return None
+        node = path[0].replace('-', ':')
+        if node.startswith('fe80:') and self.iface:
+            node += '%' + self.iface
+        uri = '%s://[%s]/%s' % (scheme, node, '/'.join(path[1:]))
+        if request.opt.uri_query:
+            uri += '?' + '&'.join(request.opt.uri_query)
+        return uri
+
+    async def needs_blockwise_assembly(self, request):
+        return True
+
+    async def upstream(self, uri, entry):
+        """ GET or revalidate a resource and update the cache """
+        req = Message(code=GET, uri=uri)
+        if entry.response is not None and entry.response.opt.etag is not None:
+            req.opt.etags = [entry.response.opt.etag]
+            stats['revalidated'] += 1
+        stats['upstream'] += 1
+        try:
+            response = await self.protocol.request(req).response
+        finally:
+            entry.fetch = None
+        entry.store(response, self.cap)
+        return response
+
+    async def fetch(self, uri, entry):
+        """ concurrent callers share one upstream fetch """
+        if entry.fetch is not None:
+            stats['coalesced'] += 1
+        else:
+            entry.fetch = asyncio.ensure_future(self.upstream(uri, entry))
+        # the cache is updated before any caller resumes
+        return await entry.fetch
+
+    def reply(self, request, entry):
+        """ response to a client from the cache """
+        cached = entry.response
+        etag = cached.opt.etag
+        if etag is not None and etag in request.opt.etags:
+            stats['valid'] += 1
+            response = Message(code=VALID)
+        else:
+            response = Message(code=cached.code, payload=cached.payload)
+            response.opt.content_format = cached.opt.content_format
+        response.opt.etag = etag
+        response.opt.max_age = entry.max_age()
+        return response
+
+    async def render(self, request):
+        stats['requests'] += 1
+        uri = self.target(request)
+        if uri is None:
+            return Message(code=NOT_FOUND)
+        if not self.allowed(uri):
+            stats['forbidden'] += 1
+            return Message(code=FORBIDDEN)
+        if request.code != GET:
+            # e.g. PUT /led, never cached, the next GET fetches the new state
+            entry = self.cache.get(self.key(uri))
+            if entry is not None:
+                entry.expires = 0
+            stats['forwarded'] += 1
+            req = Message(code=request.code, uri=uri, payload=request.payload)
+            req.opt.content_format = request.opt.content_format
+            try:
+                rsp = await self.protocol.request(req).response
+            except Exception:
+                stats['failed'] += 1
+                return Message(code=GATEWAY_TIMEOUT)
+            response = Message(code=rsp.code, payload=rsp.payload)
+            response.opt.content_format = rsp.opt.content_format
+            return response
+        entry = self.entry(uri)
+        if entry.fresh():
+            stats['hits'] += 1
+            return self.reply(request, entry)
+        stats['misses'] += 1
+        try:
+            response = await self.fetch(entry.uri, entry)
+        except Exception as e:
+            stats['failed'] += 1
+            print('[proxy] %s failed: %s' % (uri, e))
+            return Message(code=GATEWAY_TIMEOUT)
+        if response.code not in (CONTENT, VALID):
+            return Message(code=response.code, payload=response.payload)
+        return self.reply(request, entry)
+
+    async def add_observation(self, request, serverobservation):
+        uri = self.target(request)
+        if uri is None or request.code != GET or not self.allowed(uri):
+            return
+        entry = self.entry(uri)
+        if not entry.fresh():
+            try:
+                await self.fetch(entry.uri, entry)
+            except Exception as e:
+                stats['failed'] += 1
+                print('[proxy] %s failed: %s' % (uri, e))
+        # the GET is answered without Observe, e.g., 4.04 or node unreachable
+        if entry.response is None:
+            return
+        entry.observers.add(serverobservation)
+        serverobservation.accept(lambda: self.remove_observer(entry, serverobservation))
+        self.observe(entry.uri, entry)
+
+    def remove_observer(self, entry, serverobservation):
+        if self.cache.get(self.key(entry.uri)) is not entry:
+            return
+        entry.observers.discard(serverobservation)
+        # the last observer is gone, stop observing the node
+        if not entry.observers and not entry.pinned and entry.observation:
+            entry.observation.cancel()
+
+    def observe(self, uri, entry):
+        """ keep one upstream observation per resource """
+        if entry.observation is None or entry.observation.done():
+            entry.observation = asyncio.ensure_future(self.observe_upstream(uri, entry))
+
+    async def observe_upstream(self, uri, entry):
+        while entry.observers or entry.pinned:
+            pr = self.protocol.request(Message(code=GET, uri=uri, observe=0))
+            stats['upstream'] += 1
+            try:
+                entry.store(await pr.response, self.cap)
+                self.notify(entry)
+                if pr.observation.cancelled:
+                    print('[proxy] %s not observable, polling' % uri)
+                    await self.poll(uri, entry)
+                    return
+                entry.observing = True
+                async for rsp in pr.observation:
+                    stats['notifications'] += 1
+                    entry.store(rsp, self.cap)
+                    self.notify(entry)
+            except asyncio.CancelledError:
+                pr.observation.cancel()
+                raise
+            except Exception as e:
+                stats['failed'] += 1
+                print('[proxy] observe %s failed: %s' % (uri, e))
+            finally:
+                entry.observing = False
+            await asyncio.sleep(OBSERVE_RETRY)
+
+    async def poll(self, uri, entry):
+        """ fetch every Max-Age, notify observers if the resource changed """
+        delay = entry.max_age()
+        while entry.observers or entry.pinned:
+            await asyncio.sleep(max(delay, 1))
+            before = entry.response
+            stats['polled'] += 1
+            try:
+                # a cancelled poll must not cancel the fetch of a GET
+                await asyncio.shield(self.fetch(uri, entry))
+                delay = entry.max_age()
+            except asyncio.CancelledError:
+                raise
+            except Exception as e:
+                stats['failed'] += 1
+                print('[proxy] poll %s failed: %s' % (uri, e))
+                delay = OBSERVE_RETRY
+                continue
+            after = entry.response
+            if after is not before and (before is None or
+                                        after.payload != before.payload or
+                                        after.opt.etag != before.opt.etag):
+                self.notify(entry)
+
+    def notify(self, entry):
+        for obs in list(entry.observers):
+            obs.trigger()
+
+
+async def sweep(proxy):
+    """ evict expired entries, the cache stays bounded by the observed ones """
+    while True:
+        await asyncio.sleep(CACHE_SWEEP)
+        proxy.evict()
+
+
+async def report(period):
+    """ print proxy statistics """
+    while True:
+        await asyncio.sleep(period)
+        print('[stats] ' + ', '.join('%s=%d' % kv for kv in stats.items()))
+
+
+def hostport(arg):
+    host, _, port = arg.rpartition(':')
+    return host.strip('[]'), int(port)
+
+
+async def main(args):
+    protocol = await Context.create_client_context()
+    if args.psk:
+        use_coaps(protocol, args.psk_id, args.psk)
+    nodes = read_list(args.nodes)
+    proxy = Proxy(protocol, args.iface, args.max_age, nodes)
+    await Context.create_server_context(proxy, bind=hostport(args.bind))
+    asyncio.ensure_future(sweep(proxy))
+    if args.observe:
+        # warm the cache, radio load does not depend on the clients anymore
+        for node in nodes:
+            for res in read_list(args.resources):
+                uri = '%s://[%s]/%s' % (scheme, node, res)
+                entry = proxy.entry(uri)
+                entry.pinned = True
+                proxy.observe(uri, entry)
+    await report(args.report)
+
+
+if __name__ == "__main__":
+    p = argparse.ArgumentParser(description='CoAP caching proxy')
+    p.add_argument('--bind', default='[::]:5683', help='address to listen on')
+    p.add_argument('--iface', default=None,
+                   help='interface of link-local node addresses, e.g. lowpan0')
+    p.add_argument('--max-age', type=int, default=DEFAULT_MAX_AGE,
+                   help='max seconds to serve a response from the cache')
+    p.add_argument('--observe', action='store_true',
+                   help='observe the resources of all nodes from the start')
+    p.add_argument('--nodes', default='shell/nodes.txt',
+                   help='file with one node address per line, '
+                        'only these nodes are proxied')
+    p.add_argument('--resources', default='shell/sensors.txt',
+                   help='file with one resource path per line')
+    p.add_argument('--report', type=float, default=60.0,
+                   help='seconds between statistics')
+    p.add_argument('--psk', default=None,
+                   help='pre-shared key, query the nodes with coaps')
+    p.add_argument('--psk-id', default='climote', help='PSK identity')
+    asyncio.get_event_loop().run_until_complete(main(p.parse_args()))
@@ -0,0 +1,126 @@
+#!/bin/bash
+# Launch a fleet of simulated climote nodes (BOARD=native) on a tap bridge and
+# measure collector throughput, request loss and latency for growing sizes.
+#
+# usage: sudo ./fleet.sh <monica|lgv|mote> "<N1> <N2> ..." [duration]
+#
+# needs RIOTBASE (default ../../..), aiocoap, ip and ping6, set PROFILE=release
+# to benchmark the release build and COAPS=1 (optional COAPS_PSK_ID and
+# COAPS_PSK_KEY, else a random key per run) to benchmark coaps. Sampling
+# counters of the nodes are written to sensors-N.txt, use a duration of some
+# minutes to see adaptive sampling settle. The debug profile builds with
+# DEVELHELP=1 and writes the largest stack use per thread to stacks-N.txt.
+APP=${1:-monica}
+SIZES=${2:-"1 2 4 8 16 32"}
+DURATION=${3:-30}
+
+SCRIPT_DIR=$(dirname "$(readlink -f "$0")")
+APP_DIR=$(readlink -f "$SCRIPT_DIR/../../$APP")
+RIOTBASE=${RIOTBASE:-$(readlink -f "$SCRIPT_DIR/../../..")}
+TAPSETUP="$RIOTBASE/dist/tools/tapsetup/tapsetup"
+BRIDGE=${BRIDGE:-tapbr0}
+SIM_SEED=${SIM_SEED:-2409}
+PROFILE=${PROFILE:-debug}
+DEVELHELP=${DEVELHELP:-$([ "$PROFILE" = "debug" ] && echo 1 || echo 0)}
+COAPS=${COAPS:-0}
+COAPS_PSK_ID=${COAPS_PSK_ID:-climote}
+COAPS_PSK_KEY=${COAPS_PSK_KEY:-$(od -An -tx1 -N16 /dev/urandom | tr -d ' \n')}
+BENCH_ARGS=""
+[ "$COAPS" = "1" ] && BENCH_ARGS="--psk $COAPS_PSK_KEY --psk-id $COAPS_PSK_ID"
+OUT=${OUT:-"$SCRIPT_DIR/results/$APP-$(date +%s)"}
+
+case "$APP" in
+    monica) RESOURCE="monica/climate" ;;
+    lgv)    RESOURCE="lgv/climate" ;;
+    mote)   RESOURCE="temperature" ;;
+    *)      echo "unknown app $APP"; exit 1 ;;
+esac
+
+[ -x "$TAPSETUP" ] || { echo "tapsetup not found, set RIOTBASE!"; exit 1; }
+
+# build once, every node gets its own seed through --id
+make -C "$APP_DIR" BOARD=native SIM_SEED=$SIM_SEED PROFILE=$PROFILE \
+    DEVELHELP=$DEVELHELP \
+    COAPS=$COAPS COAPS_PSK_ID=$COAPS_PSK_ID COAPS_PSK_KEY=$COAPS_PSK_KEY \
+    all || exit 1
+BIN=bin
+[ "$PROFILE" = "debug" ] || BIN=bin-$PROFILE
+ELF=$(ls "$APP_DIR"/$BIN/native/*.elf | head -n 1)
+mkdir -p "$OUT"
+
+PIDS=""
+stop_fleet() {
+    [ -n "$PIDS" ] && kill $PIDS 2> /dev/null
+    pkill -f "$ELF" 2> /dev/null
+    wait 2> /dev/null
+    PIDS=""
+    $TAPSETUP -d > /dev/null 2>&1
+}
+trap stop_fleet EXIT
+
+echo "nodes,requests,responses,lost,loss,throughput,lat_p50,lat_p95,lat_max" \
+    > "$OUT/results.csv"
+for N in $SIZES; do
+    echo "### fleet of $N $APP nodes"
+    $TAPSETUP -c $N -b $BRIDGE > /dev/null || exit 1
+    for i in $(seq 0 $((N - 1))); do
+        # shell commands go through a FIFO, a sleeping writer keeps it open,
+        # otherwise the shell of the node quits
+        mkfifo "$OUT/node-$N-$i.in"
+        ( "$ELF" tap$i --id=$((i + 1)) < "$OUT/node-$N-$i.in" \
+            > "$OUT/node-$N-$i.log" 2>&1 ) &
+        PIDS="$PIDS $!"
+        sleep infinity > "$OUT/node-$N-$i.in" &
+        PIDS="$PIDS $!"
+    done
+    # wait for DAD and collect link-local addresses of all nodes
+    sleep 5
+    ping6 -c 3 -I $BRIDGE ff02::1 2> /dev/null \
+        | sed -n 's/.*from \(fe80::[0-9a-f:]*\).*/\1/p' | sort -u \
+        | grep -v -x -F -f <(ip -6 addr show dev $BRIDGE \
+            | sed -n 's/.*inet6 \(fe80::[0-9a-f:]*\).*/\1/p') \
+        | sed "s/\$/%$BRIDGE/" > "$OUT/nodes-$N.txt"
+    echo "found $(wc -l < "$OUT/nodes-$N.txt") of $N nodes"
+    python3 "$SCRIPT_DIR/fleet_bench.py" --nodes "$OUT/nodes-$N.txt" \
+        --resource "$RESOURCE" --duration $DURATION --csv $BENCH_ARGS \
+        >> "$OUT/results.csv"
+    # sampling counters of all nodes with a shell, i.e., not lgv
+    if [ "$APP" != "lgv" ]; then
+        for i in $(seq 0 $((N - 1))); do
+            echo sensors > "$OUT/node-$N-$i.in"
+        done
+        sleep 1
+        awk '/period +samples/ { on = 1; next }
+             on && /%$/ { n[$1]++; s[$1] += $3; p[$1] += $2; v[$1] += $7; next }
+             { on = 0 }
+             END { for (k in n) printf "%s: %d samples, period %d ms, saved %d%%\n",
+                   k, s[k], p[k] / n[k], v[k] / n[k] }' \
+            "$OUT"/node-$N-*.log | tee "$OUT/sensors-$N.txt"
+    fi
+    # stack high-water marks (THREAD_CREATE_STACKTEST) of all nodes, monica
+    # prints "<thread> <size> <used>", mote the table of ps
+    if [ "$APP" != "lgv" ] && [ "$DEVELHELP" = "1" ]; then
+        CMD=stacks
+        [ "$APP" = "mote" ] && CMD=ps
+        for i in $(seq 0 $((N - 1))); do
+            echo $CMD > "$OUT/node-$N-$i.in"
+        done
+        sleep 1
+        awk '/^thread +size +used/ { on = 1; next }
+             on && NF == 3 && $3 ~ /^[0-9]+$/ { t = $1; s = $2; u = $3 }
+             !on && split($0, f, "|") >= 5 &&
+                 match(f[5], /[0-9]+ *\( *[0-9]+/) {
+                 t = f[2]; gsub(/ /, "", t)
+                 split(substr(f[5], RSTART, RLENGTH), v, /[ (]+/)
+                 s = v[1]; u = v[2]
+             }
+             !on && !t { next }
+             on && !t { on = 0; next }
+             t != "SUM" { if (u > m[t]) m[t] = u; z[t] = s }
+             { t = "" }
+             END { for (k in m) printf "%s: %d of %d bytes\n", k, m[k], z[k] }' \
+            "$OUT"/node-$N-*.log | sort | tee "$OUT/stacks-$N.txt"
+    fi
+    stop_fleet
+done
+cat "$OUT/results.csv"
@@ -0,0 +1,89 @@
+#!/usr/bin/env python3
+"""
+Collector benchmark for a (simulated) fleet of climote nodes
+
+Every node gets one closed loop client that GETs a resource as fast as the
+node answers. Reports aggregate throughput, request loss and end-to-end
+latency percentiles. With --psk the nodes are queried with coaps, the first
+request of every client includes the DTLS handshake and is reported apart,
+all later ones reuse the session.
+"""
+
+# coap stuff
+from aiocoap import *
+import asyncio
+import argparse
+import time
+
+
+def percentile(values, p):
+    if not values:
+        return float('nan')
+    values = sorted(values)
+    return values[min(len(values) - 1, int(len(values) * p / 100))]
+
+
+async def client(protocol, scheme, node, resource, timeout, deadline, res):
+    first = True
+    while time.monotonic() < deadline:
+        req = Message(code=GET, uri='%s://[%s]/%s' % (scheme, node, resource))
+        start = time.monotonic()
+        res['requests'] += 1
+        try:
+            await asyncio.wait_for(protocol.request(req).response, timeout)
+        except Exception:
+            res['lost'] += 1
+            continue
+        # the first response of a coaps client includes the handshake
+        res['first' if first else 'latency'].append(time.monotonic() - start)
+        first = False
+
+
+async def main(args):
+    protocol = await Context.create_client_context()
+    scheme = 'coap'
+    if args.psk:
+        scheme = 'coaps'
+        protocol.client_credentials.load_from_dict({'coaps://*': {'dtls': {
+            'psk': {'ascii': args.psk},
+            'client-identity': {'ascii': args.psk_id}}}})
+    with open(args.nodes) as f:
+        nodes = [l.strip() for l in f if l.strip()]
+    res = {'requests': 0, 'lost': 0, 'latency': [], 'first': []}
+    start = time.monotonic()
+    deadline = start + args.duration
+    await asyncio.gather(*[client(protocol, scheme, n, args.resource,
+                                  args.timeout, deadline, res) for n in nodes])
+    elapsed = time.monotonic() - start
+    lat = res['latency']
+    row = (len(nodes), res['requests'], len(lat) + len(res['first']),
+           res['lost'],
+           res['lost'] / max(1, res['requests']), len(lat) / elapsed,
+           percentile(lat, 50) * 1000, percentile(lat, 95) * 1000,
+           max(lat, default=float('nan')) * 1000)
+    if args.csv:
+        print('%d,%d,%d,%d,%.4f,%.1f,%.1f,%.1f,%.1f' % row)
+    else:
+        print('nodes: %d, requests: %d, responses: %d, lost: %d (%.2f%%)'
+              % (row[0], row[1], row[2], row[3], row[4] * 100))
+        print('throughput: %.1f req/s, latency p50: %.1f ms, p95: %.1f ms, '
+              'max: %.1f ms' % row[5:])
+        print('first request (%s): p50: %.1f ms, max: %.1f ms'
+              % ('handshake' if args.psk else 'no handshake',
+                 percentile(res['first'], 50) * 1000,
+                 max(res['first'], default=float('nan')) * 1000))
+
+
+if __name__ == "__main__":
+    p = argparse.ArgumentParser(description='climote fleet benchmark')
+    p.add_argument('--nodes', required=True,
+                   help='file with one node address per line')
+    p.add_argument('--resource', default='monica/climate')
+    p.add_argument('--duration', type=float, default=30.0)
+    p.add_argument('--timeout', type=float, default=5.0,
+                   help='seconds until a request counts as lost')
+    p.add_argument('--csv', action='store_true')
+    p.add_argument('--psk', default=None,
+                   help='pre-shared key, use coaps (nodes built with COAPS=1)')
+    p.add_argument('--psk-id', default='climote', help='PSK identity')
+    asyncio.get_event_loop().run_until_complete(main(p.parse_args()))
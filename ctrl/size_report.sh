@@ -0,0 +1,54 @@
+#!/bin/bash
+# Build the applications with every build profile and compare code size, with
+# --speed the native builds are benchmarked with a single node fleet as well.
+#
+# usage: ./size_report.sh [--speed] <monica|lgv|mote|all> ["<BOARD1> ..."]
+#
+# without boards the default board of every application is used
+SPEED=0
+if [ "$1" = "--speed" ]; then
+    SPEED=1
+    shift
+fi
+APPS=${1:-all}
+BOARDS=$2
+PROFILES=${PROFILES:-"debug release"}
+
+SCRIPT_DIR=$(dirname "$(readlink -f "$0")")
+[ "$APPS" = "all" ] && APPS="mote monica lgv"
+
+# default board of an application, as set in its Makefile
+default_board() {
+    sed -n 's/^BOARD ?= *\(.*\)$/\1/p' "$SCRIPT_DIR/../$1/Makefile"
+}
+
+printf "%-8s %-16s %-8s %8s %8s %8s %8s %8s\n" \
+    app board profile text data bss total delta
+for APP in $APPS; do
+    APP_DIR=$(readlink -f "$SCRIPT_DIR/../$APP")
+    for BOARD in ${BOARDS:-$(default_board $APP)}; do
+        SIZE=arm-none-eabi-size
+        [ "$BOARD" = "native" ] && SIZE=size
+        BASE=""
+        for PROFILE in $PROFILES; do
+            BIN=bin
+            [ "$PROFILE" = "debug" ] || BIN=bin-$PROFILE
+            if ! make -C "$APP_DIR" BOARD=$BOARD PROFILE=$PROFILE all \
+                    > /dev/null 2>&1; then
+                printf "%-8s %-16s %-8s build failed\n" $APP $BOARD $PROFILE
+                continue
+            fi
+            ELF=$(ls "$APP_DIR"/$BIN/$BOARD/*.elf | head -n 1)
+            read -r TEXT DATA BSS TOTAL _ < <($SIZE "$ELF" | tail -n 1)
+            [ -z "$BASE" ] && BASE=$TOTAL
+            printf "%-8s %-16s %-8s %8d %8d %8d %8d %+8d\n" $APP $BOARD \
+                $PROFILE $TEXT $DATA $BSS $TOTAL $((TOTAL - BASE))
+            if [ $SPEED -eq 1 ] && [ "$BOARD" = "native" ]; then
+                PROFILE=$PROFILE OUT="$SCRIPT_DIR/sim/results/$APP-$PROFILE" \
+                    "$SCRIPT_DIR/sim/fleet.sh" $APP 1 10 > /dev/null 2>&1
+                tail -n 1 "$SCRIPT_DIR/sim/results/$APP-$PROFILE/results.csv" \
+                    | awk -F, '{ printf "%34s throughput %s/s, p50 %s ms, p95 %s ms\n", "", $6, $7, $8 }'
+            fi
+        done
+    done
+done
@@ -0,0 +1,59 @@
+#!/usr/bin/env python3
+"""
+Minimal SNTP server
+
+Stand-in for an NTP daemon on the border router or the native fleet host.
+Answers every client request with the local system time (stratum 2), which
+is good enough to timestamp samples, see common/include/timesync.h.
+"""
+
+import argparse
+import socket
+import struct
+import time
+
+NTP_PACKET_LEN = 48
+# seconds from 1900 (NTP) to 1970 (unix)
+NTP_UNIX_OFFSET = 2208988800
+NTP_MODE_CLIENT = 3
+NTP_MODE_SERVER = 4
+
+
+def ntp_time(t):
+    """ unix time as 64 bit NTP timestamp """
+    secs = int(t)
+    frac = int((t - secs) * (1 << 32))
+    return struct.pack('!II', (secs + NTP_UNIX_OFFSET) & 0xffffffff, frac)
+
+
+def answer(request, recvd):
+    """ server reply to a client request, None to ignore it """
+    if len(request) < NTP_PACKET_LEN or (request[0] & 0x7) != NTP_MODE_CLIENT:
+        return None
+    version = (request[0] >> 3) & 0x7
+    head = struct.pack('!BBbb', (version << 3) | NTP_MODE_SERVER, 2, 6, -20)
+    # root delay, root dispersion and reference ID
+    head += struct.pack('!II', 0, 0) + b'LOCL'
+    now = time.time()
+    # reference, originate (client transmit), receive, transmit timestamps
+    return head + ntp_time(now) + request[40:48] + ntp_time(recvd) + ntp_time(now)
+
+
+def main():
+    p = argparse.ArgumentParser(description='minimal SNTP server')
+    p.add_argument('--bind', default='::', help='address to listen on')
+    p.add_argument('--port', type=int, default=123, help='UDP port')
+    args = p.parse_args()
+
+    sock = socket.socket(socket.AF_INET6, socket.SOCK_DGRAM)
+    sock.bind((args.bind, args.port))
+    print('[sntpd] listening on [%s]:%d' % (args.bind, args.port))
+    while True:
+        data, addr = sock.recvfrom(512)
+        rsp = answer(data, time.time())
+        if rsp is not None:
+            sock.sendto(rsp, addr)
+
+
+if __name__ == "__main__":
+    main()
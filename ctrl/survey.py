@@ -0,0 +1,144 @@
+#!/usr/bin/env python3
+"""
+CoAP group survey
+
+Sends one non-confirmable GET to the All CoAP Nodes group and collects the
+unicast replies of every node that answers within the leisure window. Nodes
+delay their reply randomly within the leisure period requested by the query
+`?leisure=<ms>`, so a whole segment answers in about one RTT plus leisure.
+
+aiocoap does not hand out multiple responses to one multicast request, hence
+the request is built and the replies are parsed here on a plain UDP socket.
+"""
+
+import argparse
+import json
+import os
+import socket
+import struct
+import time
+
+COAP_PORT = 5683
+COAP_NON = 1
+COAP_GET = 1
+OPT_URI_PATH = 11
+OPT_URI_QUERY = 15
+
+
+def encode_option(delta, value):
+    """ encode one option, delta and length below 269 """
+    head = b''
+    ext = b''
+    for n in (delta, len(value)):
+        if n < 13:
+            head += bytes([n])
+        else:
+            head += bytes([13])
+            ext += bytes([n - 13])
+    return bytes([(head[0] << 4) | head[1]]) + ext + value
+
+
+def build_get(mid, token, path, query):
+    """ build a NON GET request """
+    msg = struct.pack('!BBH', 0x40 | (COAP_NON << 4) | len(token),
+                      COAP_GET, mid) + token
+    opts = [(OPT_URI_PATH, s.encode()) for s in path.strip('/').split('/') if s]
+    opts += [(OPT_URI_QUERY, q.encode()) for q in query]
+    last = 0
+    for num, value in opts:
+        msg += encode_option(num - last, value)
+        last = num
+    return msg
+
+
+def option_field(data, pos, n):
+    """ decode an extended option delta or length, return (value, pos) """
+    if n == 13:
+        return data[pos] + 13, pos + 1
+    if n == 14:
+        return (data[pos] << 8) + data[pos + 1] + 269, pos + 2
+    return n, pos
+
+
+def parse_reply(data, token):
+    """ return (code, payload) of a reply matching token, None otherwise """
+    if len(data) < 4 or (data[0] >> 6) != 1:
+        return None
+    tkl = data[0] & 0x0f
+    if data[4:4 + tkl] != token:
+        return None
+    code = '%d.%02d' % (data[1] >> 5, data[1] & 0x1f)
+    # skip options, the payload follows the 0xff marker
+    pos = 4 + tkl
+    while pos < len(data) and data[pos] != 0xff:
+        head = data[pos]
+        _, pos = option_field(data, pos + 1, head >> 4)
+        length, pos = option_field(data, pos, head & 0x0f)
+        pos += length
+    payload = data[pos + 1:]
+    return code, payload.decode('utf-8', 'replace')
+
+
+def survey(group, iface, port, path, leisure, margin, hops):
+    """ send one group request, return {node: (code, payload, rtt)} """
+    sock = socket.socket(socket.AF_INET6, socket.SOCK_DGRAM)
+    ifindex = socket.if_nametoindex(iface) if iface else 0
+    sock.setsockopt(socket.IPPROTO_IPV6, socket.IPV6_MULTICAST_IF, ifindex)
+    sock.setsockopt(socket.IPPROTO_IPV6, socket.IPV6_MULTICAST_HOPS, hops)
+    token = os.urandom(4)
+    mid = int.from_bytes(os.urandom(2), 'big')
+    req = build_get(mid, token, path, ['leisure=%d' % leisure])
+    start = time.monotonic()
+    sock.sendto(req, (group, port, 0, ifindex))
+    deadline = start + (leisure / 1000.0) + margin
+    replies = {}
+    while True:
+        left = deadline - time.monotonic()
+        if left <= 0:
+            break
+        sock.settimeout(left)
+        try:
+            data, addr = sock.recvfrom(1280)
+        except socket.timeout:
+            break
+        reply = parse_reply(data, token)
+        if reply is not None and addr[0] not in replies:
+            replies[addr[0]] = reply + (time.monotonic() - start,)
+    sock.close()
+    return replies
+
+
+def main():
+    p = argparse.ArgumentParser(description='survey all nodes with one CoAP '
+                                            'group request')
+    p.add_argument('--group', default='ff05::fd',
+                   help='multicast group, e.g. ff02::fd on one link')
+    p.add_argument('--iface', default=None,
+                   help='outgoing interface, needed for link-local groups')
+    p.add_argument('--port', type=int, default=COAP_PORT)
+    p.add_argument('--path', default='monica/climate',
+                   help='resource, e.g. lgv/climate or temperature (mote)')
+    p.add_argument('--leisure', type=int, default=2000,
+                   help='spread of the replies in ms')
+    p.add_argument('--margin', type=float, default=1.0,
+                   help='extra wait after leisure in s, covers the RTT')
+    p.add_argument('--hops', type=int, default=8, help='multicast hop limit')
+    p.add_argument('--json', action='store_true', help='print JSON')
+    args = p.parse_args()
+
+    replies = survey(args.group, args.iface, args.port, args.path,
+                     args.leisure, args.margin, args.hops)
+    # gcoap nodes without the resource answer 4.04, skip them
+    found = {n: r for n, r in replies.items() if r[0].startswith('2.')}
+    if args.json:
+        print(json.dumps({n: {'code': c, 'payload': pl, 'rtt': round(t, 3)}
+                          for n, (c, pl, t) in found.items()}))
+        return
+    for node, (code, payload, rtt) in sorted(found.items()):
+        print('%-40s %s %6.3fs %s' % (node, code, rtt, payload))
+    print('%d nodes replied, %d with errors' % (len(found),
+                                                len(replies) - len(found)))
+
+
+if __name__ == "__main__":
+    main()
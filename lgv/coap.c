@@ -1,8 +1,18 @@
+#include <assert.h>
+#include <string.h>
+
 #include "log.h"
 #include "msg.h"
 #include "thread.h"
 #include "od.h"
 #include "net/gcoap.h"
+#include "coap_dispatch.h"
+#include "coap_etag.h"
+#include "coap_group.h"
+#include "coaps.h"
+#include "dlog.h"
+#include "node_info.h"
+#include "sensor_reg.h"
 // own
 #include "config.h"
 
@@ -12,15 +22,19 @@ static ssize_t _climate_handler(coap_pkt_t* pdu, uint8_t *buf, size_t len, void
 /* Counts requests sent by CLI. */
 static uint16_t req_count = 0;
 
-/* CoAP resources */
-static const coap_resource_t _resources[] = {
+/* CoAP resources, gcoap expects them sorted by path, named as nanocoap
+ * expects them for coap_handle_req() of the coaps server */
+const coap_resource_t coap_resources[] = {
     { "/lgv/climate", COAP_GET, _climate_handler, NULL },
     { "/lgv/info", COAP_GET, _info_handler, NULL },
 };
 
+const unsigned coap_resources_numof = sizeof(coap_resources) /
+                                      sizeof(coap_resources[0]);
+
 static gcoap_listener_t _listener = {
-    (coap_resource_t *)&_resources[0],
-    sizeof(_resources) / sizeof(_resources[0]),
+    (coap_resource_t *)&coap_resources[0],
+    sizeof(coap_resources) / sizeof(coap_resources[0]),
     NULL
 };
 
@@ -103,10 +117,11 @@ static ssize_t _info_handler(coap_pkt_t* pdu, uint8_t *buf, size_t len, void *ct
 {
     (void)ctx;
 
-    LOG_DEBUG("[CoAP] info_handler\n");
+    DLOG_DEBUG("[CoAP] info_handler\n");
     gcoap_resp_init(pdu, buf, len, COAP_CODE_CONTENT);
 
-    size_t payload_len = node_get_info((char *)pdu->payload);
+    size_t payload_len = node_info_get((char *)pdu->payload,
+                                       len - (pdu->payload - buf));
 
     return gcoap_finish(pdu, payload_len, COAP_FORMAT_JSON);
 }
@@ -119,12 +134,42 @@ static ssize_t _climate_handler(coap_pkt_t* pdu, uint8_t *buf, size_t len, void
 {
     (void)ctx;
 
-    LOG_DEBUG("[CoAP] climate_handler\n");
-    gcoap_resp_init(pdu, buf, len, COAP_CODE_CONTENT);
-
-    size_t payload_len = sprintf((char *)pdu->payload, "{'temperature': %d, 'humidity': %d}", sensor_get_temperature(), sensor_get_humidity());
-
-    return gcoap_finish(pdu, payload_len, COAP_FORMAT_JSON);
+    DLOG_DEBUG("[CoAP] climate_handler\n");
+    uint32_t leisure = coap_leisure_from_query((const char *)pdu->qs,
+                                               strlen((const char *)pdu->qs));
+
+    sensor_reg_snapshot_t snap;
+    sensor_reg_snapshot(&snap);
+    uint8_t etag[COAP_ETAG_LEN];
+    coap_etag_from_gen(snap.gen, etag);
+    /* check the request options before the response overwrites them. The
+     * length of the request is unknown here, len is the size of buf; the
+     * walk ends at the Uri-Path option every dispatched request carries */
+    uint8_t *opts = (uint8_t *)pdu->hdr + sizeof(coap_hdr_t) +
+                    coap_get_token_len(pdu);
+    int valid = coap_etag_match(opts, len - (opts - buf), etag, sizeof(etag));
+    gcoap_resp_init(pdu, buf, len, valid ? COAP_CODE_VALID : COAP_CODE_CONTENT);
+
+    ssize_t res;
+    if (valid) {
+        res = gcoap_finish(pdu, 0, COAP_FORMAT_NONE);
+    }
+    else {
+        /* leave room for the ETag option */
+        size_t payload_len = sensor_reg_json(&snap, (char *)pdu->payload,
+                                             len - (pdu->payload - buf) -
+                                             (1 + sizeof(etag)));
+        res = gcoap_finish(pdu, payload_len, COAP_FORMAT_JSON);
+    }
+    /* gcoap cannot add an ETag, insert it into the finished response */
+    if (res > 0) {
+        res = coap_etag_insert(buf, res, len, etag, sizeof(etag));
+    }
+    /* spread replies to group requests, see coap_group.h */
+    if ((res > 0) && (coap_group_defer(buf, res, leisure) == 0)) {
+        return 0;
+    }
+    return res;
 }
 
 void post_sensordata(char *data, char *path)
@@ -134,13 +179,41 @@ void post_sensordata(char *data, char *path)
     size_t len;
 
     gcoap_req_init(&pdu, &buf[0], GCOAP_PDU_BUF_SIZE, COAP_METHOD_POST, path);
-    memcpy(pdu.payload, data, strlen(data));
-    len = gcoap_finish(&pdu, strlen(data), COAP_FORMAT_JSON);
+    size_t data_len = strlen(data);
+    if (data_len > (size_t)(GCOAP_PDU_BUF_SIZE - (pdu.payload - buf))) {
+        puts("gcoap_cli: data too long");
+        return;
+    }
+    memcpy(pdu.payload, data, data_len);
+    len = gcoap_finish(&pdu, data_len, COAP_FORMAT_JSON);
     if (!_send(&buf[0], len, CONFIG_PROXY_ADDR, CONFIG_PROXY_PORT)) {
         puts("gcoap_cli: msg send failed");
     }
 }
 
+#ifdef MODULE_TINYDTLS
+static char coaps_thread_stack[COAPS_THREAD_STACKSIZE];
+
+/*
+ * Handles a decrypted request with the same resources as gcoap.
+ */
+static ssize_t _coaps_handler(uint8_t *buf, size_t len, size_t max)
+{
+    coap_pkt_t pdu;
+    if (coap_parse(&pdu, buf, len) < 0) {
+        return -1;
+    }
+    return coap_handle_req(&pdu, buf, max);
+}
+
+static void *_coaps_thread(void *arg)
+{
+    (void) arg;
+    coaps_run(_coaps_handler);
+    return NULL;
+}
+#endif /* MODULE_TINYDTLS */
+
 /**
  * @brief start CoAP thread
  *
@@ -148,6 +221,13 @@ void post_sensordata(char *data, char *path)
  */
 int coap_init(void)
 {
+    assert(coap_dispatch_check(coap_resources, coap_resources_numof,
+                               sizeof(coap_resources[0])) == 0);
     gcoap_register_listener(&_listener);
+#ifdef MODULE_TINYDTLS
+    thread_create(coaps_thread_stack, sizeof(coaps_thread_stack),
+                  THREAD_PRIORITY_MAIN - 1, THREAD_CREATE_STACKTEST,
+                  _coaps_thread, NULL, "coaps");
+#endif
     return 0;
 }
@@ -27,6 +27,11 @@
 #include "periph/gpio.h"
 #include "xtimer.h"
 // own
+#include "coap_group.h"
+#include "dlog.h"
+#include "node_info.h"
+#include "sensor_reg.h"
+#include "timesync.h"
 #include "config.h"
 
 #define COMM_PAN        (0x2121) // lowpan ID
@@ -38,27 +43,28 @@ extern int coap_init(void);
 extern int sensor_init(void);
 extern void post_sensordata(char *data, char *path);
 
-size_t node_get_info(char *buf)
+/**
+ * @brief get the first global unicast address of the radio
+ */
+static size_t _global_addr(char *buf, size_t len)
 {
-    puts("print_ipv6_addresses");
     ipv6_addr_t ipv6_addrs[GNRC_NETIF_IPV6_ADDRS_NUMOF];
     gnrc_netif_t *netif = gnrc_netif_iter(NULL);
-    size_t len = 0;
-    if (netif != NULL) {
-        kernel_pid_t iface = netif->pid;
-        int res = gnrc_netapi_get(iface, NETOPT_IPV6_ADDR, 0,
-                                  ipv6_addrs, sizeof(ipv6_addrs));
-        for (unsigned i = 0; i < (res / sizeof(ipv6_addr_t)); i++) {
-            if (ipv6_addr_is_global(&ipv6_addrs[i]) && !ipv6_addr_is_multicast(&ipv6_addrs[i])) {
-                char addr_str[IPV6_ADDR_MAX_STR_LEN];
-                ipv6_addr_to_str(addr_str, &ipv6_addrs[i], sizeof(addr_str));
-                //len += sprintf(buf+len, ", 'addr': '%s'", ipv6_addr_str);
-                len = sprintf(buf, "{'addr': '%s'}", addr_str);
-                break;
+    if (netif == NULL) {
+        return 0;
+    }
+    int res = gnrc_netapi_get(netif->pid, NETOPT_IPV6_ADDR, 0,
+                              ipv6_addrs, sizeof(ipv6_addrs));
+    for (int i = 0; i < (int)(res / sizeof(ipv6_addr_t)); i++) {
+        if (ipv6_addr_is_global(&ipv6_addrs[i]) &&
+                !ipv6_addr_is_multicast(&ipv6_addrs[i])) {
+            if (ipv6_addr_to_str(buf, &ipv6_addrs[i], len) == NULL) {
+                return 0;
             }
+            return strlen(buf);
         }
     }
-    return len;
+    return 0;
 }
 
 static int comm_init(void)
@@ -75,6 +81,14 @@ static int comm_init(void)
     /* initialize the radio */
     gnrc_netapi_set(iface, NETOPT_NID, 0, &pan, 2);
     gnrc_netapi_set(iface, NETOPT_CHANNEL, 0, &chan, 2);
+    /* answer CoAP group requests */
+    ipv6_addr_t group;
+    ipv6_addr_from_str(&group, COAP_GROUP_LINK);
+    gnrc_netif_ipv6_group_join(netif, &group);
+    ipv6_addr_from_str(&group, COAP_GROUP_SITE);
+    gnrc_netif_ipv6_group_join(netif, &group);
+    coap_group_init();
+    node_info_init(iface, _global_addr);
     return 0;
 }
 
@@ -88,12 +102,16 @@ int main(void)
     // some initial infos
     puts(" LGV RIOT Demo - Environmental Sensors");
     puts("======================================\n");
+    dlog_init();
     // init 6lowpan interface
     LED0_ON;
     LOG_INFO(".. init network\n");
     if (comm_init() != 0) {
         return 1;
     }
+    // sync time with the border router in the background
+    LOG_INFO(".. init timesync\n");
+    timesync_init();
     // start sensor thread
     LOG_INFO(".. init sensors\n");
     if ((sensor_pid = sensor_init()) < 0) {
@@ -114,14 +132,23 @@ int main(void)
         char strbuf[CONFIG_STRBUF_LEN];
         int pos = 0;
         int len = CONFIG_STRBUF_LEN - 1;
-        int t = sensor_get_temperature();
+        sensor_reg_snapshot_t snap;
+        sensor_reg_snapshot(&snap);
+        int t = snap.value[CONFIG_SENSOR_TEMPERATURE];
         memset(strbuf, '\0', CONFIG_STRBUF_LEN);
         pos += snprintf(strbuf, len, "{\"result\":");
         pos += fmt_s32_dfp((strbuf + pos), t, -2);
+        uint32_t now = timesync_now();
+        if (now) {
+            /* time of measurement, the averages are at most a sampling
+             * period old, the server stamps reception otherwise */
+            char time[TIMESYNC_STR_LEN];
+            timesync_fmt(now, time, sizeof(time));
+            pos += snprintf((strbuf + pos), (len - pos),
+                            ",\"phenomenonTime\":\"%s\"", time);
+        }
         pos += snprintf((strbuf + pos), (len -  pos),"}");
-        puts("> post temperature");
-        print_str(strbuf);
-        puts("");
+        DLOG_INFO("> post temperature %d\n", t);
         post_sensordata(strbuf, CONFIG_PATH_TEMPERATURE);
         /*
         memset(strbuf, '\0', 32);
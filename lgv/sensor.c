@@ -17,9 +17,7 @@
 #include "board.h"
 #include "periph_conf.h"
 #include "log.h"
-#include "mutex.h"
-#include "thread.h"
-#include "xtimer.h"
+#include "sensor_reg.h"
 
 #ifdef MODULE_HDC1000
 #include "hdc1000.h"
@@ -30,113 +28,72 @@ static hdc1000_t dev_hdc1000;
 #ifdef MODULE_TMP006
 #include "tmp006.h"
 #include "tmp006_params.h"
+#include "tmp006_fixed.h"
 static tmp006_t dev_tmp006;
 #endif
 
 #if !defined(MODULE_HDC1000) || !defined(MODULE_TMP006)
-#include "random.h"
+#include "sim.h"
 #endif
 
 #include "config.h"
 
-#define SENSOR_TIMEOUT_MS       (5 * US_PER_SEC)
+#define SENSOR_TIMEOUT_MS       (5 * MS_PER_SEC)
 #define SENSOR_NUM_SAMPLES      (10U)
-#define SENSOR_THREAD_STACKSIZE (3 * THREAD_STACKSIZE_DEFAULT)
-
-static int16_t samples_humidity[SENSOR_NUM_SAMPLES];
-static int16_t samples_temperature[SENSOR_NUM_SAMPLES];
-static mutex_t mutex;
-
-static char sensor_thread_stack[SENSOR_THREAD_STACKSIZE];
-
-/**
- * @brief get avg temperature over N samples in Celcius (C) with factor 100
- *
- * @return temperature
- */
-int sensor_get_temperature(void)
-{
-    int32_t sum = 0;
-    mutex_lock(&mutex);
-    for (unsigned i = 0; i < SENSOR_NUM_SAMPLES; i++) {
-        sum += samples_temperature[i];
-    }
-    mutex_unlock(&mutex);
-    return (int)(sum/SENSOR_NUM_SAMPLES);
-}
+/* bounds of adaptive sampling, sensors start at SENSOR_TIMEOUT_MS */
+#define SENSOR_PERIOD_MIN       (1 * MS_PER_SEC)
+#define SENSOR_PERIOD_MAX       (60 * MS_PER_SEC)
 
+#ifdef MODULE_HDC1000
 /**
- * @brief get avg humitity over N sampels in percent (%) with factor 100
+ * @brief Intialise the HDC1000
  *
- * @return humidity
+ * @return 0 on success, anything else on error
  */
-int sensor_get_humidity(void)
+static int _init_humidity(void)
 {
-    int32_t sum = 0;
-    mutex_lock(&mutex);
-    for (unsigned i = 0; i < SENSOR_NUM_SAMPLES; i++) {
-        sum += samples_humidity[i];
+    LOG_DEBUG("[SENSOR] _init_humidity\n");
+    if ((hdc1000_init(&dev_hdc1000, &hdc1000_params[0]) != 0)) {
+        LOG_ERROR("[SENSOR] HDC1000 init");
+        return 1;
     }
-    mutex_unlock(&mutex);
-    return (int)(sum/SENSOR_NUM_SAMPLES);
+    return 0;
 }
+#else
+#define _init_humidity      NULL
+#endif /* MODULE_HDC1000 */
 
 /**
- * @brief Measures the temperature and humitity with a HDC1000.
+ * @brief Measures the humitity with a HDC1000.
  *
- * @param[out] temp the measured temperature in degree celsius * 100
  * @param[out] hum the measured humitity in % * 100
+ *
+ * @return 0 on success, anything else on error
  */
-static int16_t _get_humidity(void) {
+static int _get_humidity(int32_t *hum)
+{
     int16_t h;
 #ifdef MODULE_HDC1000
     int16_t t;
     LOG_DEBUG("[SENSOR] _hdc1000_measure\n");
     hdc1000_read(&dev_hdc1000, &t, &h);
 #else
-    h = (int16_t) random_uint32_range(0, 10000);
+    static const sim_wave_t wave = SIM_WAVE_HUMIDITY;
+    h = sim_sample(&wave);
 #endif /* MODULE_HDC1000 */
-    return h;
-}
-
-/**
- * @brief Measures the temperature with a TMP006.
- *
- * @param[out] temp the measured temperature in degree celsius * 100
- */
-static int16_t _get_temperature(void)
-{
-    LOG_DEBUG("[SENSOR] _get_temperature\n");
-
-#ifdef MODULE_TMP006
-    int16_t ta, to;
-    /* read sensor, quit on error */
-    if (tmp006_read_temperature(&dev_tmp006, &ta, &to)) {
-        LOG_ERROR("[SENSOR] tmp006_read failed\n");
-        return 0;
-    }
-#else
-    int16_t to = (int16_t) random_uint32_range(0, 5000);
-#endif /* MODULE_TMP006 */
-    return to;
+    *hum = h;
+    return 0;
 }
 
 /**
- * @brief Intialise all sensores.
+ * @brief Intialise the TMP006, or the simulation if it is missing
  *
  * @return 0 on success, anything else on error
  */
-static int _init(void) {
-    LOG_DEBUG("[SENSOR] _init\n");
-#ifdef MODULE_HDC1000
-    /* initialise humidity sensor hdc1000 */
-    if ((hdc1000_init(&dev_hdc1000, &hdc1000_params[0]) != 0)) {
-        LOG_ERROR("[SENSOR] HDC1000 init");
-        return 1;
-    }
-#endif /* MODULE_HDC1000 */
+static int _init_temperature(void)
+{
+    LOG_DEBUG("[SENSOR] _init_temperature\n");
 #ifdef MODULE_TMP006
-    /* init temperature sensor tmp006 */
     if ((tmp006_init(&dev_tmp006, &tmp006_params[0]) != 0)) {
         LOG_ERROR("[SENSOR] TMP006 init");
         return 1;
@@ -146,56 +103,63 @@ static int _init(void) {
         return 1;
     }
 #endif /* MODULE_TMP006 */
-    mutex_lock(&mutex);
-    for (unsigned i = 0; i < SENSOR_NUM_SAMPLES; i++) {
-        xtimer_sleep(1);
-        samples_humidity[i]    = _get_humidity();
-        samples_temperature[i] = _get_temperature();
-    }
-    mutex_unlock(&mutex);
+#if !defined(MODULE_HDC1000) || !defined(MODULE_TMP006)
+    sim_init();
+#endif
     return 0;
 }
 
 /**
- * @brief udp receiver thread function
+ * @brief Measures the temperature with a TMP006.
+ *
+ * @param[out] temp the measured temperature in degree celsius * 100
  *
- * @param[in] arg   unused
+ * @return 0 on success, anything else on error
  */
-static void *sensor_thread(void *arg)
+static int _get_temperature(int32_t *temp)
 {
-    (void) arg;
-    unsigned count = 0;
-    xtimer_usleep(SENSOR_TIMEOUT_MS);
-    while(1) {
-        /* get latest sensor data */
-        mutex_lock(&mutex);
-        samples_temperature[count] = _get_temperature();
-        samples_humidity[count] = _get_humidity();
-        mutex_unlock(&mutex);
-        /* next round */
-        count = (count + 1) % SENSOR_NUM_SAMPLES;
-        if (count == 0) {
-            LOG_INFO("[SENSOR] raw data T: %d, H: %d\n",
-                     sensor_get_temperature(), sensor_get_humidity());
-        }
-        xtimer_usleep(SENSOR_TIMEOUT_MS);
+    LOG_DEBUG("[SENSOR] _get_temperature\n");
+#ifdef MODULE_TMP006
+    uint8_t drdy;
+    int16_t raw_temp, raw_volt;
+    /* read sensor, quit on error */
+    if (tmp006_read(&dev_tmp006, &raw_volt, &raw_temp, &drdy)) {
+        LOG_ERROR("[SENSOR] tmp006_read failed\n");
+        return 1;
     }
-    return NULL;
+    *temp = tmp006_fixed_object(raw_volt, raw_temp);
+#else
+    static const sim_wave_t wave = SIM_WAVE_TEMPERATURE;
+    *temp = sim_sample(&wave);
+#endif /* MODULE_TMP006 */
+    return 0;
 }
 
+/* sample faster while temperature changes by 0.1 C per sample or more */
+static const sensor_adapt_t adapt_temperature = {
+    .min = SENSOR_PERIOD_MIN, .max = SENSOR_PERIOD_MAX, .threshold = 10,
+};
+
+/* sample faster while humidity changes by 0.5 % per sample or more */
+static const sensor_adapt_t adapt_humidity = {
+    .min = SENSOR_PERIOD_MIN, .max = SENSOR_PERIOD_MAX, .threshold = 50,
+};
+
+static const sensor_reg_t sensors[] = {
+    { "temperature", "C", _init_temperature, _get_temperature,
+      100, SENSOR_TIMEOUT_MS, SENSOR_NUM_SAMPLES, &filter_temperature,
+      &adapt_temperature },
+    { "humidity", "%", _init_humidity, _get_humidity,
+      100, SENSOR_TIMEOUT_MS, SENSOR_NUM_SAMPLES, &filter_humidity,
+      &adapt_humidity },
+};
+
 /**
- * @brief start udp receiver thread
+ * @brief Intialise all sensors and start periodic measurements
  *
  * @return PID of sensor control thread
  */
 int sensor_init(void)
 {
-    /* init sensors */
-    if (_init() != 0) {
-        return -1;
-    }
-    /* start sensor thread for periodic measurements */
-    return thread_create(sensor_thread_stack, sizeof(sensor_thread_stack),
-                        THREAD_PRIORITY_MAIN-1, THREAD_CREATE_STACKTEST,
-                        sensor_thread, NULL, "sensor_thread");
+    return sensor_reg_init(sensors, sizeof(sensors) / sizeof(sensors[0]));
 }
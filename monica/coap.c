@@ -1,22 +1,36 @@
+#include <assert.h>
+#include <string.h>
+
 #include "log.h"
 #include "msg.h"
 #include "thread.h"
 #include "net/gcoap.h"
+#include "coap_dispatch.h"
+#include "coap_etag.h"
+#include "coap_group.h"
+#include "coaps.h"
+#include "dlog.h"
+#include "node_info.h"
+#include "sensor_reg.h"
 // own
 #include "monica.h"
 
 static ssize_t _info_handler(coap_pkt_t* pdu, uint8_t *buf, size_t len);
 static ssize_t _climate_handler(coap_pkt_t* pdu, uint8_t *buf, size_t len);
 
-/* CoAP resources */
-static const coap_resource_t _resources[] = {
+/* CoAP resources, gcoap expects them sorted by path, named as nanocoap
+ * expects them for coap_handle_req() of the coaps server */
+const coap_resource_t coap_resources[] = {
     { "/monica/climate", COAP_GET, _climate_handler },
     { "/monica/info", COAP_GET, _info_handler },
 };
 
+const unsigned coap_resources_numof = sizeof(coap_resources) /
+                                      sizeof(coap_resources[0]);
+
 static gcoap_listener_t _listener = {
-    (coap_resource_t *)&_resources[0],
-    sizeof(_resources) / sizeof(_resources[0]),
+    (coap_resource_t *)&coap_resources[0],
+    sizeof(coap_resources) / sizeof(coap_resources[0]),
     NULL
 };
 
@@ -26,10 +40,11 @@ static gcoap_listener_t _listener = {
  */
 static ssize_t _info_handler(coap_pkt_t* pdu, uint8_t *buf, size_t len)
 {
-    LOG_DEBUG("[CoAP] info_handler\n");
+    DLOG_DEBUG("[CoAP] info_handler\n");
     gcoap_resp_init(pdu, buf, len, COAP_CODE_CONTENT);
 
-    size_t payload_len = node_get_info((char *)pdu->payload);
+    size_t payload_len = node_info_get((char *)pdu->payload,
+                                       len - (pdu->payload - buf));
 
     return gcoap_finish(pdu, payload_len, COAP_FORMAT_JSON);
 }
@@ -40,13 +55,66 @@ static ssize_t _info_handler(coap_pkt_t* pdu, uint8_t *buf, size_t len)
  */
 static ssize_t _climate_handler(coap_pkt_t* pdu, uint8_t *buf, size_t len)
 {
-    LOG_DEBUG("[CoAP] climate_handler\n");
-    gcoap_resp_init(pdu, buf, len, COAP_CODE_CONTENT);
+    DLOG_DEBUG("[CoAP] climate_handler\n");
+    uint32_t leisure = coap_leisure_from_query((const char *)pdu->qs,
+                                               strlen((const char *)pdu->qs));
 
-    size_t payload_len = sprintf((char *)pdu->payload, "{'temperature': %d, 'humidity': %d}", sensor_get_temperature(), sensor_get_humidity());
+    sensor_reg_snapshot_t snap;
+    sensor_reg_snapshot(&snap);
+    uint8_t etag[COAP_ETAG_LEN];
+    coap_etag_from_gen(snap.gen, etag);
+    /* check the request options before the response overwrites them. The
+     * length of the request is unknown here, len is the size of buf; the
+     * walk ends at the Uri-Path option every dispatched request carries */
+    uint8_t *opts = (uint8_t *)pdu->hdr + sizeof(coap_hdr_t) +
+                    coap_get_token_len(pdu);
+    int valid = coap_etag_match(opts, len - (opts - buf), etag, sizeof(etag));
+    gcoap_resp_init(pdu, buf, len, valid ? COAP_CODE_VALID : COAP_CODE_CONTENT);
 
-    return gcoap_finish(pdu, payload_len, COAP_FORMAT_JSON);
+    ssize_t res;
+    if (valid) {
+        res = gcoap_finish(pdu, 0, COAP_FORMAT_NONE);
+    }
+    else {
+        /* leave room for the ETag option */
+        size_t payload_len = sensor_reg_json(&snap, (char *)pdu->payload,
+                                             len - (pdu->payload - buf) -
+                                             (1 + sizeof(etag)));
+        res = gcoap_finish(pdu, payload_len, COAP_FORMAT_JSON);
+    }
+    /* gcoap cannot add an ETag, insert it into the finished response */
+    if (res > 0) {
+        res = coap_etag_insert(buf, res, len, etag, sizeof(etag));
+    }
+    /* spread replies to group requests, see coap_group.h */
+    if ((res > 0) && (coap_group_defer(buf, res, leisure) == 0)) {
+        return 0;
+    }
+    return res;
+}
+
+#ifdef MODULE_TINYDTLS
+static char coaps_thread_stack[COAPS_THREAD_STACKSIZE];
+
+/*
+ * Handles a decrypted request with the same resources as gcoap.
+ */
+static ssize_t _coaps_handler(uint8_t *buf, size_t len, size_t max)
+{
+    coap_pkt_t pdu;
+    if (coap_parse(&pdu, buf, len) < 0) {
+        return -1;
+    }
+    return coap_handle_req(&pdu, buf, max);
+}
+
+static void *_coaps_thread(void *arg)
+{
+    (void) arg;
+    coaps_run(_coaps_handler);
+    return NULL;
 }
+#endif /* MODULE_TINYDTLS */
 
 /**
  * @brief start CoAP thread
@@ -55,6 +123,13 @@ static ssize_t _climate_handler(coap_pkt_t* pdu, uint8_t *buf, size_t len)
  */
 int coap_init(void)
 {
+    assert(coap_dispatch_check(coap_resources, coap_resources_numof,
+                               sizeof(coap_resources[0])) == 0);
     gcoap_register_listener(&_listener);
+#ifdef MODULE_TINYDTLS
+    thread_create(coaps_thread_stack, sizeof(coaps_thread_stack),
+                  THREAD_PRIORITY_MAIN - 1, THREAD_CREATE_STACKTEST,
+                  _coaps_thread, NULL, "coaps");
+#endif
     return 0;
 }
@@ -11,12 +11,15 @@
  */
 
 // standard
- #include <inttypes.h>
+ #include <errno.h>
+#include <inttypes.h>
  #include <stdio.h>
  #include <stdlib.h>
  #include <string.h>
 // riot
 #include "board.h"
+#include "event.h"
+#include "event/timeout.h"
 #include "log.h"
 #include "msg.h"
 #include "net/af.h"
@@ -25,8 +28,14 @@
 #include "net/gnrc/netif.h"
 #include "periph/gpio.h"
 #include "shell.h"
+#include "thread.h"
 #include "xtimer.h"
 // own
+#include "coap_group.h"
+#include "dlog.h"
+#include "node_info.h"
+#include "sensor_reg.h"
+#include "timesync.h"
 #include "monica.h"
 
 #ifndef BUTTON_MODE
@@ -40,105 +49,234 @@
 #define COMM_PAN        (0x17) // lowpan ID
 #define COMM_CHAN       (17U)  // channel
 
-static int sensor_pid = -1;
-static int mqtt_pid = -1;
-static int btn_pid = -1;
+static int mqtt_enabled = 0;
 
 extern int coap_init(void);
-extern int mqtt_init(void);
 extern int sensor_init(void);
 
 static int cmd_btn(int argc, char **argv);
-static char btn_thread_stack[MONICA_MQTT_STACKSIZE];
-msg_t btn_msg;
+static int cmd_stacks(int argc, char **argv);
+static int cmd_log(int argc, char **argv);
+static int cmd_mqtt(int argc, char **argv);
+
+static void _on_btn(event_t *event);
+static void _on_cmd(event_t *event);
+static void _on_pub(event_t *event);
+static void _on_sensor(event_t *event);
+
+static char event_thread_stack[MONICA_EVENT_STACKSIZE];
+static event_queue_t event_queue;
+static event_t event_btn = { .handler = _on_btn };
+static event_t event_cmd = { .handler = _on_cmd };
+static event_t event_pub = { .handler = _on_pub };
+static event_t event_sensor = { .handler = _on_sensor };
+static event_timeout_t timeout_pub;
+static event_timeout_t timeout_sensor;
+static uint32_t pub_interval = MONICA_PUB_INTERVAL;
 
 // array with available shell commands
 static const shell_command_t shell_commands[] = {
     { "btn", "soft trigger button", cmd_btn },
+    { "stacks", "show stack usage of all threads", cmd_stacks },
+    { "log", "show log counters", cmd_log },
+    { "mqtt", "show MQTT state and counters", cmd_mqtt },
+    { "sensors", "show sampling counters", sensor_reg_cmd },
+    { "info", "rebuild and show node info", node_info_cmd },
     { NULL, NULL, NULL }
 };
 
-size_t node_get_info(char *buf)
+/**
+ * @brief get the first global unicast address of the radio
+ */
+static size_t _global_addr(char *buf, size_t len)
 {
-    size_t len = 0;
     kernel_pid_t ifs[GNRC_NETIF_NUMOF];
-    size_t numof = gnrc_netif_get(ifs);
-    if (numof > 0) {
-        gnrc_ipv6_netif_t *entry = gnrc_ipv6_netif_get(ifs[0]);
-        char ipv6_addr_str[IPV6_ADDR_MAX_STR_LEN];
-        for (int i = 0; i < GNRC_IPV6_NETIF_ADDR_NUMOF; i++) {
-            if (ipv6_addr_is_global(&entry->addrs[i].addr) &&
-                    !ipv6_addr_is_multicast(&entry->addrs[i].addr) &&
-                    !(entry->addrs[i].flags & GNRC_IPV6_NETIF_ADDR_FLAGS_NON_UNICAST)) {
-                ipv6_addr_to_str(ipv6_addr_str, &entry->addrs[i].addr, IPV6_ADDR_MAX_STR_LEN);
-                //len += sprintf(buf+len, ", 'addr': '%s'", ipv6_addr_str);
-                len = sprintf(buf, "{'addr': '%s'}", ipv6_addr_str);
-                break;
+    if (gnrc_netif_get(ifs) == 0) {
+        return 0;
+    }
+    gnrc_ipv6_netif_t *entry = gnrc_ipv6_netif_get(ifs[0]);
+    for (int i = 0; i < GNRC_IPV6_NETIF_ADDR_NUMOF; i++) {
+        if (ipv6_addr_is_global(&entry->addrs[i].addr) &&
+                !ipv6_addr_is_multicast(&entry->addrs[i].addr) &&
+                !(entry->addrs[i].flags & GNRC_IPV6_NETIF_ADDR_FLAGS_NON_UNICAST)) {
+            if (ipv6_addr_to_str(buf, &entry->addrs[i].addr, len) == NULL) {
+                return 0;
             }
+            return strlen(buf);
         }
     }
-    return len;
+    return 0;
+}
+
+/**
+ * @brief publish node info and climate data
+ */
+static void _publish(void)
+{
+    char buf[MONICA_MQTT_SIZE];
+    /* publish riot info */
+    memset(buf, 0, MONICA_MQTT_SIZE);
+    node_info_get(buf, sizeof(buf));
+    mqtt_pub(MONICA_TOPIC_INFO, buf, MONICA_QOS_INFO);
+    /* publish climate data */
+    memset(buf, 0, MONICA_MQTT_SIZE);
+    sensor_reg_snapshot_t snap;
+    sensor_reg_snapshot(&snap);
+    sensor_reg_json(&snap, buf, MONICA_MQTT_SIZE);
+    mqtt_pub(MONICA_TOPIC_CLIMATE, buf, MONICA_QOS_CLIMATE);
 }
 
 /**
- * @brief processing button press
+ * @brief button pressed, first press enables MQTT, later ones publish
+ */
+static void _on_btn(event_t *event)
+{
+    (void) event;
+    if (mqtt_enabled) {
+        _publish();
+        return;
+    }
+    /* connects in the background, publishes are queued until then */
+    LOG_INFO(".. init mqtt.\n");
+    if (mqtt_init(&event_queue, &event_cmd) != 0) {
+        LOG_ERROR("!! init mqtt failed !!\n");
+        return;
+    }
+    mqtt_enabled = 1;
+    if (pub_interval > 0) {
+        event_timeout_set(&timeout_pub, pub_interval);
+    }
+}
+
+/**
+ * @brief apply one command, e.g., "pub=30", "period=500" or "led=1"
  *
- * @param[in] arg   unused
+ * @return 0 on success, -1 on unknown command or value
  */
-static void *btn_thread(void *arg)
+static int _apply_cmd(const char *cmd)
 {
-    (void) arg;
-    static msg_t msgq[4];
-    msg_init_queue(msgq, 4);
-
-    while(1) {
-        msg_t m;
-        msg_receive(&m);
-        if (mqtt_pid > 0) {
-            msg_t req, resp;
-            /* publish riot info */
-            char buf[MONICA_MQTT_SIZE];
-            memset(buf, 0, MONICA_MQTT_SIZE);
-            size_t len = node_get_info(buf);
-            (void) len;
-            monica_pub_t mpt_info = { .topic = "monica/info", .message = buf };
-            req.content.ptr = &mpt_info;
-            msg_send_receive(&req, &resp, mqtt_pid);
-            /* publish climate data */
-            memset(buf, 0, MONICA_MQTT_SIZE);
-            sprintf(buf, "{'temperature': %d, 'humidity': %d}", sensor_get_temperature(), sensor_get_humidity());
-            monica_pub_t mpt_climate = { .topic = "monica/climate", .message = buf };
-            req.content.ptr = &mpt_climate;
-            msg_send_receive(&req, &resp, mqtt_pid);
+    const char *eq = strchr(cmd, '=');
+    char *end;
+    /* digits only, strtoul would take "-1" as ULONG_MAX */
+    if ((eq == NULL) || (eq[1] < '0') || (eq[1] > '9')) {
+        return -1;
+    }
+    errno = 0;
+    unsigned long val = strtoul(eq + 1, &end, 10);
+    if ((*end != '\0') || (errno == ERANGE)) {
+        return -1;
+    }
+    size_t klen = eq - cmd;
+    if ((klen == 3) && (strncmp(cmd, "pub", 3) == 0)) {
+        /* publish interval in s, 0 publishes on button only */
+        if (val > (UINT32_MAX / US_PER_SEC)) {
+            return -1;
+        }
+        int armed = mqtt_enabled && (pub_interval > 0);
+        pub_interval = val * US_PER_SEC;
+        if (mqtt_enabled && (pub_interval > 0) && !armed) {
+            event_timeout_set(&timeout_pub, pub_interval);
+        }
+    }
+    else if ((klen == 6) && (strncmp(cmd, "period", 6) == 0)) {
+        /* fixed sampling period of all sensors in ms, 0 for adaptive,
+         * clamped to the adaptive range of each sensor */
+        if (val > SENSOR_REG_PERIOD_MAX) {
+            return -1;
+        }
+        for (unsigned i = 0; i < sensor_reg_numof(); i++) {
+            sensor_reg_set_period(i, val);
+        }
+        event_post(&event_queue, &event_sensor);
+    }
+    else if ((klen == 3) && (strncmp(cmd, "led", 3) == 0)) {
+        if (val > 1) {
+            return -1;
+        }
+        if (val) {
+            LED0_ON;
         }
         else {
-            // start mqtt thread
-            LOG_INFO(".. init mqtt.\n");
-            if((mqtt_pid = mqtt_init()) < 0) {
-                LOG_ERROR("!! init mqtt failed !!\n");
+            LED0_OFF;
+        }
+    }
+    else {
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief commands received via MQTT, separated by ',', ';' or space
+ */
+static void _on_cmd(event_t *event)
+{
+    (void) event;
+    char buf[MONICA_MQTT_SIZE + 1];
+    size_t len;
+    while ((len = mqtt_cmd_pop(buf, MONICA_MQTT_SIZE)) > 0) {
+        buf[len] = '\0';
+        for (char *cmd = strtok(buf, ",; "); cmd; cmd = strtok(NULL, ",; ")) {
+            if (_apply_cmd(cmd) != 0) {
+                LOG_WARNING("[CMD] invalid: %s\n", cmd);
             }
         }
     }
+}
+
+/**
+ * @brief periodic publish
+ */
+static void _on_pub(event_t *event)
+{
+    (void) event;
+    /* disabled by a command, re-armed when enabled again */
+    if (pub_interval == 0) {
+        return;
+    }
+    _publish();
+    event_timeout_set(&timeout_pub, pub_interval);
+}
+
+/**
+ * @brief sample sensors that are due and wait for the next one
+ */
+static void _on_sensor(event_t *event)
+{
+    (void) event;
+    event_timeout_set(&timeout_sensor, sensor_reg_tick());
+}
+
+/**
+ * @brief event loop handling button, publish and sensor events
+ *
+ * @param[in] arg   unused
+ */
+static void *event_thread(void *arg)
+{
+    (void) arg;
+    /* the queue belongs to the thread calling event_queue_init */
+    event_queue_init(&event_queue);
+    event_timeout_init(&timeout_pub, &event_queue, &event_pub);
+    event_timeout_init(&timeout_sensor, &event_queue, &event_sensor);
+    event_post(&event_queue, &event_sensor);
+    event_loop(&event_queue);
     return NULL;
 }
 
 #ifndef BOARD_NATIVE
 static void button_cb(void *arg)
 {
-    LOG_DEBUG("[BTN] button_cb: interrupt.\n");
+    DLOG_DEBUG("[BTN] button_cb: interrupt.\n");
     (void) arg;
-    msg_t *msg = (msg_t*)arg;
-    msg_send_int(msg, btn_pid);
+    event_post(&event_queue, &event_btn);
 }
 #endif /* BOARD_NATIVE */
 
 static int button_init(void)
 {
-    btn_pid = thread_create(btn_thread_stack, sizeof(btn_thread_stack),
-                            THREAD_PRIORITY_MAIN, THREAD_CREATE_STACKTEST,
-                            btn_thread, NULL, "btn_thread");
 #ifndef BOARD_NATIVE
-    if (gpio_init_int(BUTTON_GPIO, BUTTON_MODE, GPIO_FALLING, button_cb, (void *)&btn_msg) < 0) {
+    if (gpio_init_int(BUTTON_GPIO, BUTTON_MODE, GPIO_FALLING, button_cb, NULL) < 0) {
         LOG_ERROR("[BTN] !! failed to init button GPIO !!\n");
         return 1;
     }
@@ -159,6 +297,16 @@ static int comm_init(void)
     /* initialize the radio */
     gnrc_netapi_set(ifs[0], NETOPT_NID, 0, &pan, 2);
     gnrc_netapi_set(ifs[0], NETOPT_CHANNEL, 0, &chan, 2);
+    /* answer CoAP group requests */
+    ipv6_addr_t group;
+    ipv6_addr_from_str(&group, COAP_GROUP_LINK);
+    gnrc_ipv6_netif_add_addr(ifs[0], &group, IPV6_ADDR_BIT_LEN,
+                             GNRC_IPV6_NETIF_ADDR_FLAGS_NON_UNICAST);
+    ipv6_addr_from_str(&group, COAP_GROUP_SITE);
+    gnrc_ipv6_netif_add_addr(ifs[0], &group, IPV6_ADDR_BIT_LEN,
+                             GNRC_IPV6_NETIF_ADDR_FLAGS_NON_UNICAST);
+    coap_group_init();
+    node_info_init(ifs[0], _global_addr);
     return 0;
 }
 
@@ -166,8 +314,57 @@ int cmd_btn(int argc, char **argv)
 {
     (void) argc;
     (void) argv;
-    msg_t *msg = (msg_t*)&btn_msg;
-    msg_send(msg, btn_pid);
+    event_post(&event_queue, &event_btn);
+    return 0;
+}
+
+int cmd_stacks(int argc, char **argv)
+{
+    (void) argc;
+    (void) argv;
+#ifdef DEVELHELP
+    /* threads created with THREAD_CREATE_STACKTEST only */
+    printf("%-16s %6s %6s\n", "thread", "size", "used");
+    for (kernel_pid_t pid = KERNEL_PID_FIRST; pid <= KERNEL_PID_LAST; pid++) {
+        volatile thread_t *t = thread_get(pid);
+        if (t == NULL) {
+            continue;
+        }
+        int used = t->stack_size - thread_measure_stack_free(t->stack_start);
+        printf("%-16s %6d %6d\n", t->name, t->stack_size, used);
+    }
+#else
+    puts("stack usage needs DEVELHELP=1");
+#endif
+    return 0;
+}
+
+int cmd_log(int argc, char **argv)
+{
+    (void) argc;
+    (void) argv;
+    dlog_stats_t stats;
+    dlog_stats(&stats);
+    printf("lines: %lu, repeated: %lu, dropped: %lu\n",
+           (unsigned long)stats.lines, (unsigned long)stats.repeated,
+           (unsigned long)stats.dropped);
+    return 0;
+}
+
+int cmd_mqtt(int argc, char **argv)
+{
+    (void) argc;
+    (void) argv;
+    static const char *states[] = { "disconnected", "connecting", "connected" };
+    mqtt_stats_t stats;
+    mqtt_stats(&stats);
+    printf("%s, connects: %lu\n", mqtt_enabled ? states[mqtt_state()] : "disabled",
+           (unsigned long)stats.connects);
+    printf("queued: %lu, published: %lu, delivered: %lu, retried: %lu, "
+           "dropped: %lu, commands: %lu\n", (unsigned long)stats.queued,
+           (unsigned long)stats.published, (unsigned long)stats.delivered,
+           (unsigned long)stats.retried, (unsigned long)stats.dropped,
+           (unsigned long)stats.commands);
     return 0;
 }
 
@@ -181,15 +378,26 @@ int main(void)
     // some initial infos
     puts(" MONICA RIOT Demo - showing CoAP and MQTT ");
     puts("==========================================\n");
+    dlog_init();
     // init 6lowpan interface
     LED0_ON;
     LOG_INFO(".. init network\n");
     if (comm_init() != 0) {
         return 1;
     }
-    // start sensor thread
+    // sync time with the border router in the background
+    LOG_INFO(".. init timesync\n");
+    timesync_init();
+    // init sensors, sampled by the event thread
     LOG_INFO(".. init sensors\n");
-    if ((sensor_pid = sensor_init()) < 0) {
+    if (sensor_init() != 0) {
+        return 1;
+    }
+    // start event thread
+    LOG_INFO(".. init events\n");
+    if (thread_create(event_thread_stack, sizeof(event_thread_stack),
+                      MONICA_EVENT_PRIO, THREAD_CREATE_STACKTEST,
+                      event_thread, NULL, "event_thread") < 0) {
         return 1;
     }
     // start coap thread
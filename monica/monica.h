@@ -1,18 +1,106 @@
 #ifndef MONICA_H
 #define MONICA_H
 
+#include <stddef.h>
+#include <stdint.h>
+
+#include "event.h"
+#include "coap_udp.h"
+#include "node_info.h"
+
 #define MONICA_MQTT_ADDR        "fd17:cafe:cafe:3::1"
 #define MONICA_MQTT_PORT        (1885U)
-#define MONICA_MQTT_SIZE        (64U)
-#define MONICA_MQTT_STACKSIZE   (3*THREAD_STACKSIZE_DEFAULT)
+/* fits the node info, see node_info.h */
+#define MONICA_MQTT_SIZE        (NODE_INFO_LEN)
+/* button, periodic publish and sensor sampling share the event thread, the
+ * deepest handler takes 328 B besides printf, see README.md */
+#ifndef MONICA_EVENT_STACKSIZE
+#define MONICA_EVENT_STACKSIZE  (THREAD_STACKSIZE_DEFAULT + \
+                                 THREAD_EXTRA_STACKSIZE_PRINTF)
+#endif
+#define MONICA_EVENT_PRIO       (THREAD_PRIORITY_MAIN - 1)
+/* publish interval in us once MQTT is enabled, 0 to publish on button only */
+#ifndef MONICA_PUB_INTERVAL
+#define MONICA_PUB_INTERVAL     (60U * US_PER_SEC)
+#endif
+
+/* MQTT-SN runs in its own thread, publishing never waits for the broker,
+ * 816 B besides printf and emcute, most of it the packet of _send() */
+#ifndef MONICA_MQTT_STACKSIZE
+#define MONICA_MQTT_STACKSIZE   (THREAD_STACKSIZE_DEFAULT + \
+                                 THREAD_EXTRA_STACKSIZE_PRINTF)
+#endif
+#define MONICA_MQTT_PRIO        (THREAD_PRIORITY_MAIN - 1)
+/* messages kept while the broker is unreachable, the oldest are dropped */
+#define MONICA_MQTT_QUEUE_SIZE  (4U)
+#define MONICA_MQTT_TOPICS (4U)
+/* reconnect backoff in us, doubled after every failed attempt */
+#define MONICA_MQTT_BACKOFF_MIN (1U * US_PER_SEC)
+#define MONICA_MQTT_BACKOFF_MAX (64U * US_PER_SEC)
+/* messages are published in an MQTT-SN session of their own on this port,
+ * emcute serves the command subscriptions only */
+#define MONICA_MQTT_PUB_PORT    (1884U)
+/* QoS 1 messages sent without waiting for the PUBACK of earlier ones */
+#ifndef MONICA_MQTT_WINDOW
+#define MONICA_MQTT_WINDOW      (4U)
+#endif
+/* retransmission timeout in us, QoS 1 messages are sent again with DUP */
+#ifndef MONICA_MQTT_RETRY
+#define MONICA_MQTT_RETRY       (2U * US_PER_SEC)
+#endif
+/* transmissions per message, also of CONNECT and REGISTER, without an
+ * answer to the last one the broker is considered lost */
+#define MONICA_MQTT_TRIES       (3U)
+/* keepalive of the publisher session in s, announced in CONNECT */
+#define MONICA_MQTT_KEEPALIVE   (60U)
+/* a PINGREQ is sent after this many us without a packet from the broker,
+ * without a PINGRESP the session is lost and the thread reconnects emcute
+ * and subscribes again */
+#define MONICA_MQTT_PING        (MONICA_MQTT_KEEPALIVE * US_PER_SEC / 2)
+
+/* topics and their QoS, 0 or 1, published as monica/<id>/<topic> */
+#define MONICA_TOPIC_INFO       "info"
+#ifndef MONICA_QOS_INFO
+#define MONICA_QOS_INFO         (0U)
+#endif
+#define MONICA_TOPIC_CLIMATE    "climate"
+#ifndef MONICA_QOS_CLIMATE
+#define MONICA_QOS_CLIMATE      (1U)
+#endif
+/* commands to all nodes, each node also subscribes monica/<id>/cmd */
+#define MONICA_TOPIC_CMD        "monica/cmd"
+/* commands received but not yet handled by the event thread */
+#define MONICA_CMD_QUEUE_SIZE   (2U)
+
+typedef enum {
+    MQTT_DISCONNECTED,
+    MQTT_CONNECTING,
+    MQTT_CONNECTED,
+} mqtt_state_t;
 
-int sensor_get_temperature(void);
-int sensor_get_humidity(void);
-size_t node_get_info(char *buf);
+typedef struct {
+    uint32_t queued;        /**< messages accepted by mqtt_pub */
+    uint32_t published;     /**< QoS 0 messages sent to the broker */
+    uint32_t delivered;     /**< QoS 1 messages acknowledged by the broker */
+    uint32_t retried;       /**< retransmissions of unacknowledged messages */
+    uint32_t dropped;       /**< messages lost to a full queue or errors */
+    uint32_t commands;      /**< commands received */
+    uint32_t connects;      /**< successful (re)connects */
+} mqtt_stats_t;
 
-typedef struct monica_pub {
-    char *topic;
-    char *message;
-} monica_pub_t;
+int mqtt_init(event_queue_t *queue, event_t *on_cmd);
+/* get the next received command, returns its length, 0 if there is none */
+size_t mqtt_cmd_pop(char *buf, size_t len);
+/* queue a message with QoS 0 or 1 to monica/<id>/<topic>, topic must be of
+ * static storage */
+int mqtt_pub(const char *topic, const char *message, unsigned qos);
+mqtt_state_t mqtt_state(void);
+void mqtt_stats(mqtt_stats_t *stats);
+/* publisher session, driven by the MQTT thread, public for tests: send
+ * CONNECT, handle a datagram from the broker, and send due retransmissions,
+ * pings and queued messages */
+void mqtt_session_start(void);
+void mqtt_input(const coap_udp_dgram_t *dgram);
+void mqtt_tick(void);
 
 #endif /* MONICA_H */
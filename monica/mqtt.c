@@ -1,100 +1,815 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "event.h"
 #include "log.h"
 #include "msg.h"
+#include "mutex.h"
 #include "net/emcute.h"
+#include "net/gnrc/netapi.h"
+#include "net/gnrc/pktbuf.h"
 #include "net/ipv6/addr.h"
 #include "thread.h"
+#include "xtimer.h"
+#ifdef MODULE_PERIPH_CPUID
+#include "periph/cpuid.h"
+#endif
 // own
+#include "coap_udp.h"
 #include "monica.h"
 
 #define EMCUTE_PORT         (1883U)
-#define EMCUTE_ID           ("eve")
 #define EMCUTE_PRIO         (THREAD_PRIORITY_MAIN - 1)
+#define NODE_ID_LEN         (8U)    /* hex digits, from the CPU ID */
+/* monica/<id>/<topic>, the longest topic is "climate" */
+#define TOPIC_NAME_LEN      (sizeof("monica//climate") + NODE_ID_LEN)
+
+#define MQTT_QUEUE_SIZE     (8U)        /**< messages of the MQTT thread */
+#define MQTT_MSG_WAKEUP     (0x4d51)    /**< mqtt_pub() queued a message */
+#define MQTT_MSG_TIMER      (0x4d52)    /**< a retransmission or ping is due */
+
+/* MQTT-SN 1.2 packets of the publisher session */
+#define SN_CONNECT          (0x04)
+#define SN_CONNACK          (0x05)
+#define SN_REGISTER         (0x0a)
+#define SN_REGACK           (0x0b)
+#define SN_PUBLISH          (0x0c)
+#define SN_PUBACK           (0x0d)
+#define SN_PINGREQ          (0x16)
+#define SN_PINGRESP         (0x17)
+#define SN_DISCONNECT       (0x18)
+#define SN_FLAG_DUP         (0x80)
+#define SN_FLAG_QOS_1       (0x20)
+#define SN_FLAG_CLEAN       (0x04)
+#define SN_PROTOCOL_ID      (0x01)
+#define SN_ACCEPTED         (0x00)
+#define SN_CONGESTION       (0x01)
+#define SN_INVALID_TOPIC    (0x02)
+#define SN_HDR_MAX          (4U)        /**< 3 byte length and type */
+#define SN_BODY_MAX         (5U)        /**< fields of PUBLISH */
 
 static char stack[THREAD_STACKSIZE_DEFAULT];
-static char mqtt_thread_stack[MONICA_MQTT_STACKSIZE];
 static int emcute_pid = -1;
 
+/**
+ * @brief a message waiting to be published
+ */
+typedef struct {
+    const char *topic;              /**< topic name, static storage */
+    size_t len;                     /**< length of data */
+    uint8_t qos;                    /**< QoS, 0 or 1 */
+    uint8_t tries;                  /**< transmissions so far */
+    char data[MONICA_MQTT_SIZE];    /**< message */
+} mqtt_msg_t;
+
+/**
+ * @brief a QoS 1 message sent but not acknowledged yet
+ */
+typedef struct {
+    mqtt_msg_t msg;                 /**< the message */
+    uint16_t id;                    /**< message ID, 0 for a free slot */
+    uint16_t topic;                 /**< topic ID it was sent to */
+    uint32_t due;                   /**< time of the next retransmission */
+} mqtt_inflight_t;
+
+/**
+ * @brief a registered topic, IDs are valid for one connection
+ */
+typedef struct {
+    const char *name;               /**< topic name, NULL if unused */
+    uint16_t id;                    /**< topic ID assigned by the broker */
+} mqtt_topic_t;
+
+static char mqtt_stack[MONICA_MQTT_STACKSIZE];
+static kernel_pid_t mqtt_pid = KERNEL_PID_UNDEF;
+static msg_t mqtt_msg_queue[MQTT_QUEUE_SIZE];
+static mqtt_state_t state = MQTT_DISCONNECTED;
+static mqtt_stats_t stats;
+
+static mqtt_msg_t queue[MONICA_MQTT_QUEUE_SIZE];
+static unsigned queue_head;
+static unsigned queue_count;
+static mutex_t queue_lock = MUTEX_INIT;
+
+/* used by the MQTT thread only */
+static mqtt_topic_t topics[MONICA_MQTT_TOPICS];
+static mqtt_inflight_t window[MONICA_MQTT_WINDOW];
+static uint16_t last_id;
+static ipv6_addr_t broker;
+static xtimer_t timer;
+static msg_t timer_msg = { .type = MQTT_MSG_TIMER };
+static uint32_t heard;  /* time of the last packet from the broker */
+static uint32_t backoff = MONICA_MQTT_BACKOFF_MIN;
+static unsigned fails;
+
+/* CONNECT, REGISTER or PINGREQ of the publisher session waiting for its
+ * answer */
+static struct {
+    uint8_t type;                   /**< SN_CONNECT, ..., 0 if none */
+    uint8_t tries;                  /**< transmissions so far */
+    uint16_t id;                    /**< message ID of REGISTER */
+    const char *topic;              /**< topic name of REGISTER */
+    uint32_t due;                   /**< time of the next retransmission */
+} pending;
+
+static char node_id[NODE_ID_LEN + 1];
+static char client_id[sizeof("monica-") + NODE_ID_LEN];
+static char pub_client_id[sizeof("monica--pub") + NODE_ID_LEN];
+static char topic_cmd_node[sizeof("monica//cmd") + NODE_ID_LEN];
+static emcute_sub_t subs[2];
+static unsigned subscribed;
+
+/* commands received by emcute, handled by the thread owning cmd_queue */
+static struct {
+    size_t len;
+    char data[MONICA_MQTT_SIZE];
+} cmds[MONICA_CMD_QUEUE_SIZE];
+static unsigned cmds_head;
+static unsigned cmds_count;
+static mutex_t cmds_lock = MUTEX_INIT;
+static event_queue_t *cmd_queue;
+static event_t *cmd_event;
+
+/**
+ * @brief connect to the broker, blocks until connected or timed out
+ *
+ * @return EMCUTE_OK on success, error of emcute otherwise
+ */
 static int _con(void)
 {
     LOG_DEBUG("[MQTT] try connect to broker ...\n");
     sock_udp_ep_t gw = { .family = AF_INET6, .port = MONICA_MQTT_PORT };
-    char *addr = "fd17:cafe:cafe:3::1";
     /* parse broker address */
-    if (ipv6_addr_from_str((ipv6_addr_t *)&gw.addr.ipv6, addr) == NULL) {
+    if (ipv6_addr_from_str((ipv6_addr_t *)&gw.addr.ipv6, MONICA_MQTT_ADDR) == NULL) {
         LOG_ERROR("[MQTT] failed to parse broker address!\n");
-        return 1;
+        return EMCUTE_NOGW;
     }
     /* connect to broker */
-    if (emcute_con(&gw, true, NULL, NULL, 0, 0) != EMCUTE_OK) {
-        LOG_ERROR("[MQTT] failed to connect to broker!\n");
-        return 1;
+    int res = emcute_con(&gw, true, NULL, NULL, 0, 0);
+    if (res != EMCUTE_OK) {
+        LOG_WARNING("[MQTT] failed to connect to broker!\n");
+        return res;
     }
-    LOG_DEBUG(" ... successs.\n");
-    return 0;
+    LOG_INFO("[MQTT] connected.\n");
+    return EMCUTE_OK;
 }
 
-static int _pub(monica_pub_t *mpt)
+/**
+ * @brief command received, runs in the emcute thread so only queue it
+ */
+static void _on_cmd(const emcute_topic_t *topic, void *data, size_t len)
 {
-    LOG_DEBUG("[MQTT] pub (%s,%s)\n", mpt->topic, mpt->message);
-    emcute_topic_t t;
-    unsigned flags = EMCUTE_QOS_0;
-    /* get topic id */
-    t.name = mpt->topic;
-    if (emcute_reg(&t) != EMCUTE_OK) {
-        LOG_ERROR("[MQTT] pub: unable to obtain topic ID");
-        return 1;
+    (void) topic;
+    if (len > MONICA_MQTT_SIZE) {
+        LOG_WARNING("[MQTT] command too long\n");
+        return;
     }
-    /* publish data */
-    if (emcute_pub(&t, mpt->message, strlen(mpt->message), flags) != EMCUTE_OK) {
-        LOG_ERROR("[MQTT] pub: unable to publish data to topic '%s [%i]'\n",
-                  t.name, (int)t.id);
-        return 1;
+    mutex_lock(&cmds_lock);
+    int full = (cmds_count == MONICA_CMD_QUEUE_SIZE);
+    if (!full) {
+        unsigned i = (cmds_head + cmds_count) % MONICA_CMD_QUEUE_SIZE;
+        memcpy(cmds[i].data, data, len);
+        cmds[i].len = len;
+        cmds_count++;
+    }
+    mutex_unlock(&cmds_lock);
+    mutex_lock(&queue_lock);
+    stats.commands++;
+    stats.dropped += full;
+    mutex_unlock(&queue_lock);
+    event_post(cmd_queue, cmd_event);
+}
+
+/**
+ * @brief subscribe to the command topics, again after every connect
+ */
+static void _subscribe(void)
+{
+    for (unsigned i = 0; i < (sizeof(subs) / sizeof(subs[0])); i++) {
+        /* emcute keeps a list of subscriptions, the entry of the previous
+         * session must be removed before it can be added again */
+        if ((subscribed & (1U << i)) && (emcute_unsub(&subs[i]) != EMCUTE_OK)) {
+            continue;
+        }
+        subscribed &= ~(1U << i);
+        if (emcute_sub(&subs[i], EMCUTE_QOS_1) == EMCUTE_OK) {
+            subscribed |= (1U << i);
+        }
+        else {
+            LOG_WARNING("[MQTT] failed to subscribe to %s\n", subs[i].topic.name);
+        }
+    }
+}
+
+static uint16_t _get_u16(const uint8_t *buf)
+{
+    return ((uint16_t)buf[0] << 8) | buf[1];
+}
+
+static void _put_u16(uint8_t *buf, uint16_t val)
+{
+    buf[0] = val >> 8;
+    buf[1] = val & 0xff;
+}
+
+/**
+ * @brief send a packet of the publisher session to the broker
+ *
+ * @param[in] type      MQTT-SN message type
+ * @param[in] body      fields after the type
+ * @param[in] body_len  length of body, at most SN_BODY_MAX
+ * @param[in] data      payload after the fields, e.g., client ID or message
+ * @param[in] data_len  length of data, at most MONICA_MQTT_SIZE
+ */
+static void _send(uint8_t type, const uint8_t *body, size_t body_len,
+                  const void *data, size_t data_len)
+{
+    uint8_t pkt[SN_HDR_MAX + SN_BODY_MAX + MONICA_MQTT_SIZE];
+    size_t len = 2 + body_len + data_len;
+    size_t pos = 0;
+    if (len > 0xff) {
+        len += 2;
+        pkt[pos++] = 0x01;
+        _put_u16(&pkt[pos], len);
+        pos += 2;
+    }
+    else {
+        pkt[pos++] = len;
+    }
+    pkt[pos++] = type;
+    if (body_len > 0) {
+        memcpy(&pkt[pos], body, body_len);
+    }
+    if (data_len > 0) {
+        memcpy(&pkt[pos + body_len], data, data_len);
+    }
+    if (coap_udp_send_from(MONICA_MQTT_PUB_PORT, &broker, MONICA_MQTT_PORT,
+                           pkt, len) < 0) {
+        LOG_WARNING("[MQTT] failed to send 0x%02x\n", type);
+    }
+}
+
+static uint16_t _next_id(void)
+{
+    if (++last_id == 0) {
+        last_id = 1;
+    }
+    return last_id;
+}
+
+/**
+ * @brief get the ID of a topic registered in this session, 0 if there is none
+ */
+static uint16_t _topic_id(const char *name)
+{
+    for (unsigned i = 0; i < MONICA_MQTT_TOPICS; i++) {
+        if ((topics[i].name != NULL) && (strcmp(topics[i].name, name) == 0)) {
+            return topics[i].id;
+        }
     }
-    LOG_DEBUG("[MQTT] publish success.\n");
     return 0;
 }
 
-static void *emcute_thread(void *arg)
+/**
+ * @brief remember the ID of a topic, id 0 forgets it
+ */
+static void _topic_set(const char *name, uint16_t id)
 {
-    (void)arg;
-    emcute_run(EMCUTE_PORT, EMCUTE_ID);
-    return NULL;    /* should never be reached */
+    mqtt_topic_t *slot = &topics[0];
+    for (unsigned i = 0; i < MONICA_MQTT_TOPICS; i++) {
+        if ((topics[i].name != NULL) && (strcmp(topics[i].name, name) == 0)) {
+            slot = &topics[i];
+            break;
+        }
+        if (topics[i].name == NULL) {
+            slot = &topics[i];
+        }
+    }
+    slot->name = (id != 0) ? name : NULL;
+    slot->id = id;
+}
+
+/**
+ * @brief (re)send the pending CONNECT, REGISTER or PINGREQ
+ */
+static void _send_pending(void)
+{
+    uint8_t body[4];
+    if (pending.type == SN_CONNECT) {
+        body[0] = SN_FLAG_CLEAN;
+        body[1] = SN_PROTOCOL_ID;
+        _put_u16(&body[2], MONICA_MQTT_KEEPALIVE);
+        _send(SN_CONNECT, body, 4, pub_client_id, strlen(pub_client_id));
+    }
+    else if (pending.type == SN_PINGREQ) {
+        /* without client ID, that would announce waking up from sleep */
+        _send(SN_PINGREQ, NULL, 0, NULL, 0);
+    }
+    else {
+        /* monica/<id>/<name>, later only the ID is used */
+        char full[TOPIC_NAME_LEN];
+        size_t len = snprintf(full, sizeof(full), "monica/%s/%s", node_id,
+                              pending.topic);
+        _put_u16(&body[0], 0);
+        _put_u16(&body[2], pending.id);
+        _send(SN_REGISTER, body, 4, full,
+              (len < sizeof(full)) ? len : sizeof(full) - 1);
+    }
+    pending.tries++;
+    pending.due = xtimer_now_usec() + MONICA_MQTT_RETRY;
+}
+
+/**
+ * @brief (re)send a message of the window
+ */
+static void _send_publish(mqtt_inflight_t *f, uint8_t dup)
+{
+    uint8_t body[SN_BODY_MAX];
+    body[0] = SN_FLAG_QOS_1 | dup;
+    _put_u16(&body[1], f->topic);
+    _put_u16(&body[3], f->id);
+    _send(SN_PUBLISH, body, sizeof(body), f->msg.data, f->msg.len);
+    f->msg.tries++;
+    f->due = xtimer_now_usec() + MONICA_MQTT_RETRY;
+}
+
+/**
+ * @brief put a message back in front, to send it again after reconnecting
+ */
+static void _requeue(const mqtt_msg_t *m)
+{
+    mutex_lock(&queue_lock);
+    if (queue_count < MONICA_MQTT_QUEUE_SIZE) {
+        queue_head = (queue_head + MONICA_MQTT_QUEUE_SIZE - 1) % MONICA_MQTT_QUEUE_SIZE;
+        queue[queue_head] = *m;
+        queue_count++;
+    }
+    else {
+        /* filled up while it was in flight, this one is the oldest */
+        stats.dropped++;
+    }
+    mutex_unlock(&queue_lock);
+}
+
+/**
+ * @brief arm the timer for the earliest retransmission or ping
+ */
+static void _arm(void)
+{
+    int armed = (pending.type != 0);
+    uint32_t due = pending.due;
+    if (!armed && (state == MQTT_CONNECTED)) {
+        /* check the broker is still there once it was quiet for a while */
+        due = heard + MONICA_MQTT_PING;
+        armed = 1;
+    }
+    for (unsigned i = 0; i < MONICA_MQTT_WINDOW; i++) {
+        if ((window[i].id != 0) &&
+            (!armed || ((int32_t)(window[i].due - due) < 0))) {
+            due = window[i].due;
+            armed = 1;
+        }
+    }
+    if (!armed) {
+        xtimer_remove(&timer);
+        return;
+    }
+    int32_t delay = due - xtimer_now_usec();
+    xtimer_set_msg(&timer, (delay > (int32_t)US_PER_MS) ? (uint32_t)delay : US_PER_MS,
+                   &timer_msg, mqtt_pid);
+}
+
+/**
+ * @brief the broker is gone, requeue the window and let the thread reconnect
+ */
+static void _lost(void)
+{
+    LOG_WARNING("[MQTT] broker lost, reconnecting\n");
+    /* newest first, such that the oldest ends up in front */
+    while (1) {
+        mqtt_inflight_t *newest = NULL;
+        for (unsigned i = 0; i < MONICA_MQTT_WINDOW; i++) {
+            if ((window[i].id != 0) && ((newest == NULL) ||
+                ((uint16_t)(last_id - window[i].id) <
+                 (uint16_t)(last_id - newest->id)))) {
+                newest = &window[i];
+            }
+        }
+        if (newest == NULL) {
+            break;
+        }
+        _requeue(&newest->msg);
+        newest->id = 0;
+    }
+    pending.type = 0;
+    xtimer_remove(&timer);
+    _send(SN_DISCONNECT, NULL, 0, NULL, 0);
+    emcute_discon();
+    state = MQTT_DISCONNECTED;
+}
+
+/**
+ * @brief send queued messages while the window has room
+ */
+static void _fill(void)
+{
+    /* a REGISTER replaces a pending PINGREQ, its REGACK shows the same */
+    while ((state == MQTT_CONNECTED) &&
+           ((pending.type == 0) || (pending.type == SN_PINGREQ))) {
+        mqtt_inflight_t *slot = NULL;
+        for (unsigned i = 0; (i < MONICA_MQTT_WINDOW) && !slot; i++) {
+            slot = (window[i].id == 0) ? &window[i] : NULL;
+        }
+        mqtt_msg_t m;
+        mutex_lock(&queue_lock);
+        if (queue_count == 0) {
+            mutex_unlock(&queue_lock);
+            return;
+        }
+        /* decide under the lock, mqtt_pub() may drop the head meanwhile */
+        const mqtt_msg_t *head = &queue[queue_head];
+        if (head->tries >= MONICA_MQTT_TRIES) {
+            /* sent as often as allowed before the broker was lost */
+            queue_head = (queue_head + 1) % MONICA_MQTT_QUEUE_SIZE;
+            queue_count--;
+            stats.dropped++;
+            mutex_unlock(&queue_lock);
+            continue;
+        }
+        uint16_t topic = _topic_id(head->topic);
+        if (topic == 0) {
+            pending.topic = head->topic;
+            mutex_unlock(&queue_lock);
+            pending.type = SN_REGISTER;
+            pending.tries = 0;
+            pending.id = _next_id();
+            _send_pending();
+            return;
+        }
+        if (head->qos && (slot == NULL)) {
+            mutex_unlock(&queue_lock);
+            return;
+        }
+        m = *head;
+        queue_head = (queue_head + 1) % MONICA_MQTT_QUEUE_SIZE;
+        queue_count--;
+        /* sent before the broker was lost */
+        stats.retried += (m.tries > 0);
+        stats.published += !m.qos;
+        mutex_unlock(&queue_lock);
+        if (!m.qos) {
+            uint8_t body[SN_BODY_MAX] = { 0 };
+            _put_u16(&body[1], topic);
+            _send(SN_PUBLISH, body, sizeof(body), m.data, m.len);
+            continue;
+        }
+        slot->msg = m;
+        slot->id = _next_id();
+        slot->topic = topic;
+        _send_publish(slot, 0);
+    }
 }
 
 /**
- * @brief udp receiver thread function
+ * @brief handle the PUBACK of a message in the window
+ */
+static void _puback(uint16_t id, uint8_t rc)
+{
+    for (unsigned i = 0; i < MONICA_MQTT_WINDOW; i++) {
+        mqtt_inflight_t *f = &window[i];
+        if (f->id != id) {
+            continue;
+        }
+        if (rc == SN_CONGESTION) {
+            /* sent again when due */
+            return;
+        }
+        if (rc == SN_INVALID_TOPIC) {
+            /* register again, then send it as a new message */
+            _topic_set(f->msg.topic, 0);
+            _requeue(&f->msg);
+        }
+        else {
+            mutex_lock(&queue_lock);
+            stats.delivered += (rc == SN_ACCEPTED);
+            stats.dropped += (rc != SN_ACCEPTED);
+            mutex_unlock(&queue_lock);
+        }
+        f->id = 0;
+        return;
+    }
+}
+
+void mqtt_session_start(void)
+{
+    memset(topics, 0, sizeof(topics));
+    pending.type = SN_CONNECT;
+    pending.tries = 0;
+    _send_pending();
+    _arm();
+}
+
+void mqtt_input(const coap_udp_dgram_t *dgram)
+{
+    const uint8_t *p = dgram->data;
+    if ((p == NULL) || (dgram->len < 2) || (dgram->port != MONICA_MQTT_PORT) ||
+        !ipv6_addr_equal(&dgram->src, &broker)) {
+        return;
+    }
+    size_t hdr = 2;
+    size_t len = p[0];
+    if (p[0] == 0x01) {
+        hdr = 4;
+        len = (dgram->len >= hdr) ? _get_u16(&p[1]) : 0;
+    }
+    if ((len < hdr) || (len > dgram->len)) {
+        return;
+    }
+    const uint8_t *body = p + hdr;
+    size_t body_len = len - hdr;
+    heard = xtimer_now_usec();
+    switch (p[hdr - 1]) {
+        case SN_CONNACK:
+            if ((pending.type != SN_CONNECT) || (body_len < 1)) {
+                break;
+            }
+            pending.type = 0;
+            if (body[0] != SN_ACCEPTED) {
+                LOG_WARNING("[MQTT] connect rejected: %u\n", body[0]);
+                _lost();
+                return;
+            }
+            state = MQTT_CONNECTED;
+            mutex_lock(&queue_lock);
+            stats.connects++;
+            mutex_unlock(&queue_lock);
+            backoff = MONICA_MQTT_BACKOFF_MIN;
+            fails = 0;
+            break;
+        case SN_REGACK:
+            if ((pending.type != SN_REGISTER) || (body_len < 5) ||
+                (_get_u16(&body[2]) != pending.id)) {
+                break;
+            }
+            pending.type = 0;
+            if (body[4] != SN_ACCEPTED) {
+                LOG_WARNING("[MQTT] register %s rejected: %u\n", pending.topic,
+                            body[4]);
+                _lost();
+                return;
+            }
+            _topic_set(pending.topic, _get_u16(&body[0]));
+            break;
+        case SN_PUBACK:
+            if (body_len >= 5) {
+                _puback(_get_u16(&body[2]), body[4]);
+            }
+            break;
+        case SN_PINGREQ:
+            _send(SN_PINGRESP, NULL, 0, NULL, 0);
+            break;
+        case SN_PINGRESP:
+            if (pending.type == SN_PINGREQ) {
+                pending.type = 0;
+            }
+            break;
+        case SN_DISCONNECT:
+            if (state != MQTT_DISCONNECTED) {
+                _lost();
+                return;
+            }
+            break;
+        default:
+            break;
+    }
+    _fill();
+    _arm();
+}
+
+void mqtt_tick(void)
+{
+    uint32_t now = xtimer_now_usec();
+    int lost = 0;
+    if ((pending.type != 0) && ((int32_t)(pending.due - now) <= 0)) {
+        if (pending.tries < MONICA_MQTT_TRIES) {
+            _send_pending();
+        }
+        else {
+            lost = 1;
+        }
+    }
+    for (unsigned i = 0; i < MONICA_MQTT_WINDOW; i++) {
+        mqtt_inflight_t *f = &window[i];
+        if ((f->id != 0) && ((int32_t)(f->due - now) <= 0) &&
+            (f->msg.tries >= MONICA_MQTT_TRIES)) {
+            /* every try went unanswered, the broker is gone */
+            mutex_lock(&queue_lock);
+            stats.dropped++;
+            mutex_unlock(&queue_lock);
+            f->id = 0;
+            lost = 1;
+        }
+    }
+    if (lost) {
+        _lost();
+        return;
+    }
+    if ((state == MQTT_CONNECTED) && (pending.type == 0) &&
+        ((now - heard) >= MONICA_MQTT_PING)) {
+        /* nothing heard for a while, a lost broker would go unnoticed
+         * without messages to publish */
+        pending.type = SN_PINGREQ;
+        pending.tries = 0;
+        _send_pending();
+    }
+    for (unsigned i = 0; i < MONICA_MQTT_WINDOW; i++) {
+        mqtt_inflight_t *f = &window[i];
+        if ((f->id != 0) && ((int32_t)(f->due - now) <= 0)) {
+            mutex_lock(&queue_lock);
+            stats.retried++;
+            mutex_unlock(&queue_lock);
+            _send_publish(f, SN_FLAG_DUP);
+        }
+    }
+    _fill();
+    _arm();
+}
+
+/**
+ * @brief connect, publish queued messages and reconnect on a lost session
  *
  * @param[in] arg   unused
  */
 static void *mqtt_thread(void *arg)
 {
     (void) arg;
+    static gnrc_netreg_entry_t entry;
 
-    while(1) {
-        msg_t req, resp;
-        msg_receive(&req);
-        _pub((monica_pub_t *)req.content.ptr);
-        msg_reply(&req,&resp);
+    msg_init_queue(mqtt_msg_queue, MQTT_QUEUE_SIZE);
+    if (coap_udp_register_port(&entry, MONICA_MQTT_PUB_PORT,
+                               thread_getpid()) < 0) {
+        LOG_ERROR("[MQTT] failed to register port %u\n", MONICA_MQTT_PUB_PORT);
+        return NULL;
+    }
+    while (1) {
+        if (state == MQTT_DISCONNECTED) {
+            if (fails > 0) {
+                /* wait backoff +-25%, nodes that lost the broker together
+                 * do not come back all at once */
+                uint32_t jitter = xtimer_now_usec() % (backoff / 2);
+                xtimer_usleep(backoff - (backoff / 4) + jitter);
+                backoff = (backoff < MONICA_MQTT_BACKOFF_MAX / 2) ?
+                          2 * backoff : MONICA_MQTT_BACKOFF_MAX;
+            }
+            fails++;
+            state = MQTT_CONNECTING;
+            if (_con() != EMCUTE_OK) {
+                state = MQTT_DISCONNECTED;
+                continue;
+            }
+            _subscribe();
+            /* publishing has its own session, see mqtt_session_start() */
+            mqtt_session_start();
+        }
+        msg_t msg;
+        msg_receive(&msg);
+        switch (msg.type) {
+            case GNRC_NETAPI_MSG_TYPE_RCV: {
+                coap_udp_dgram_t dgram;
+                if (coap_udp_read(msg.content.ptr, &dgram) == 0) {
+                    mqtt_input(&dgram);
+                }
+                gnrc_pktbuf_release(msg.content.ptr);
+                break;
+            }
+            case MQTT_MSG_WAKEUP:
+            case MQTT_MSG_TIMER:
+                mqtt_tick();
+                break;
+            default:
+                break;
+        }
     }
     return NULL;
 }
 
+int mqtt_pub(const char *topic, const char *message, unsigned qos)
+{
+    size_t len = strlen(message);
+    if (len > MONICA_MQTT_SIZE) {
+        LOG_ERROR("[MQTT] pub: message too long\n");
+        return 1;
+    }
+    mutex_lock(&queue_lock);
+    if (queue_count == MONICA_MQTT_QUEUE_SIZE) {
+        /* keep the latest data, drop the oldest */
+        queue_head = (queue_head + 1) % MONICA_MQTT_QUEUE_SIZE;
+        queue_count--;
+        stats.dropped++;
+    }
+    mqtt_msg_t *m = &queue[(queue_head + queue_count) % MONICA_MQTT_QUEUE_SIZE];
+    m->topic = topic;
+    m->len = len;
+    m->qos = (qos > 0);
+    m->tries = 0;
+    memcpy(m->data, message, len);
+    queue_count++;
+    stats.queued++;
+    mutex_unlock(&queue_lock);
+    /* never blocks, the MQTT thread checks the queue when it gets to it */
+    if (mqtt_pid != KERNEL_PID_UNDEF) {
+        msg_t wakeup;
+        wakeup.type = MQTT_MSG_WAKEUP;
+        msg_try_send(&wakeup, mqtt_pid);
+    }
+    return 0;
+}
+
+mqtt_state_t mqtt_state(void)
+{
+    return state;
+}
+
+void mqtt_stats(mqtt_stats_t *out)
+{
+    mutex_lock(&queue_lock);
+    *out = stats;
+    mutex_unlock(&queue_lock);
+}
+
+size_t mqtt_cmd_pop(char *buf, size_t len)
+{
+    size_t res = 0;
+    mutex_lock(&cmds_lock);
+    if (cmds_count > 0) {
+        res = (cmds[cmds_head].len < len) ? cmds[cmds_head].len : len;
+        memcpy(buf, cmds[cmds_head].data, res);
+        cmds_head = (cmds_head + 1) % MONICA_CMD_QUEUE_SIZE;
+        cmds_count--;
+    }
+    mutex_unlock(&cmds_lock);
+    return res;
+}
+
+static void *emcute_thread(void *arg)
+{
+    (void)arg;
+    emcute_run(EMCUTE_PORT, client_id);
+    return NULL;    /* should never be reached */
+}
+
 /**
- * @brief start MQTT thread
+ * @brief set node ID, client ID and command topic from the CPU ID
+ */
+static void _node_id(void)
+{
+    strcpy(node_id, "0");
+#ifdef MODULE_PERIPH_CPUID
+    uint8_t cpuid[CPUID_LEN];
+    cpuid_get(cpuid);
+    uint32_t h = 2166136261U;
+    for (unsigned i = 0; i < CPUID_LEN; i++) {
+        h = (h ^ cpuid[i]) * 16777619U;
+    }
+    snprintf(node_id, sizeof(node_id), "%08lx", (unsigned long)h);
+#endif
+    snprintf(client_id, sizeof(client_id), "monica-%s", node_id);
+    snprintf(pub_client_id, sizeof(pub_client_id), "monica-%s-pub", node_id);
+    snprintf(topic_cmd_node, sizeof(topic_cmd_node), "monica/%s/cmd", node_id);
+    subs[0].topic.name = topic_cmd_node;
+    subs[0].cb = _on_cmd;
+    subs[1].topic.name = MONICA_TOPIC_CMD;
+    subs[1].cb = _on_cmd;
+}
+
+/**
+ * @brief start emcute and connect to the broker in the background
+ *
+ * @param[in] queue     event queue to post on_cmd to
+ * @param[in] on_cmd    event posted when commands were received
  *
- * @return PID of MQTT thread
+ * @return 0 on success, anything else on error
  */
-int mqtt_init(void)
+int mqtt_init(event_queue_t *queue, event_t *on_cmd)
 {
+    cmd_queue = queue;
+    cmd_event = on_cmd;
+    if (ipv6_addr_from_str(&broker, MONICA_MQTT_ADDR) == NULL) {
+        LOG_ERROR("[MQTT] failed to parse broker address!\n");
+        return 1;
+    }
     /* start the emcute thread */
     if (emcute_pid < 0) {
-        emcute_pid = thread_create(stack, sizeof(stack), EMCUTE_PRIO, 0, emcute_thread, NULL, "emcute");
+        _node_id();
+        LOG_INFO("[MQTT] client %s, commands on %s\n", client_id, topic_cmd_node);
+        emcute_pid = thread_create(stack, sizeof(stack), EMCUTE_PRIO,
+                                   THREAD_CREATE_STACKTEST, emcute_thread,
+                                   NULL, "emcute");
     }
-    if (_con() != 0) {
-        return -1;
+    if (mqtt_pid == KERNEL_PID_UNDEF) {
+        mqtt_pid = thread_create(mqtt_stack, sizeof(mqtt_stack),
+                                 MONICA_MQTT_PRIO, THREAD_CREATE_STACKTEST,
+                                 mqtt_thread, NULL, "mqtt");
     }
-    // start thread
-    return thread_create(mqtt_thread_stack, sizeof(mqtt_thread_stack),
-                         THREAD_PRIORITY_MAIN-1, THREAD_CREATE_STACKTEST,
-                         mqtt_thread, NULL, "mqtt_thread");
+    return ((emcute_pid < 0) || (mqtt_pid < 0)) ? 1 : 0;
 }
@@ -0,0 +1,151 @@
+/**
+ * @ingroup     climote
+ * @{
+ *
+ * @file
+ * @brief       Implements actuator control
+ *
+ * @author      smlng <s@mlng.net>
+ *
+ * @}
+ */
+
+// standard
+#include <string.h>
+// riot
+#include "board.h"
+#include "irq.h"
+// own
+#include "actuator.h"
+#include "dlog.h"
+
+static const char channels[ACTUATOR_NUMOF] = { 'r',
+#if (ACTUATOR_NUMOF > 1)
+    'g', 'b'
+#endif
+};
+#define CHANNELS_ALL    ((1U << ACTUATOR_NUMOF) - 1)
+
+static unsigned state;
+static actuator_cb_t on_change;
+
+/**
+ * @brief switch one LED
+ */
+static void _write(unsigned ch, int on)
+{
+    switch (ch) {
+        case 0:
+            if (on) {
+                LED0_ON;
+            }
+            else {
+                LED0_OFF;
+            }
+            break;
+#if (ACTUATOR_NUMOF > 1)
+        case 1:
+            if (on) {
+                LED1_ON;
+            }
+            else {
+                LED1_OFF;
+            }
+            break;
+        case 2:
+            if (on) {
+                LED2_ON;
+            }
+            else {
+                LED2_OFF;
+            }
+            break;
+#endif
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief parse a command into the channels to set and their values
+ *
+ * @return 0 on success, -1 on syntax error or unknown channel
+ */
+static int _parse(const char *cmd, size_t len, unsigned *mask, unsigned *value)
+{
+    *mask = 0;
+    *value = 0;
+    if ((len == 1) && ((cmd[0] == '0') || (cmd[0] == '1'))) {
+        *mask = CHANNELS_ALL;
+        *value = (cmd[0] == '1') ? CHANNELS_ALL : 0;
+        return 0;
+    }
+    if ((len == 0) || (len % 2)) {
+        return -1;
+    }
+    for (size_t i = 0; i < len; i += 2) {
+        const char *ch = memchr(channels, cmd[i], ACTUATOR_NUMOF);
+        if ((ch == NULL) || ((cmd[i + 1] != '0') && (cmd[i + 1] != '1'))) {
+            return -1;
+        }
+        unsigned bit = 1U << (ch - channels);
+        *mask |= bit;
+        *value = (cmd[i + 1] == '1') ? (*value | bit) : (*value & ~bit);
+    }
+    return 0;
+}
+
+void actuator_init(void)
+{
+    for (unsigned i = 0; i < ACTUATOR_NUMOF; i++) {
+        _write(i, 0);
+    }
+    state = 0;
+}
+
+int actuator_set(const char *cmd, size_t len)
+{
+    unsigned mask, value;
+    if (_parse(cmd, len, &mask, &value) < 0) {
+        return -1;
+    }
+    /* shell and CoAP thread may set concurrently, apply as one update */
+    unsigned irq = irq_disable();
+    unsigned old = state;
+    unsigned now = (old & ~mask) | value;
+    unsigned changed = old ^ now;
+    state = now;
+    for (unsigned i = 0; i < ACTUATOR_NUMOF; i++) {
+        if (changed & (1U << i)) {
+            _write(i, now & (1U << i));
+        }
+    }
+    irq_restore(irq);
+    if (!changed) {
+        return 0;
+    }
+    DLOG_INFO("LED state 0x%x\n", now);
+    if (on_change) {
+        on_change();
+    }
+    return 1;
+}
+
+size_t actuator_get(char *buf, size_t len)
+{
+    unsigned s = state;
+    size_t pos = 0;
+    for (unsigned i = 0; (i < ACTUATOR_NUMOF) && (pos + 2 <= len); i++) {
+        buf[pos++] = channels[i];
+        buf[pos++] = (s & (1U << i)) ? '1' : '0';
+    }
+    if (pos < len) {
+        buf[pos] = '\0';
+    }
+    return pos;
+}
+
+void actuator_on_change(actuator_cb_t cb)
+{
+    on_change = cb;
+}
@@ -0,0 +1,76 @@
+/**
+ * @ingroup     climote
+ * @{
+ *
+ * @file
+ * @brief       Defines actuator stuff
+ *
+ * All LEDs are channels of one actuator state, named r, g and b for LED0 to
+ * LED2. Commands set channels to a value, never toggle, so applying the same
+ * command twice, e.g., a retransmitted CoAP PUT, does not change anything.
+ *
+ * Command and state format is a list of channel and value pairs, e.g., "r1"
+ * or "r1g0b1", "1" and "0" set all channels.
+ *
+ * @author      smlng <s@mlng.net>
+ *
+ */
+
+#ifndef ACTUATOR_H_
+#define ACTUATOR_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "board.h"
+
+#if (defined(LED1_ON) && defined(LED2_ON))
+#define ACTUATOR_NUMOF      (3U)
+#else
+#define ACTUATOR_NUMOF      (1U)
+#endif
+
+/**
+ * @brief length of the state string, without null termination
+ */
+#define ACTUATOR_STATE_LEN  (2 * ACTUATOR_NUMOF)
+
+/**
+ * @brief callback on state changes, called by the thread setting the state
+ */
+typedef void (*actuator_cb_t)(void);
+
+/**
+ * @brief switch all channels off
+ */
+void actuator_init(void);
+
+/**
+ * @brief apply a command to all channels at once
+ *
+ * @param[in] cmd   command, need not be null terminated
+ * @param[in] len   length of cmd
+ *
+ * @return 1 if the state changed, 0 if not, -1 on an invalid command
+ */
+int actuator_set(const char *cmd, size_t len);
+
+/**
+ * @brief get the state of all channels, e.g., "r1g0b1"
+ *
+ * @param[out] buf  buffer for the state, null terminated if space is left
+ * @param[in] len   size of buf, at least ACTUATOR_STATE_LEN
+ *
+ * @return length of the state
+ */
+size_t actuator_get(char *buf, size_t len);
+
+/**
+ * @brief set the callback on state changes
+ *
+ * @param[in] cb    callback, NULL for none
+ */
+void actuator_on_change(actuator_cb_t cb);
+
+#endif // ACTUATOR_H_
+/** @} */
@@ -11,294 +11,926 @@
  */
 
 // standard
+#include <assert.h>
 #include <inttypes.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#ifdef MODULE_TINYDTLS
 // network
 #include <arpa/inet.h>
 #include <netinet/in.h>
 #include <sys/socket.h>
 #include <unistd.h>
+#endif
 // riot
 #include "board.h"
+#include "msg.h"
+#include "net/gnrc/netapi.h"
+#include "net/gnrc/pktbuf.h"
 #include "periph/gpio.h"
 #include "thread.h"
+#include "xtimer.h"
 #include "coap.h"
 // own
+#include "actuator.h"
+#include "coap_dispatch.h"
+#include "coap_etag.h"
+#include "coap_group.h"
+#include "coap_udp.h"
+#include "dlog.h"
+#include "coaps.h"
 #include "sensor.h"
 
 // parameters
 #define COAP_BUF_SIZE           (255)
-#define COAP_PORT               (5683)
 #define COAP_MSG_QUEUE_SIZE     (8U)
-#define COAP_REPSONSE_LENGTH    (1500)
 #define COAP_THREAD_STACKSIZE   (2 * THREAD_STACKSIZE_DEFAULT)
+#define COAP_OBSERVERS_NUMOF    (4U)
+#define COAP_DEDUP_NUMOF        (8U)    /* power of 2 */
+#define COAP_DEDUP_RSP_MAX      (64U)   /* larger responses are not kept */
+#define COAP_DEDUP_LIFETIME     (247U)  /* EXCHANGE_LIFETIME in s */
+#define COAP_ACK_TIMEOUT        (2U * US_PER_SEC)
+#define COAP_MAX_RETRANSMIT     (4U)
+/* confirmable notification to learn if an observer is still there */
+#define COAP_OBSERVE_REFRESH    (300U * US_PER_SEC)
+#define COAP_NOTIFY_MAX         (32U)   /* header, token, 2 options, state */
+
+/* messages of the CoAP thread besides received packets */
+#define COAP_MSG_NOTIFY         (0x4350)    /* the LED state changed */
+#define COAP_MSG_OBSERVE        (0x4351)    /* timer of the observers */
+
+/* 2.03 Valid, not in the response codes of microcoap */
+#define RSPCODE_VALID           ((coap_responsecode_t)MAKE_RSPCODE(2, 3))
 
 static char coap_thread_stack[COAP_THREAD_STACKSIZE];
 static msg_t coap_thread_msg_queue[COAP_MSG_QUEUE_SIZE];
-static char endpoints_response[COAP_REPSONSE_LENGTH];
-static char led = '0';
+static kernel_pid_t coap_thread_pid = KERNEL_PID_UNDEF;
+/* source of the request the CoAP thread is processing */
+static const coap_udp_dgram_t *coap_peer;
+
+/**
+ * @brief a client observing the LED state (RFC 7641), only the CoAP thread
+ *        touches observers
+ */
+typedef struct {
+    ipv6_addr_t addr;               /**< address of the client */
+    uint16_t port;                  /**< port of the client */
+    uint8_t token[8];               /**< token of the observe request */
+    uint8_t tkl;                    /**< token length */
+    uint8_t used;                   /**< 1 if the slot is in use */
+    uint16_t mid;                   /**< message ID of the last notification */
+    uint8_t pending;                /**< 1 while con waits for its ACK */
+    uint8_t retransmits;            /**< retransmissions of con so far */
+    uint32_t due;                   /**< next retransmission or refresh in us */
+    uint8_t con_len;                /**< length of con */
+    uint8_t con[COAP_NOTIFY_MAX];   /**< confirmable notification */
+} observer_t;
+
+static observer_t observers[COAP_OBSERVERS_NUMOF];
+static uint32_t observe_seq;
+static uint16_t notify_mid;
+static xtimer_t observe_timer;
+static msg_t observe_msg = { .type = COAP_MSG_OBSERVE };
+
+/* a second MQ135 channel has its own sensor resource */
+#if defined(SENSOR_MQ135) && (MQ135_CHANNELS > 1)
+#define COAP_RESOURCES_MQ135(X) \
+    X(airquality1, (1, "airquality1"), "ct=0;rt=\"airquality\";if=\"sensor\"")
+#else
+#define COAP_RESOURCES_MQ135(X)
+#endif
+
+/**
+ * @brief all resources, name, path as (segments, elements...) and link
+ *        attributes, both the resource paths and the link format description
+ *        (RFC 6690) of /.well-known/core are generated from this list
+ */
+#define COAP_RESOURCES(X) \
+    X(well_known_core, (2, ".well-known", "core"), "ct=40") \
+    X(airquality, (1, "airquality"), "ct=0;rt=\"airquality\";if=\"sensor\"") \
+    COAP_RESOURCES_MQ135(X) \
+    X(humidity, (1, "humidity"), "ct=0;rt=\"humidity\";if=\"sensor\"") \
+    X(led, (1, "led"), "ct=0;rt=\"led\";if=\"actuator\";obs") \
+    X(temperature, (1, "temperature"), "ct=0;rt=\"temperature\";if=\"sensor\"")
 
-static const coap_endpoint_path_t path_well_known_core = {2, {".well-known", "core"}};
-static const coap_endpoint_path_t path_airquality = {1, {"airquality"}};
-static const coap_endpoint_path_t path_humidity = {1, {"humidity"}};
-static const coap_endpoint_path_t path_led = {1, {"led"}};
-static const coap_endpoint_path_t path_temperature = {1, {"temperature"}};
+#define PATH_KEY(n, ...)        PATH_KEY_##n(__VA_ARGS__)
+#define PATH_KEY_1(a)           a
+#define PATH_KEY_2(a, b)        a "/" b
+#define PATH_LINK(n, ...)       PATH_LINK_##n(__VA_ARGS__)
+#define PATH_LINK_1(a)          "</" a ">"
+#define PATH_LINK_2(a, b)       "</" a "/" b ">"
+
+#define X_PATH(name, path, attr) \
+    static const char path_##name[] = PATH_KEY path;
+COAP_RESOURCES(X_PATH)
+#undef X_PATH
+
+#define X_LINK(name, path, attr)    PATH_LINK path ";" attr,
+static const char *const links[] = { COAP_RESOURCES(X_LINK) };
+#undef X_LINK
+#define LINKS_NUMOF     (sizeof(links) / sizeof(links[0]))
+
+/* complete description, the leading ',' of the first link is skipped */
+#define X_LINK(name, path, attr)    "," PATH_LINK path ";" attr
+static const char links_all[] = COAP_RESOURCES(X_LINK);
+#undef X_LINK
 
 /**
- * @brief handle well-known path request
+ * @brief check if a link matches a query like `rt=sensor` or `if=sens*`
+ *
+ * @return 1 on match, 0 otherwise
+ */
+static int link_match(const char *link, const uint8_t *query, size_t qlen)
+{
+    const uint8_t *eq = memchr(query, '=', qlen);
+    if (eq == NULL) {
+        return 0;
+    }
+    size_t klen = eq - query;
+    const char *val = (const char *)eq + 1;
+    size_t vlen = qlen - klen - 1;
+    int prefix = (vlen > 0) && (val[vlen - 1] == '*');
+    if (prefix) {
+        vlen--;
+    }
+    /* look for `;<key>="` and compare with any space separated value */
+    for (const char *a = strchr(link, ';'); a != NULL; a = strchr(a + 1, ';')) {
+        if ((strncmp(a + 1, (const char *)query, klen) != 0) ||
+            (strncmp(a + 1 + klen, "=\"", 2) != 0)) {
+            continue;
+        }
+        const char *v = a + klen + 3;
+        while ((*v != '"') && (*v != '\0')) {
+            size_t len = strcspn(v, " \"");
+            if ((prefix && (len >= vlen)) || (len == vlen)) {
+                if (strncmp(v, val, vlen) == 0) {
+                    return 1;
+                }
+            }
+            v += len;
+            if (*v == ' ') {
+                v++;
+            }
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief handle well-known path request, with optional rt or if filter
  */
 static int handle_get_well_known_core(coap_rw_buffer_t *scratch, const coap_packet_t *inpkt, coap_packet_t *outpkt, uint8_t id_hi, uint8_t id_lo)
 {
-    return coap_make_response(scratch, outpkt, (const uint8_t *)endpoints_response, strlen(endpoints_response), id_hi, id_lo, &inpkt->tok, COAP_RSPCODE_CONTENT, COAP_CONTENTTYPE_APPLICATION_LINKFORMAT);
+    uint8_t count = 0;
+    const coap_option_t *query = coap_findOptions(inpkt, COAP_OPTION_URI_QUERY, &count);
+    if (query == NULL) {
+        return coap_make_response(scratch, outpkt, (const uint8_t *)links_all + 1, sizeof(links_all) - 2, id_hi, id_lo, &inpkt->tok, COAP_RSPCODE_CONTENT, COAP_CONTENTTYPE_APPLICATION_LINKFORMAT);
+    }
+    /* coap_make_response stores the content format in the first 2 bytes of
+     * scratch, use the rest for the matching links */
+    char *rsp = (char *)scratch->p + 2;
+    size_t max = scratch->len - 2;
+    size_t len = 0;
+    for (unsigned i = 0; i < LINKS_NUMOF; i++) {
+        int match = 1;
+        for (unsigned q = 0; match && (q < count); q++) {
+            match = link_match(links[i], query[q].buf.p, query[q].buf.len);
+        }
+        size_t llen = strlen(links[i]);
+        if (match && (len + llen + 1 <= max)) {
+            if (len > 0) {
+                rsp[len++] = ',';
+            }
+            memcpy(rsp + len, links[i], llen);
+            len += llen;
+        }
+    }
+    return coap_make_response(scratch, outpkt, (const uint8_t *)rsp, len, id_hi, id_lo, &inpkt->tok, COAP_RSPCODE_CONTENT, COAP_CONTENTTYPE_APPLICATION_LINKFORMAT);
+}
+
+/**
+ * @brief get the leisure period asked for by ?leisure=<ms>, see coap_group.h
+ */
+static uint32_t get_leisure(const coap_packet_t *inpkt)
+{
+    uint8_t count = 0;
+    uint32_t leisure = 0;
+    const coap_option_t *query = coap_findOptions(inpkt, COAP_OPTION_URI_QUERY, &count);
+    for (unsigned i = 0; (query != NULL) && (leisure == 0) && (i < count); i++) {
+        leisure = coap_leisure_from_query((const char *)query[i].buf.p, query[i].buf.len);
+    }
+    return leisure;
 }
 
 /**
- * @brief handle get airquality request
+ * @brief check if a request carries an ETag, see coap_etag.h
  */
-static int handle_get_airquality(coap_rw_buffer_t *scratch, const coap_packet_t *inpkt, coap_packet_t *outpkt, uint8_t id_hi, uint8_t id_lo)
+static int etag_match(const coap_packet_t *inpkt, const uint8_t *etag, size_t len)
 {
-    int a100 = sensor_get_airquality();
-    int rest = a100 % 100;
-    char bufstr[COAP_BUF_SIZE];
-    if ((inpkt->payload.len > 0) && (strncmp((const char *)inpkt->payload.p,"json",4)==0)) {
-        sprintf(bufstr, "{sensor: 'airquality',unit: '%%',factor: 100,value: '%d'}", a100);
+    uint8_t count = 0;
+    const coap_option_t *opt = coap_findOptions(inpkt, COAP_OPTION_ETAG, &count);
+    for (unsigned i = 0; (opt != NULL) && (i < count); i++) {
+        if ((opt[i].buf.len == len) && (memcmp(opt[i].buf.p, etag, len) == 0)) {
+            return 1;
+        }
     }
-    else {
-        sprintf(bufstr, "%d.%02d", a100/100, rest);
+    return 0;
+}
+
+/**
+ * @brief add the ETag option, it precedes all options of the responses
+ */
+static void etag_option(coap_packet_t *pkt, const uint8_t *etag, size_t len)
+{
+    if (pkt->numopts >= MAXOPT) {
+        return;
     }
-    return coap_make_response(scratch, outpkt, (const uint8_t *)bufstr, strlen(bufstr), id_hi, id_lo, &inpkt->tok, COAP_RSPCODE_CONTENT, COAP_CONTENTTYPE_TEXT_PLAIN);
+    memmove(&pkt->opts[1], &pkt->opts[0], pkt->numopts * sizeof(pkt->opts[0]));
+    pkt->opts[0].num = COAP_OPTION_ETAG;
+    pkt->opts[0].buf.p = etag;
+    pkt->opts[0].buf.len = len;
+    pkt->numopts++;
 }
 
 /**
- * @brief handle get humidity request
+ * @brief handle get request of any registered sensor, the last path segment
+ *        is the sensor name
  */
-static int handle_get_humidity(coap_rw_buffer_t *scratch, const coap_packet_t *inpkt, coap_packet_t *outpkt, uint8_t id_hi, uint8_t id_lo)
+static int handle_get_sensor(coap_rw_buffer_t *scratch, const coap_packet_t *inpkt, coap_packet_t *outpkt, uint8_t id_hi, uint8_t id_lo)
 {
-    int h100 = sensor_get_humidity();
-    int rest = h100 % 100;
-    char bufstr[COAP_BUF_SIZE];
-    if ((inpkt->payload.len > 0) && (strncmp((const char *)inpkt->payload.p,"json",4)==0)) {
-        sprintf(bufstr, "{sensor: 'humidity',unit: '%%',factor: 100,value: '%d'}", h100);
+    uint8_t count;
+    const coap_option_t *opt = coap_findOptions(inpkt, COAP_OPTION_URI_PATH, &count);
+    int idx = (opt != NULL) ? sensor_reg_find((const char *)opt[count - 1].buf.p,
+                                              opt[count - 1].buf.len) : -1;
+    if (idx < 0) {
+        return coap_make_response(scratch, outpkt, NULL, 0, id_hi, id_lo, &inpkt->tok, COAP_RSPCODE_NOT_FOUND, COAP_CONTENTTYPE_TEXT_PLAIN);
+    }
+    const sensor_reg_t *sensor = sensor_reg_get(idx);
+    sensor_reg_snapshot_t snap;
+    sensor_reg_snapshot(&snap);
+    int32_t value = snap.value[idx];
+    int json = (inpkt->payload.len >= 4) && (memcmp(inpkt->payload.p, "json", 4) == 0);
+    /* both representations need their own tag */
+    static uint8_t etag[COAP_ETAG_LEN + 1];
+    coap_etag_from_gen(snap.gen, etag);
+    etag[COAP_ETAG_LEN] = 'j';
+    size_t etag_len = json ? sizeof(etag) : COAP_ETAG_LEN;
+    if (etag_match(inpkt, etag, etag_len)) {
+        int rc = coap_make_response(scratch, outpkt, NULL, 0, id_hi, id_lo, &inpkt->tok, RSPCODE_VALID, COAP_CONTENTTYPE_TEXT_PLAIN);
+        /* 2.03 has no payload, hence no Content-Format */
+        outpkt->numopts = 0;
+        etag_option(outpkt, etag, etag_len);
+        return rc;
+    }
+    /* the response points to the payload until it is built, so it must not
+     * be on this stack, put it behind the content format in scratch */
+    char *rsp = (char *)scratch->p + 2;
+    size_t max = scratch->len - 2;
+    size_t len;
+    if (json) {
+        /* the time of the last change, once the node is synchronized */
+        int res = snap.time ?
+            snprintf(rsp, max, "{sensor: '%s',unit: '%s',factor: %u,value: '%ld',time: %lu}", sensor->name, sensor->unit, sensor->factor, (long)value, (unsigned long)snap.time) :
+            snprintf(rsp, max, "{sensor: '%s',unit: '%s',factor: %u,value: '%ld'}", sensor->name, sensor->unit, sensor->factor, (long)value);
+        len = ((res > 0) && ((size_t)res < max)) ? (size_t)res : 0;
     }
     else {
-        sprintf(bufstr, "%d.%02d", h100/100, rest);
+        len = sensor_reg_fmt(idx, value, rsp, max);
+    }
+    int rc = coap_make_response(scratch, outpkt, (const uint8_t *)rsp, len, id_hi, id_lo, &inpkt->tok, COAP_RSPCODE_CONTENT, COAP_CONTENTTYPE_TEXT_PLAIN);
+    if (rc == 0) {
+        etag_option(outpkt, etag, etag_len);
     }
-    return coap_make_response(scratch, outpkt, (const uint8_t *)bufstr, strlen(bufstr), id_hi, id_lo, &inpkt->tok, COAP_RSPCODE_CONTENT, COAP_CONTENTTYPE_TEXT_PLAIN);
+    return rc;
 }
 
 /**
- * @brief handle get temperature request
+ * @brief find the observer with address and token
+ *
+ * @return index of the observer, -1 if not found
  */
-static int handle_get_temperature(coap_rw_buffer_t *scratch, const coap_packet_t *inpkt, coap_packet_t *outpkt, uint8_t id_hi, uint8_t id_lo)
+static int observer_find(const coap_udp_dgram_t *peer, const coap_buffer_t *tok)
 {
-    int t100 = sensor_get_temperature();
-    int rest = t100 % 100;
-    char bufstr[COAP_BUF_SIZE];
-    if ((inpkt->payload.len > 0) && (strncmp((const char *)inpkt->payload.p,"json",4)==0)) {
-        sprintf(bufstr, "{sensor: 'temperature',unit: 'C',factor: 100,value: '%d'}", t100);
+    for (unsigned i = 0; i < COAP_OBSERVERS_NUMOF; i++) {
+        observer_t *o = &observers[i];
+        if (o->used && (o->port == peer->port) &&
+            ipv6_addr_equal(&o->addr, &peer->src) &&
+            (o->tkl == tok->len) && (memcmp(o->token, tok->p, tok->len) == 0)) {
+            return i;
+        }
     }
-    else {
-        sprintf(bufstr, "%d.%02d", t100/100, rest);
+    return -1;
+}
+
+/**
+ * @brief arm the timer for the earliest retransmission or refresh
+ */
+static void observe_arm(void)
+{
+    uint32_t now = xtimer_now_usec();
+    observer_t *next = NULL;
+    for (unsigned i = 0; i < COAP_OBSERVERS_NUMOF; i++) {
+        observer_t *o = &observers[i];
+        if (o->used && ((next == NULL) || ((int32_t)(o->due - next->due) < 0))) {
+            next = o;
+        }
+    }
+    if (next == NULL) {
+        xtimer_remove(&observe_timer);
+        return;
+    }
+    int32_t delay = next->due - now;
+    xtimer_set_msg(&observe_timer, (delay > (int32_t)US_PER_MS) ? (uint32_t)delay : US_PER_MS,
+                   &observe_msg, coap_thread_pid);
+}
+
+/**
+ * @brief register or deregister the sender of a GET as observer
+ *
+ * Observe 0 registers, any other GET with the same token deregisters.
+ * Requests via coaps are answered once, notifications are sent in plain.
+ *
+ * @return 1 if the sender is registered, 0 otherwise
+ */
+static int observe_update(const coap_packet_t *inpkt)
+{
+    if ((thread_getpid() != coap_thread_pid) || (coap_peer == NULL) ||
+        (inpkt->tok.len > sizeof(observers[0].token))) {
+        return 0;
+    }
+    uint8_t count = 0;
+    const coap_option_t *obs = coap_findOptions(inpkt, COAP_OPTION_OBSERVE, &count);
+    int reg = (obs != NULL) && ((obs->buf.len == 0) ||
+                                ((obs->buf.len == 1) && (obs->buf.p[0] == 0)));
+    int idx = observer_find(coap_peer, &inpkt->tok);
+    if (reg && (idx < 0)) {
+        for (unsigned i = 0; (idx < 0) && (i < COAP_OBSERVERS_NUMOF); i++) {
+            if (!observers[i].used) {
+                idx = i;
+            }
+        }
+        if (idx >= 0) {
+            observer_t *o = &observers[idx];
+            memset(o, 0, sizeof(*o));
+            memcpy(&o->addr, &coap_peer->src, sizeof(o->addr));
+            o->port = coap_peer->port;
+            memcpy(o->token, inpkt->tok.p, inpkt->tok.len);
+            o->tkl = inpkt->tok.len;
+            o->due = xtimer_now_usec() + COAP_OBSERVE_REFRESH;
+            o->used = 1;
+        }
+    }
+    else if (!reg && (idx >= 0)) {
+        observers[idx].used = 0;
+        idx = -1;
     }
-    return coap_make_response(scratch, outpkt, (const uint8_t *)bufstr, strlen(bufstr), id_hi, id_lo, &inpkt->tok, COAP_RSPCODE_CONTENT, COAP_CONTENTTYPE_TEXT_PLAIN);
+    observe_arm();
+    return (idx >= 0);
 }
 
 /**
- * @brief handle get temperature request
+ * @brief handle an empty ACK or a reset of a notification
+ *
+ * An ACK confirms the observer is alive, a reset drops it.
  */
-static int handle_get_led(coap_rw_buffer_t *scratch, const coap_packet_t *inpkt, coap_packet_t *outpkt, uint8_t id_hi, uint8_t id_lo)
+static void observe_reply(const coap_packet_t *inpkt)
 {
-    return coap_make_response(scratch, outpkt, (const uint8_t *)&led, 1, id_hi, id_lo, &inpkt->tok, COAP_RSPCODE_CONTENT, COAP_CONTENTTYPE_TEXT_PLAIN);
+    uint16_t mid = (inpkt->hdr.id[0] << 8) | inpkt->hdr.id[1];
+    for (unsigned i = 0; i < COAP_OBSERVERS_NUMOF; i++) {
+        observer_t *o = &observers[i];
+        if (!o->used || (o->mid != mid)) {
+            continue;
+        }
+        if (inpkt->hdr.t == COAP_TYPE_RESET) {
+            o->used = 0;
+        }
+        else if (o->pending) {
+            o->pending = 0;
+            o->due = xtimer_now_usec() + COAP_OBSERVE_REFRESH;
+        }
+    }
+    observe_arm();
 }
 
 /**
- * @brief handle put led request
+ * @brief add the Observe option, it precedes Content-Format
+ *
+ * @param[out] val  buffer of at least 3 bytes for the option value
  */
-static int handle_put_led(coap_rw_buffer_t *scratch, const coap_packet_t *inpkt, coap_packet_t *outpkt, uint8_t id_hi, uint8_t id_lo)
+static void observe_option(coap_packet_t *pkt, uint32_t seq, uint8_t *val)
+{
+    /* 24 bit sequence number, shortest encoding */
+    size_t len = (seq > 0xffff) ? 3 : (seq > 0xff) ? 2 : (seq > 0) ? 1 : 0;
+    for (size_t i = 0; i < len; i++) {
+        val[i] = seq >> (8 * (len - 1 - i));
+    }
+    if (pkt->numopts >= MAXOPT) {
+        return;
+    }
+    memmove(&pkt->opts[1], &pkt->opts[0], pkt->numopts * sizeof(pkt->opts[0]));
+    pkt->opts[0].num = COAP_OPTION_OBSERVE;
+    pkt->opts[0].buf.p = val;
+    pkt->opts[0].buf.len = len;
+    pkt->numopts++;
+}
+
+/**
+ * @brief build a notification with the LED state and a new message ID
+ *
+ * @return length of the notification, 0 on error
+ */
+static size_t observe_build(observer_t *o, coap_msgtype_t type, uint8_t *buf, size_t max)
+{
+    char state[ACTUATOR_STATE_LEN + 1];
+    uint8_t obs[3];
+    coap_packet_t pkt;
+    memset(&pkt, 0, sizeof(pkt));
+    pkt.hdr.ver = 1;
+    pkt.hdr.t = type;
+    pkt.hdr.tkl = o->tkl;
+    pkt.hdr.code = COAP_RSPCODE_CONTENT;
+    o->mid = ++notify_mid;
+    pkt.hdr.id[0] = o->mid >> 8;
+    pkt.hdr.id[1] = o->mid & 0xff;
+    pkt.tok.p = o->token;
+    pkt.tok.len = o->tkl;
+    /* text/plain is 0, an empty Content-Format value */
+    pkt.opts[0].num = COAP_OPTION_CONTENT_FORMAT;
+    pkt.numopts = 1;
+    observe_option(&pkt, observe_seq, obs);
+    pkt.payload.p = (const uint8_t *)state;
+    pkt.payload.len = actuator_get(state, sizeof(state));
+    size_t len = max;
+    return (coap_build(buf, &len, &pkt) == 0) ? len : 0;
+}
+
+/**
+ * @brief send a confirmable notification, or again if it is pending
+ */
+static void observe_send_con(observer_t *o)
+{
+    if (!o->pending) {
+        o->con_len = observe_build(o, COAP_TYPE_CON, o->con, sizeof(o->con));
+        o->pending = 1;
+        o->retransmits = 0;
+    }
+    if (o->con_len > 0) {
+        coap_udp_send(&o->addr, o->port, o->con, o->con_len);
+    }
+    o->due = xtimer_now_usec() + (COAP_ACK_TIMEOUT << o->retransmits);
+}
+
+/**
+ * @brief retransmit unacknowledged notifications, drop observers which did
+ *        not acknowledge any of them, refresh the others
+ */
+static void observe_timeout(void)
 {
-    if (inpkt->payload.len > 0) {
-        if (inpkt->payload.p[0] == '1') {
-            puts("LED ON!");
-            led = '1';
-            LED0_ON;
-#if (defined(LED1_ON) && defined(LED2_ON))
-            LED1_ON;
-            LED2_ON;
+    uint32_t now = xtimer_now_usec();
+    for (unsigned i = 0; i < COAP_OBSERVERS_NUMOF; i++) {
+        observer_t *o = &observers[i];
+        if (!o->used || ((int32_t)(o->due - now) > 0)) {
+            continue;
         }
-        else if (inpkt->payload.p[0] == 'r') {
-            LED0_TOGGLE;
-            puts("LED TOGGLE red ...");
+        if (o->pending && (o->retransmits >= COAP_MAX_RETRANSMIT)) {
+            DLOG_INFO("[CoAP] observer %u gone\n", i);
+            o->used = 0;
+            continue;
         }
-        else if (inpkt->payload.p[0] == 'g') {
-            LED1_TOGGLE;
-            puts("LED TOGGLE green ...");
+        if (o->pending) {
+            o->retransmits++;
         }
-        else if (inpkt->payload.p[0] == 'b') {
-            LED2_TOGGLE;
-            puts("LED TOGGLE blue ...");
-#endif
+        observe_send_con(o);
+    }
+    observe_arm();
+}
+
+/**
+ * @brief send the LED state to all observers, on every state change
+ */
+static void led_notify(void)
+{
+    uint8_t buf[COAP_NOTIFY_MAX];
+
+    observe_seq = (observe_seq + 1) & 0xffffff;
+    for (unsigned i = 0; i < COAP_OBSERVERS_NUMOF; i++) {
+        observer_t *o = &observers[i];
+        if (!o->used) {
+            continue;
         }
-        else {
-            LED0_OFF;
-#if (defined(LED1_ON) && defined(LED2_ON))
-            LED1_OFF;
-            LED2_OFF;
-#endif
-            puts("LED OFF!");
-            led = '0';
+        if (o->pending) {
+            /* replaces the pending one, keeps its retransmission state
+             * (RFC 7641, 4.5.2) */
+            o->con_len = observe_build(o, COAP_TYPE_CON, o->con, sizeof(o->con));
+            if (o->con_len > 0) {
+                coap_udp_send(&o->addr, o->port, o->con, o->con_len);
+            }
+            continue;
+        }
+        size_t len = observe_build(o, COAP_TYPE_NONCON, buf, sizeof(buf));
+        if (len > 0) {
+            coap_udp_send(&o->addr, o->port, buf, len);
         }
-        return coap_make_response(scratch, outpkt, NULL, 0, id_hi, id_lo, &inpkt->tok, COAP_RSPCODE_CHANGED, COAP_CONTENTTYPE_TEXT_PLAIN);
     }
-    else {
-        LED0_OFF;
-        puts("LED OFF");
-        led = '0';
+}
+
+/**
+ * @brief LED state change callback, it may run in any thread, the CoAP
+ *        thread sends the notifications
+ */
+static void led_changed(void)
+{
+    msg_t m;
+    m.type = COAP_MSG_NOTIFY;
+    /* a notification already queued carries the new state as well */
+    msg_try_send(&m, coap_thread_pid);
+}
+
+/**
+ * @brief handle get led request, the state of all channels, observable
+ */
+static int handle_get_led(coap_rw_buffer_t *scratch, const coap_packet_t *inpkt, coap_packet_t *outpkt, uint8_t id_hi, uint8_t id_lo)
+{
+    static uint8_t obs[3];
+    /* behind the content format coap_make_response stores in scratch */
+    char *rsp = (char *)scratch->p + 2;
+    size_t len = actuator_get(rsp, scratch->len - 2);
+    int observed = observe_update(inpkt);
+    int rc = coap_make_response(scratch, outpkt, (const uint8_t *)rsp, len, id_hi, id_lo, &inpkt->tok, COAP_RSPCODE_CONTENT, COAP_CONTENTTYPE_TEXT_PLAIN);
+    if ((rc == 0) && observed) {
+        observe_option(outpkt, observe_seq, obs);
+    }
+    return rc;
+}
+
+/**
+ * @brief handle put led request, sets all channels given in the payload,
+ *        e.g., "r1g0", applying the same payload again changes nothing
+ */
+static int handle_put_led(coap_rw_buffer_t *scratch, const coap_packet_t *inpkt, coap_packet_t *outpkt, uint8_t id_hi, uint8_t id_lo)
+{
+    if (actuator_set((const char *)inpkt->payload.p, inpkt->payload.len) < 0) {
         return coap_make_response(scratch, outpkt, NULL, 0, id_hi, id_lo, &inpkt->tok, COAP_RSPCODE_BAD_REQUEST, COAP_CONTENTTYPE_TEXT_PLAIN);
     }
+    return coap_make_response(scratch, outpkt, NULL, 0, id_hi, id_lo, &inpkt->tok, COAP_RSPCODE_CHANGED, COAP_CONTENTTYPE_TEXT_PLAIN);
 }
 
+/**
+ * @brief resource handler of a path and method
+ */
+typedef struct {
+    const char *path;               /**< path, first member for coap_dispatch */
+    coap_method_t method;           /**< CoAP method */
+    coap_endpoint_func handler;     /**< request handler */
+} resource_t;
+
+/* sorted by path in ASCII order, same paths are adjacent */
+static const resource_t resources[] = {
+    { path_well_known_core, COAP_METHOD_GET, handle_get_well_known_core },
+    { path_airquality, COAP_METHOD_GET, handle_get_sensor },
+#if defined(SENSOR_MQ135) && (MQ135_CHANNELS > 1)
+    { path_airquality1, COAP_METHOD_GET, handle_get_sensor },
+#endif
+    { path_humidity, COAP_METHOD_GET, handle_get_sensor },
+    { path_led, COAP_METHOD_GET, handle_get_led },
+    { path_led, COAP_METHOD_PUT, handle_put_led },
+    { path_temperature, COAP_METHOD_GET, handle_get_sensor },
+};
+#define RESOURCES_NUMOF     (sizeof(resources) / sizeof(resources[0]))
+
+/* referenced by coap_handle_req() of microcoap, dispatch uses resources */
 const coap_endpoint_t endpoints[] =
 {
-    {COAP_METHOD_GET, handle_get_well_known_core, &path_well_known_core, "ct=40"},
-    {COAP_METHOD_GET, handle_get_airquality, &path_airquality, "ct=0"},
-    {COAP_METHOD_GET, handle_get_humidity, &path_humidity, "ct=0"},
-    {COAP_METHOD_GET, handle_get_temperature, &path_temperature, "ct=0"},
-    {COAP_METHOD_GET, handle_get_led, &path_led, "ct=0"},
-    {COAP_METHOD_PUT, handle_put_led, &path_led, NULL},
     {(coap_method_t)0, NULL, NULL, NULL}
 };
 
 /**
- * @brief generate well known resource description
+ * @brief dispatch a request by path and method, see coap_dispatch.h
  */
-static void setup_endpoints(void)
+static int handle_req(coap_rw_buffer_t *scratch, const coap_packet_t *inpkt, coap_packet_t *outpkt)
 {
-    uint16_t len = COAP_REPSONSE_LENGTH;
-    memset(endpoints_response,0,COAP_REPSONSE_LENGTH);
-    const coap_endpoint_t *ep = endpoints;
+    uint8_t id_hi = inpkt->hdr.id[0];
+    uint8_t id_lo = inpkt->hdr.id[1];
+    uint8_t count = 0;
+    const coap_option_t *opt = coap_findOptions(inpkt, COAP_OPTION_URI_PATH, &count);
+    if (count <= MAX_SEGMENTS) {
+        coap_dispatch_seg_t segs[MAX_SEGMENTS];
+        for (unsigned i = 0; i < count; i++) {
+            segs[i].p = opt[i].buf.p;
+            segs[i].len = opt[i].buf.len;
+        }
+        int idx = coap_dispatch_find(resources, RESOURCES_NUMOF,
+                                     sizeof(resources[0]), segs, count);
+        for (unsigned i = idx; (idx >= 0) && (i < RESOURCES_NUMOF) &&
+             (coap_dispatch_cmp(resources[i].path, segs, count) == 0); i++) {
+            if (resources[i].method == inpkt->hdr.code) {
+                return resources[i].handler(scratch, inpkt, outpkt, id_hi, id_lo);
+            }
+        }
+    }
+    return coap_make_response(scratch, outpkt, NULL, 0, id_hi, id_lo, &inpkt->tok, COAP_RSPCODE_NOT_FOUND, COAP_CONTENTTYPE_NONE);
+}
 
-    len--; // Null-terminated string
 
-    while((NULL != ep->handler) && (len >0))
-    {
-        if (NULL == ep->core_attr) {
-            ep++;
-            continue;
-        }
+/**
+ * @brief handle a CoAP request in place
+ *
+ * @param[in,out] buf   request, overwritten with the response
+ * @param[in] len       length of request
+ * @param[in] max       size of buf
+ *
+ * @return length of response, 0 if deferred, negative on error
+ */
+static ssize_t coap_process(uint8_t *buf, size_t len, size_t max)
+{
+    int rc;
+    uint8_t scratch_raw[COAP_BUF_SIZE];
+    coap_rw_buffer_t scratch_buf = {scratch_raw, sizeof(scratch_raw)};
+    coap_packet_t pkt;
+    coap_packet_t rsppkt;
 
-        if (0 < strlen(endpoints_response)) {
-            strncat(endpoints_response, ",", len);
-            len--;
+    if (0 != (rc = coap_parse(&pkt, buf, len))) {
+        DLOG_WARNING("WARN: Bad packet rc=%d\n", rc);
+        return -1;
+    }
+    if ((pkt.hdr.t == COAP_TYPE_RESET) || (pkt.hdr.t == COAP_TYPE_ACK)) {
+        /* a client answered a notification, nothing to respond */
+        if (thread_getpid() == coap_thread_pid) {
+            observe_reply(&pkt);
         }
+        return -1;
+    }
+    /* the options point into buf, read them before it is overwritten */
+    uint32_t leisure = get_leisure(&pkt);
+    handle_req(&scratch_buf, &pkt, &rsppkt);
+    size_t rsplen = max;
+    if (0 != (rc = coap_build(buf, &rsplen, &rsppkt))) {
+        DLOG_WARNING("WARN: coap_build failed rc=%d\n", rc);
+        return -1;
+    }
+    /* spread replies to group requests, which never come via DTLS */
+    if ((thread_getpid() == coap_thread_pid) &&
+        (coap_group_defer(buf, rsplen, leisure) == 0)) {
+        return 0;
+    }
+    return rsplen;
+}
 
-        strncat(endpoints_response, "<", len);
-        len--;
+#ifdef MODULE_TINYDTLS
+/**
+ * @brief open an UDP socket bound to port
+ *
+ * @return socket, negative on error
+ */
+static int coap_socket(uint16_t port)
+{
+    struct sockaddr_in6 server_addr;
+    int sock = socket(AF_INET6, SOCK_DGRAM, IPPROTO_UDP);
+    if (sock < 0) {
+        puts("ERROR: initializing socket");
+        return -1;
+    }
+    /* zero all of it, scope and flow info are not set otherwise */
+    memset(&server_addr, 0, sizeof(server_addr));
+    server_addr.sin6_family = AF_INET6;
+    server_addr.sin6_port = htons(port);
+    if (bind(sock, (struct sockaddr *)&server_addr, sizeof(server_addr)) < 0) {
+        puts("ERROR: binding socket");
+        return -1;
+    }
+    return sock;
+}
+#endif /* MODULE_TINYDTLS */
 
-        for (int i = 0; i < ep->path->count; i++) {
-            strncat(endpoints_response, "/", len);
-            len--;
+/**
+ * @brief a recent request and its response, to answer duplicates
+ */
+typedef struct {
+    uint8_t addr[16];               /**< address of the client */
+    uint16_t port;                  /**< port of the client */
+    uint8_t mid[2];                 /**< message ID of the request */
+    uint8_t token[8];               /**< token of the request */
+    uint8_t tkl;                    /**< token length */
+    uint8_t rsplen;                 /**< length of rsp, 0 if not kept */
+    uint32_t time;                  /**< reception in s, 0 for a free slot */
+    uint8_t rsp[COAP_DEDUP_RSP_MAX];/**< response */
+} dedup_t;
 
-            strncat(endpoints_response, ep->path->elems[i], len);
-            len -= strlen(ep->path->elems[i]);
-        }
+static dedup_t dedup[COAP_DEDUP_NUMOF];
+static struct {
+    uint32_t requests;              /**< requests processed */
+    uint32_t duplicates;            /**< duplicates answered from cache */
+    uint32_t reprocessed;           /**< duplicates with a response too large
+                                         for the cache, processed again */
+} dedup_stats;
 
-        strncat(endpoints_response, ">;", len);
-        len -= 2;
+/**
+ * @brief get the cache slot of a request, direct mapped by peer and mid
+ *
+ * @return slot, NULL if buf is no request
+ */
+static dedup_t *dedup_slot(const uint8_t *buf, size_t len, const coap_udp_dgram_t *src)
+{
+    /* CON or NON requests only, i.e., code class 0 but not empty */
+    if ((len < 4) || (((buf[0] >> 4) & 0x03) > COAP_TYPE_NONCON) ||
+        (buf[1] == 0) || ((buf[1] >> 5) != 0) ||
+        ((buf[0] & 0x0f) > 8) || (len < 4U + (buf[0] & 0x0f))) {
+        return NULL;
+    }
+    const uint8_t *a = src->src.u8;
+    uint32_t h = ((a[14] << 8) | a[15]) ^ src->port ^ ((buf[2] << 8) | buf[3]);
+    h *= 2654435761U;
+    return &dedup[(h >> 16) & (COAP_DEDUP_NUMOF - 1)];
+}
 
-        strncat(endpoints_response, ep->core_attr, len);
-        len -= strlen(ep->core_attr);
+/**
+ * @brief check if a request is a duplicate of the one kept in slot
+ */
+static int dedup_match(const dedup_t *d, const uint8_t *buf, const coap_udp_dgram_t *src, uint32_t now)
+{
+    uint8_t tkl = buf[0] & 0x0f;
+    return (d->time != 0) && ((now - d->time) < COAP_DEDUP_LIFETIME) &&
+           (d->port == src->port) &&
+           (memcmp(d->mid, buf + 2, 2) == 0) && (d->tkl == tkl) &&
+           (memcmp(d->token, buf + 4, tkl) == 0) &&
+           (memcmp(d->addr, src->src.u8, sizeof(d->addr)) == 0);
+}
+
+/**
+ * @brief keep a request and its response in slot
+ */
+static void dedup_store(dedup_t *d, const uint8_t *req, const coap_udp_dgram_t *src, uint32_t now, const uint8_t *rsp, ssize_t rsplen)
+{
+    memcpy(d->addr, src->src.u8, sizeof(d->addr));
+    d->port = src->port;
+    memcpy(d->mid, req + 2, 2);
+    d->tkl = req[0] & 0x0f;
+    memcpy(d->token, req + 4, d->tkl);
+    d->time = now ? now : 1;
+    d->rsplen = ((rsplen > 0) && (rsplen <= (ssize_t)COAP_DEDUP_RSP_MAX)) ? rsplen : 0;
+    memcpy(d->rsp, rsp, d->rsplen);
+}
+
+/**
+ * @brief show CoAP server counters
+ */
+int coap_cmd(int argc, char **argv)
+{
+    (void) argc;
+    (void) argv;
+    printf("requests: %lu, duplicates: %lu, reprocessed: %lu\n",
+           (unsigned long)dedup_stats.requests,
+           (unsigned long)dedup_stats.duplicates,
+           (unsigned long)dedup_stats.reprocessed);
+    return 0;
+}
 
-        ep++;
+/**
+ * @brief handle a received datagram, answer duplicates from the cache
+ *
+ * @param[in] pkt   packet of a GNRC_NETAPI_MSG_TYPE_RCV message
+ */
+static void coap_input(gnrc_pktsnip_t *pkt)
+{
+    /* the packet is shared with the group thread, work on a copy */
+    static uint8_t buf[COAP_BUF_SIZE];
+    coap_udp_dgram_t src;
+
+    if ((coap_udp_read(pkt, &src) < 0) || (src.len == 0) ||
+        (src.len > sizeof(buf))) {
+        return;
+    }
+    memcpy(buf, src.data, src.len);
+    DLOG_DEBUG(". received COAP message from [..:%x:%x]:%u.\n",
+               (src.src.u8[12] << 8) | src.src.u8[13],
+               (src.src.u8[14] << 8) | src.src.u8[15], src.port);
+    /* answer retransmissions from the cache, do not handle again */
+    uint32_t now = xtimer_now_usec64() / US_PER_SEC;
+    dedup_t *d = dedup_slot(buf, src.len, &src);
+    if (d && dedup_match(d, buf, &src, now)) {
+        if (d->rsplen > 0) {
+            dedup_stats.duplicates++;
+            coap_udp_send(&src.src, src.port, d->rsp, d->rsplen);
+            return;
+        }
+        dedup_stats.reprocessed++;
+    }
+    else if (d) {
+        dedup_stats.requests++;
+    }
+    uint8_t req[4 + 8];
+    memcpy(req, buf, (d != NULL) ? (4U + (buf[0] & 0x0f)) : 0);
+    coap_peer = &src;
+    ssize_t rsplen = coap_process(buf, src.len, sizeof(buf));
+    coap_peer = NULL;
+    if (d) {
+        dedup_store(d, req, &src, now, buf, rsplen);
+    }
+    if (rsplen > 0) {
+        coap_udp_send(&src.src, src.port, buf, rsplen);
     }
 }
 
 /**
- * @brief udp receiver thread function
+ * @brief CoAP thread function, handles requests and sends notifications
  *
  * @param[in] arg   unused
  */
 static void *coap_thread(void *arg)
 {
     (void) arg;
-    // start coap listener
-    struct sockaddr_in6 server_addr;
-    char src_addr_str[IPV6_ADDR_MAX_STR_LEN];
-    uint16_t port;
-    static int sock = -1;
-    static uint8_t buf[COAP_BUF_SIZE];
-    uint8_t scratch_raw[COAP_BUF_SIZE];
-    coap_rw_buffer_t scratch_buf = {scratch_raw, sizeof(scratch_raw)};
+    static gnrc_netreg_entry_t entry;
 
     msg_init_queue(coap_thread_msg_queue, COAP_MSG_QUEUE_SIZE);
-    sock = socket(AF_INET6, SOCK_DGRAM, IPPROTO_UDP);
-
-    /* parse port */
-    port = (uint16_t)COAP_PORT;
-    if (port == 0) {
-        puts("ERROR: invalid port specified");
+    coap_thread_pid = thread_getpid();
+    if (coap_udp_register(&entry, coap_thread_pid) < 0) {
+        puts("ERROR: registering for CoAP");
         return NULL;
     }
-    server_addr.sin6_family = AF_INET6;
-    memset(&server_addr.sin6_addr, 0, sizeof(server_addr.sin6_addr));
-    server_addr.sin6_port = htons(port);
-    if (sock < 0) {
-        puts("ERROR: initializing socket");
-        sock = 0;
-        return NULL;
+    while (1) {
+        msg_t m;
+        msg_receive(&m);
+        switch (m.type) {
+            case GNRC_NETAPI_MSG_TYPE_RCV:
+                coap_input(m.content.ptr);
+                gnrc_pktbuf_release(m.content.ptr);
+                break;
+            case COAP_MSG_NOTIFY:
+                led_notify();
+                break;
+            case COAP_MSG_OBSERVE:
+                observe_timeout();
+                break;
+            default:
+                break;
+        }
     }
-    if (bind(sock, (struct sockaddr *)&server_addr, sizeof(server_addr)) < 0) {
-        sock = -1;
-        puts("ERROR: binding socket");
+    return NULL;
+}
+
+#ifdef MODULE_TINYDTLS
+static char coaps_thread_stack[COAPS_THREAD_STACKSIZE];
+static msg_t coaps_thread_msg_queue[COAP_MSG_QUEUE_SIZE];
+static int coaps_sock = -1;
+
+/**
+ * @brief send a DTLS record, see coaps_send_t
+ */
+static int coaps_send(const ipv6_addr_t *addr, uint16_t port,
+                      const uint8_t *buf, size_t len)
+{
+    struct sockaddr_in6 dst;
+    memset(&dst, 0, sizeof(dst));
+    dst.sin6_family = AF_INET6;
+    memcpy(&dst.sin6_addr, addr, sizeof(dst.sin6_addr));
+    dst.sin6_port = htons(port);
+    return sendto(coaps_sock, buf, len, 0, (struct sockaddr *)&dst, sizeof(dst));
+}
+
+/**
+ * @brief coaps receiver thread function, passes records to the DTLS layer
+ *
+ * @param[in] arg   unused
+ */
+static void *coaps_thread(void *arg)
+{
+    (void) arg;
+    static uint8_t buf[COAP_BUF_SIZE + COAPS_RECORD_OVERHEAD];
+
+    msg_init_queue(coaps_thread_msg_queue, COAP_MSG_QUEUE_SIZE);
+    if (((coaps_sock = coap_socket(COAPS_PORT)) < 0) ||
+        (coaps_init(coaps_send, coap_process) < 0)) {
         return NULL;
     }
     while (1) {
-        int res,rc;
         struct sockaddr_in6 src;
         socklen_t src_len = sizeof(struct sockaddr_in6);
-        coap_packet_t pkt;
-        // blocking receive, waiting for data
-        if ((res = recvfrom(sock, buf, sizeof(buf), 0,
-                            (struct sockaddr *)&src, &src_len)) < 0) {
-            puts("ERROR: on receive");
-        }
-        else if (res == 0) {
-            puts("WARN: Peer did shut down");
-        }
-        else { // check for PING or PONG
-            if (0 != (rc = coap_parse(&pkt, buf, res)))
-                printf("WARN: Bad packet rc=%d\n", rc);
-            else
-            {
-                inet_ntop(AF_INET6, &(src.sin6_addr),
-                          src_addr_str, sizeof(src_addr_str));
-                printf(". received COAP message from [%s].\n", src_addr_str);
-                size_t rsplen = sizeof(buf);
-                coap_packet_t rsppkt;
-                coap_handle_req(&scratch_buf, &pkt, &rsppkt);
-
-                if (0 != (rc = coap_build(buf, &rsplen, &rsppkt))) {
-                    printf("WARN: coap_build failed rc=%d\n", rc);
-                }
-                else {
-                    sendto(sock, buf, rsplen, 0, (struct sockaddr *)&src, src_len);
-                }
-            }
+        int res = recvfrom(coaps_sock, buf, sizeof(buf), 0,
+                           (struct sockaddr *)&src, &src_len);
+        if (res > 0) {
+            coaps_input((ipv6_addr_t *)&src.sin6_addr, ntohs(src.sin6_port),
+                        buf, res);
         }
     }
     return NULL;
 }
+#endif /* MODULE_TINYDTLS */
 
 /**
- * @brief start udp receiver thread
+ * @brief start the CoAP thread
  *
  * @return PID of coap thread
  */
 int coap_start_thread(void)
 {
-    // init coap endpoints
-    setup_endpoints();
+    assert(coap_dispatch_check(resources, RESOURCES_NUMOF, sizeof(resources[0])) == 0);
+    actuator_on_change(led_changed);
+#ifdef MODULE_TINYDTLS
+    thread_create(coaps_thread_stack, sizeof(coaps_thread_stack),
+                  THREAD_PRIORITY_MAIN, THREAD_CREATE_STACKTEST,
+                  coaps_thread, NULL, "coaps_thread");
+#endif
     // start thread
     return thread_create(coap_thread_stack, sizeof(coap_thread_stack),
                          THREAD_PRIORITY_MAIN, THREAD_CREATE_STACKTEST,
@@ -17,12 +17,17 @@
  #include <string.h>
 // riot
 #include "board.h"
+#include "net/gnrc/ipv6.h"
 #include "net/gnrc/netapi.h"
 #include "net/gnrc/netif.h"
 #include "periph/gpio.h"
 #include "shell.h"
 // own
+#include "actuator.h"
+#include "coap_group.h"
+#include "dlog.h"
 #include "sensor.h"
+#include "timesync.h"
 
 #define COMM_PAN           (0x2409) // lowpan ID
 #define COMM_CHAN          (16U)  // channel
@@ -30,7 +35,7 @@
 int sensor_pid = -1;
 int coap_pid = -1;
 
-//extern int coap_cmd(int argc, char **argv);
+extern int coap_cmd(int argc, char **argv);
 extern int sensor_start_thread(void);
 extern int coap_start_thread(void);
 
@@ -41,6 +46,8 @@ static int cmd_put(int argc, char **argv);
 static const shell_command_t shell_commands[] = {
     { "get", "get sensor", cmd_get },
     { "put", "set actor",  cmd_put },
+    { "coap", "show coap counters", coap_cmd },
+    { "sensors", "show sampling counters", sensor_reg_cmd },
     { NULL, NULL, NULL }
 };
 
@@ -59,6 +66,15 @@ static int comm_init(void)
     /* initialize the radio */
     gnrc_netapi_set(ifs[0], NETOPT_NID, 0, &pan, 2);
     gnrc_netapi_set(ifs[0], NETOPT_CHANNEL, 0, &chan, 2);
+    /* answer CoAP group requests */
+    ipv6_addr_t group;
+    ipv6_addr_from_str(&group, COAP_GROUP_LINK);
+    gnrc_ipv6_netif_add_addr(ifs[0], &group, IPV6_ADDR_BIT_LEN,
+                             GNRC_IPV6_NETIF_ADDR_FLAGS_NON_UNICAST);
+    ipv6_addr_from_str(&group, COAP_GROUP_SITE);
+    gnrc_ipv6_netif_add_addr(ifs[0], &group, IPV6_ADDR_BIT_LEN,
+                             GNRC_IPV6_NETIF_ADDR_FLAGS_NON_UNICAST);
+    coap_group_init();
     return 0;
 }
 
@@ -75,6 +91,7 @@ int main(void)
     printf("You are running RIOT on a(n) %s board.\n", RIOT_BOARD);
     printf("This board features a(n) %s MCU.\n", RIOT_MCU);
     puts("========================================");
+    dlog_init();
 
     // init 6lowpan interface
     LED0_ON;
@@ -83,6 +100,8 @@ int main(void)
         return 1;
     }
     puts(".");
+    // sample timestamps, once the border router answers
+    timesync_init();
     // start sensor loop
     puts(".. init sensors");
     sensor_pid = sensor_start_thread();
@@ -99,11 +118,8 @@ int main(void)
     puts(".... init shell");
     puts(":");
     puts(":");
-    LED0_OFF;
-#if (defined(LED1_ON) && defined(LED2_ON))
-    LED1_OFF;
-    LED2_OFF;
-#endif
+    // all LEDs off, boot done
+    actuator_init();
     char line_buf[SHELL_DEFAULT_BUFSIZE];
     shell_run(shell_commands, line_buf, SHELL_DEFAULT_BUFSIZE);
 
@@ -113,58 +129,33 @@ int main(void)
 
 int cmd_get(int argc, char **argv)
 {
-#ifdef MODULE_TMP006
-    if ((argc == 2) && (strncmp(argv[1],"temperature",4) == 0)) {
-        int t100 = sensor_get_temperature();
-        int rest = t100 % 100;
-        printf("Temperature: %d.%02d C\n", t100/100, rest);
-    }
-#endif
-#ifdef MODULE_HDC1000
-    else if ((argc == 2) && (strncmp(argv[1],"humitity",3) == 0)) {
-        int h100 = sensor_get_humidity();
-        int rest = h100 % 100;
-        printf("Humidity: %d.%02d %%\n", h100/100, rest);
-    }
-#endif
-    else if ((argc == 2) && (strncmp(argv[1],"airquality",3) == 0)) {
-        int a100 = sensor_get_airquality();
-        int rest = a100 % 100;
-        printf("AirQuality: %d.%02d %%\n", a100/100, rest);
-    }
-    else {
-        puts ("[WARN] unknown sensor value requested.");
-        return (1);
+    if (argc == 2) {
+        /* allow abbreviations, e.g., get temp */
+        size_t len = strlen(argv[1]);
+        for (unsigned i = 0; i < sensor_reg_numof(); i++) {
+            const sensor_reg_t *s = sensor_reg_get(i);
+            if ((len > 0) && (strncmp(argv[1], s->name, len) == 0)) {
+                char val[16];
+                sensor_reg_fmt(i, sensor_reg_value(i), val, sizeof(val));
+                printf("%s: %s %s\n", s->name, val, s->unit);
+                return 0;
+            }
+        }
     }
-    return 0;
+    puts ("[WARN] unknown sensor value requested.");
+    return (1);
 }
 
 int cmd_put(int argc, char **argv)
 {
     if ((argc == 3) && (strcmp(argv[1],"led") == 0)) {
-        if (strcmp(argv[2], "1") == 0) {
-            LED0_ON;
-#if (defined(LED1_ON) && defined(LED2_ON))
-            LED1_ON;
-            LED2_ON;
-        }
-        else if (strcmp(argv[2], "r") == 0) {
-            LED0_TOGGLE;
-        }
-        else if (strcmp(argv[2], "g") == 0) {
-            LED1_TOGGLE;
-        }
-        else if (strcmp(argv[2], "b") == 0) {
-            LED2_TOGGLE;
-#endif
-        }
-        else {
-            LED0_OFF;
-#if (defined(LED1_ON) && defined(LED2_ON))
-            LED1_OFF;
-            LED2_OFF;
-#endif
+        if (actuator_set(argv[2], strlen(argv[2])) < 0) {
+            puts ("[WARN] led state is 0, 1 or pairs of channel and value, e.g. r1g0b1.");
+            return (1);
         }
+        char state[ACTUATOR_STATE_LEN + 1];
+        actuator_get(state, sizeof(state));
+        printf("led: %s\n", state);
     }
     else {
         puts ("[WARN] unknown actor setting requested.");
@@ -0,0 +1,180 @@
+/**
+ * @ingroup     climote
+ * @{
+ *
+ * @file
+ * @brief       Implements MQ135 air quality sampling
+ *
+ * @author      smlng <s@mlng.net>
+ *
+ * @}
+ */
+
+// standard
+#include <assert.h>
+#include <stdio.h>
+// riot
+#include "xtimer.h"
+// own
+#include "mq135.h"
+
+#define FULL_SCALE      (1UL << MQ135_BITS)
+#define Q16             (16U)
+#define Q30             (30U)
+
+/* 2^(2^-k) in Q30 for k = 1..16 */
+static const uint32_t exp2_frac[16] = {
+    1518500250U, 1276901417U, 1170923762U, 1121280436U,
+    1097253708U, 1085434106U, 1079572136U, 1076653033U,
+    1075196443U, 1074468888U, 1074105294U, 1073923544U,
+    1073832680U, 1073787251U, 1073764537U, 1073753181U,
+};
+
+static const mq135_params_t *params;
+static unsigned params_numof;
+static uint32_t burst[MQ135_NUMOF];
+static uint32_t burst_time;
+static int burst_valid;
+
+/**
+ * @brief log2(x) in Q16, x > 0
+ */
+static int32_t _log2(uint32_t x)
+{
+    assert(x > 0);
+    int msb = 31 - __builtin_clz(x);
+    int32_t res = msb << Q16;
+    /* mantissa in [1, 2) as Q30, squaring yields one bit per step */
+    uint64_t m = (msb > (int)Q30) ? (x >> (msb - Q30)) : ((uint64_t)x << (Q30 - msb));
+    for (int32_t bit = 1 << (Q16 - 1); bit > 0; bit >>= 1) {
+        m = (m * m) >> Q30;
+        if (m >= (2ULL << Q30)) {
+            m >>= 1;
+            res += bit;
+        }
+    }
+    return res;
+}
+
+/**
+ * @brief 2^y for y in Q16, rounded and saturated to UINT32_MAX
+ */
+static uint32_t _exp2(int32_t y)
+{
+    int32_t ip = y >> Q16;
+    uint32_t fp = (uint32_t)y & ((1U << Q16) - 1);
+    uint64_t m = 1ULL << Q30;
+    for (unsigned k = 0; k < Q16; k++) {
+        if (fp & (1U << (Q16 - 1 - k))) {
+            m = (m * exp2_frac[k]) >> Q30;
+        }
+    }
+    /* m in [1, 2) as Q30, scale by 2^ip */
+    if (ip >= 32) {
+        return UINT32_MAX;
+    }
+    int shift = (int)Q30 - ip;
+    if (shift <= 0) {
+        return (uint32_t)(m << -shift);
+    }
+    if (shift >= 63) {
+        return 0;
+    }
+    return (uint32_t)((m + (1ULL << (shift - 1))) >> shift);
+}
+
+uint32_t mq135_ppm(const mq135_params_t *p, uint32_t raw)
+{
+    if (raw == 0) {
+        /* no voltage over the load, infinite sensor resistance */
+        return 0;
+    }
+    if (raw >= FULL_SCALE) {
+        return MQ135_PPM_MAX;
+    }
+    uint64_t rs = ((uint64_t)p->r_load * (FULL_SCALE - raw)) / raw;
+    if (rs == 0) {
+        return MQ135_PPM_MAX;
+    }
+    if (rs > UINT32_MAX) {
+        rs = UINT32_MAX;
+    }
+    /* log2(ppm) = log2(a) + b * log2(rs / r0), a and b are scaled */
+    int64_t lratio = (int64_t)_log2((uint32_t)rs) - _log2(p->r0);
+    int64_t lppm = (int64_t)_log2((uint32_t)p->a) - _log2(100) +
+                   (lratio * p->b) / 1000;
+    if (lppm >= (int64_t)32 << Q16) {
+        return MQ135_PPM_MAX;
+    }
+    if (lppm < -((int64_t)32 << Q16)) {
+        return 0;
+    }
+    uint32_t ppm = _exp2((int32_t)lppm);
+    return (ppm < MQ135_PPM_MAX) ? ppm : MQ135_PPM_MAX;
+}
+
+/**
+ * @brief sample all lines, interleaved to spread each over the burst
+ *
+ * @return 0 on success, -1 on error
+ */
+static int _burst(void)
+{
+    uint32_t sum[MQ135_NUMOF] = { 0 };
+    for (unsigned n = 0; n < MQ135_BURST_LEN; n++) {
+        for (unsigned ch = 0; ch < params_numof; ch++) {
+            int val = adc_sample(params[ch].line, MQ135_ADC_RES);
+            if (val < 0) {
+                burst_valid = 0;
+                return -1;
+            }
+            sum[ch] += val;
+        }
+    }
+    /* decimate, keep MQ135_BURST_SHIFT bits of the averaged noise */
+    for (unsigned ch = 0; ch < params_numof; ch++) {
+        burst[ch] = sum[ch] >> MQ135_BURST_SHIFT;
+    }
+    burst_time = xtimer_now_usec();
+    burst_valid = 1;
+    return 0;
+}
+
+int mq135_init(const mq135_params_t *p, unsigned numof)
+{
+    assert(numof <= MQ135_NUMOF);
+    params = p;
+    params_numof = numof;
+    burst_valid = 0;
+    for (unsigned ch = 0; ch < numof; ch++) {
+        if (adc_init(p[ch].line) != 0) {
+            printf("ERROR: init ADC line %u!\n", (unsigned)p[ch].line);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int mq135_read_raw(unsigned ch, uint32_t *raw)
+{
+    if (ch >= params_numof) {
+        return -1;
+    }
+    /* channels of one sensor tick share a burst */
+    if ((!burst_valid || ((xtimer_now_usec() - burst_time) > MQ135_BURST_AGE)) &&
+        (_burst() != 0)) {
+        return -1;
+    }
+    *raw = burst[ch];
+    return 0;
+}
+
+int mq135_read(unsigned ch, int32_t *ppm)
+{
+    uint32_t raw;
+    if (mq135_read_raw(ch, &raw) != 0) {
+        return -1;
+    }
+    *ppm = (int32_t)mq135_ppm(&params[ch], raw);
+    return 0;
+}
@@ -0,0 +1,133 @@
+/**
+ * @ingroup     climote
+ * @{
+ *
+ * @file
+ * @brief       Defines MQ135 air quality sampling
+ *
+ * All channels are sampled in one burst of MQ135_BURST_LEN conversions per
+ * line, interleaved over the lines. The sum is decimated to MQ135_ADC_BITS
+ * plus MQ135_BURST_SHIFT bits, i.e., oversampling by 4^shift adds shift bits
+ * of resolution. A burst serves all channels read within MQ135_BURST_AGE.
+ *
+ * Each channel is calibrated to ppm in fixed-point, by the sensor resistance
+ * Rs = r_load * (full scale - v) / v and the power law of the datasheet
+ * curve, ppm = a * (Rs / r0)^b.
+ *
+ * @author      smlng <s@mlng.net>
+ *
+ */
+
+#ifndef MQ135_H_
+#define MQ135_H_
+
+#include <stdint.h>
+
+#include "periph/adc.h"
+#include "xtimer.h"
+
+/**
+ * @brief ADC resolution of a single conversion
+ */
+#ifndef MQ135_ADC_RES
+#define MQ135_ADC_RES       ADC_RES_12BIT
+#endif
+
+/**
+ * @brief bits of MQ135_ADC_RES, the adc_res_t values are CPU specific, i.e.,
+ *        set both when changing the resolution
+ */
+#ifndef MQ135_ADC_BITS
+#define MQ135_ADC_BITS      (12U)
+#endif
+
+/**
+ * @brief extra bits by oversampling, a burst has 4^shift conversions
+ */
+#ifndef MQ135_BURST_SHIFT
+#define MQ135_BURST_SHIFT   (3U)
+#endif
+
+#define MQ135_BURST_LEN     (1U << (2 * MQ135_BURST_SHIFT))
+#define MQ135_BITS          (MQ135_ADC_BITS + MQ135_BURST_SHIFT)
+
+/**
+ * @brief max age of a burst to serve further channels
+ */
+#ifndef MQ135_BURST_AGE
+#define MQ135_BURST_AGE     (100U * US_PER_MS)
+#endif
+
+/**
+ * @brief max number of channels
+ */
+#ifndef MQ135_NUMOF
+#define MQ135_NUMOF         (2U)
+#endif
+
+/**
+ * @brief upper bound of reported concentrations in ppm
+ */
+#ifndef MQ135_PPM_MAX
+#define MQ135_PPM_MAX       (10000U)
+#endif
+
+/**
+ * @brief CO2 curve of the datasheet, ppm = 116.60 * (Rs / r0)^-2.769
+ */
+#define MQ135_CURVE_CO2     .a = 11660, .b = -2769
+
+/**
+ * @brief channel configuration
+ */
+typedef struct {
+    adc_t line;         /**< ADC line of the load resistor */
+    uint32_t r_load;    /**< load resistor in ohm */
+    uint32_t r0;        /**< sensor resistance at the curve reference in ohm,
+                             calibrate in clean air */
+    int32_t a;          /**< curve factor in ppm * 100 */
+    int32_t b;          /**< curve exponent * 1000 */
+} mq135_params_t;
+
+/**
+ * @brief init the ADC lines of all channels
+ *
+ * @param[in] params    channel configurations, must stay valid
+ * @param[in] numof     number of channels, at most MQ135_NUMOF
+ *
+ * @return 0 on success, -1 on error
+ */
+int mq135_init(const mq135_params_t *params, unsigned numof);
+
+/**
+ * @brief get the oversampled value of a channel, runs a burst if required
+ *
+ * @param[in]  ch   channel
+ * @param[out] raw  value with MQ135_BITS resolution
+ *
+ * @return 0 on success, -1 on error
+ */
+int mq135_read_raw(unsigned ch, uint32_t *raw);
+
+/**
+ * @brief get the calibrated concentration of a channel
+ *
+ * @param[in]  ch   channel
+ * @param[out] ppm  concentration in ppm
+ *
+ * @return 0 on success, -1 on error
+ */
+int mq135_read(unsigned ch, int32_t *ppm);
+
+/**
+ * @brief convert an oversampled value to ppm
+ *
+ * @param[in] params    channel configuration
+ * @param[in] raw       value with MQ135_BITS resolution
+ *
+ * @return concentration in ppm, MQ135_PPM_MAX at most
+ */
+uint32_t mq135_ppm(const mq135_params_t *params, uint32_t raw);
+
+#endif // MQ135_H_
+/** @} */
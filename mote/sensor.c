@@ -15,11 +15,11 @@
 #include <stdlib.h>
 #include "board.h"
 #include "periph_conf.h"
-#include "thread.h"
 #include "xtimer.h"
+#include "sensor.h"
 
-#ifndef BOARD_SAMR21_XPRO
-#include "periph/adc.h"
+#ifdef SENSOR_MQ135
+#include "mq135.h"
 #endif
 
 #ifdef MODULE_HDC1000
@@ -29,244 +29,281 @@ static hdc1000_t dev_hdc1000;
 
 #ifdef MODULE_TMP006
 #include "tmp006.h"
+#include "tmp006_fixed.h"
 static tmp006_t dev_tmp006;
 #endif
 
-#include "sensor.h"
+#ifdef BOARD_NATIVE
+#include "sim.h"
+#endif
 
-#define SENSOR_MSG_QUEUE_SIZE   (8U)
-#define SENSOR_TIMEOUT_MS       (5000*1000)
+#define SENSOR_TIMEOUT_MS       (5000U)
 #define SENSOR_NUM_SAMPLES      (6U)
-#define SENSOR_THREAD_STACKSIZE (THREAD_STACKSIZE_DEFAULT)
-
-static int samples_airquality[SENSOR_NUM_SAMPLES];
-static int samples_humidity[SENSOR_NUM_SAMPLES];
-static int samples_temperature[SENSOR_NUM_SAMPLES];
-
-static char sensor_thread_stack[SENSOR_THREAD_STACKSIZE];
-
-/**
- * @brief get avg temperature over N samples in Celcius (C) with factor 100
- *
- * @return temperature
- */
-int sensor_get_temperature(void)
-{
-    int sum = 0;
-    for (int i=0; i < SENSOR_NUM_SAMPLES; i++) {
-        sum += samples_temperature[i];
-    }
-    int avg = (sum/SENSOR_NUM_SAMPLES);
-    return avg;
-}
-
-/**
- * @brief get avg humitity over N sampels in percent (%) with factor 100
- *
- * @return humidity
- */
-int sensor_get_humidity(void)
-{
-    int sum = 0;
-    for (unsigned i = 0; i < SENSOR_NUM_SAMPLES; ++i) {
-        sum += samples_humidity[i];
-    }
-    int avg = (sum/SENSOR_NUM_SAMPLES);
-    return avg;
-}
+/* bounds of adaptive sampling, sensors start at SENSOR_TIMEOUT_MS */
+#define SENSOR_PERIOD_MIN       (1000U)
+#define SENSOR_PERIOD_MAX       (60000U)
 
+#ifdef MODULE_HDC1000
 /**
- * @brief get avg air quality over N sampels in percent (%) with factor 100
+ * @brief Intialise the HDC1000
  *
- * @return air quality
+ * @return 0 on success, anything else on error
  */
-int sensor_get_airquality(void)
+static int sensor_hdc1000_init(void)
 {
-    int sum = 0;
-    for (unsigned i = 0; i < SENSOR_NUM_SAMPLES; ++i) {
-        sum += samples_airquality[i];
+    assert(SENSOR_TIMEOUT_MS * US_PER_MS > HDC1000_CONVERSION_TIME);
+    /* initialise humidity sensor hdc1000 */
+    if (!(hdc1000_init(&dev_hdc1000,
+                       HDC1000_I2C, HDC1000_I2C_ADDRESS) == 0)) {
+        puts("ERROR: HDC1000 init");
+        return 1;
     }
-    int avg = (sum/SENSOR_NUM_SAMPLES);
-    return avg;
+    return 0;
 }
 
-#ifdef MODULE_HDC1000
 /**
- * @brief Measures the temperature and humitity with a HDC1000.
+ * @brief Measures the humitity with a HDC1000.
  *
- * @param[out] temp the measured temperature in degree celsius * 100
  * @param[out] hum the measured humitity in % * 100
+ *
+ * @return 0 on success, anything else on error
  */
-static void sensor_hdc1000_measure(int *temp, int *hum) {
+static int sensor_hdc1000_measure(int32_t *hum) {
     uint16_t raw_temp, raw_hum;
+    int temp, h;
     /* init measurment */
     if (hdc1000_startmeasure(&dev_hdc1000)) {
         puts("ERROR: HDC1000 measure");
-        return;
+        return 1;
     }
     /* wait for the measurment to finish */
     xtimer_usleep(HDC1000_CONVERSION_TIME); //26000us
     hdc1000_read(&dev_hdc1000, &raw_temp, &raw_hum);
-    hdc1000_convert(raw_temp, raw_hum,  temp, hum);
+    hdc1000_convert(raw_temp, raw_hum,  &temp, &h);
+    *hum = h;
+    return 0;
 }
 #endif /* MODULE_HDC1000 */
 
 #ifdef MODULE_TMP006
+/**
+ * @brief Intialise the TMP006
+ *
+ * @return 0 on success, anything else on error
+ */
+static int sensor_tmp006_init(void)
+{
+    assert(SENSOR_TIMEOUT_MS * US_PER_MS > TMP006_CONVERSION_TIME);
+    /* init temperature sensor tmp006 */
+    if (!(tmp006_init(&dev_tmp006, TMP006_I2C,
+                      TMP006_ADDR, TMP006_CONFIG_CR_DEF) == 0)) {
+        puts("ERROR: TMP006 init");
+        return 1;
+    }
+    if (tmp006_set_active(&dev_tmp006)) {
+        puts("ERROR: TMP006 activate.");
+        return 1;
+    }
+    if (tmp006_test(&dev_tmp006)) {
+        puts("ERROR: TMP006 test.");
+        return 1;
+    }
+    puts("SUCCESS: TMP006 init and test!");
+    xtimer_usleep(TMP006_CONVERSION_TIME);
+    return 0;
+}
+
 /**
  * @brief Measures the temperature with a TMP006.
  *
  * @param[out] temp the measured temperature in degree celsius * 100
+ *
+ * @return 0 on success, anything else on error
  */
-static void sensor_tmp006_measure(int *temp)
+static int sensor_tmp006_measure(int32_t *temp)
 {
     uint8_t drdy;
     int16_t raw_temp, raw_volt;
-    float tamb, tobj;
 
     /* read sensor, quit on error */
     if (tmp006_read(&dev_tmp006, &raw_volt, &raw_temp, &drdy)) {
         puts("ERROR: TMP006 measure");
-        return;
+        return 1;
     }
-    tmp006_convert(raw_volt, raw_temp,  &tamb, &tobj);
-    *temp = (int)(tobj*100);
+    *temp = tmp006_fixed_object(raw_volt, raw_temp);
+    return 0;
 }
 #endif /* MODULE_TMP006 */
 
-#ifndef BOARD_SAMR21_XPRO
-/**
- * @brief Measure air quality using MQ135 via ADC
- *
- * @return raw airQuality value
- */
-static void sensor_mq135_measure(int *airq){
-    *airq = adc_sample(ADC_LINE(0), ADC_RES_16BIT);
-}
-#endif /* BOARD_SAMR21_XPRO */
+#ifdef SENSOR_MQ135
+/* one MQ135 per channel with 10k load on consecutive ADC lines, r0 of the
+ * datasheet, calibrate r0 per sensor */
+#ifndef MQ135_PARAMS
+#define MQ135_PARAM(i)          { .line = ADC_LINE(i), .r_load = 10000, \
+                                  .r0 = 76630, MQ135_CURVE_CO2 }
+#if (MQ135_CHANNELS > 1)
+#define MQ135_PARAMS            MQ135_PARAM(0), MQ135_PARAM(1)
+#else
+#define MQ135_PARAMS            MQ135_PARAM(0)
+#endif
+#endif
+
+static const mq135_params_t mq135_params[] = { MQ135_PARAMS };
+
+_Static_assert((sizeof(mq135_params) / sizeof(mq135_params[0])) ==
+               MQ135_CHANNELS, "MQ135_PARAMS needs one entry per channel");
+_Static_assert(MQ135_CHANNELS <= MQ135_NUMOF, "too many MQ135 channels");
 
 /**
- * @brief Intialise all sensores.
+ * @brief Intialise ADC lines for the MQ135
  *
  * @return 0 on success, anything else on error
  */
-static int sensor_init(void) {
-#ifndef BOARD_SAMR21_XPRO
-    if (ADC_NUMOF < 1) {
-        puts("ERROR: no ADC device found");
-        return 1;
-    }
-    /* init ADC devices for air quality sensor MQ135 */
-    for (int i = 0; i < ADC_NUMOF; i++) {
-        if (adc_init(i) != 0) {
-            printf("ERROR: init ADC_%d!\n", i);
-            return 1;
-        }
-    }
-#endif /* BOARD_SAMR21_XPRO */
-#ifdef MODULE_HDC1000
-    assert(SENSOR_TIMEOUT_MS > HDC1000_CONVERSION_TIME);
-    /* initialise humidity sensor hdc1000 */
-    if (!(hdc1000_init(&dev_hdc1000,
-                       HDC1000_I2C, HDC1000_I2C_ADDRESS) == 0)) {
-        puts("ERROR: HDC1000 init");
-        return 1;
-    }
-#endif /* MODULE_HDC1000 */
-#ifdef MODULE_TMP006
-    assert(SENSOR_TIMEOUT_MS > TMP006_CONVERSION_TIME);
-    /* init temperature sensor tmp006 */
-    if (!(tmp006_init(&dev_tmp006, TMP006_I2C,
-                      TMP006_ADDR, TMP006_CONFIG_CR_DEF) == 0)) {
-        puts("ERROR: TMP006 init");
-        return 1;
-    }
-    if (tmp006_set_active(&dev_tmp006)) {
-        puts("ERROR: TMP006 activate.");
-        return 1;
+static int sensor_mq135_init(void)
+{
+    for (unsigned i = 0; i < MQ135_CHANNELS; i++) {
+        assert((mq135_params[i].r_load > 0) && (mq135_params[i].r0 > 0) &&
+               (mq135_params[i].a > 0));
     }
-    if (tmp006_test(&dev_tmp006)) {
-        puts("ERROR: TMP006 test.");
+    /* init ADC lines for air quality sensor MQ135 */
+    if (mq135_init(mq135_params, MQ135_CHANNELS) != 0) {
+        puts("ERROR: MQ135 init");
         return 1;
     }
-    puts("SUCCESS: TMP006 init and test!");
-    xtimer_usleep(TMP006_CONVERSION_TIME);
-#endif /* MODULE_TMP006 */
-    int h1 = 0;
-    int t1 = 0;
-    int t2 = 0;
-    int a1 = 0;
-#ifndef BOARD_SAMR21_XPRO
-    sensor_mq135_measure(&a1);
-#else
-    (void)a1;
-#endif /* BOARD_SAMR21_XPRO */
-#ifdef MODULE_HDC1000
-    sensor_hdc1000_measure(&t1,&h1);
-#else
-    (void)t1;
-    (void)h1;
-#endif /* MODULE_HDC1000 */
-#ifdef MODULE_TMP006
-    sensor_tmp006_measure(&t2);
-#else
-    (void)t2;
-#endif /* MODULE_TMP006 */
-    for (int i=0; i<SENSOR_NUM_SAMPLES; i++) {
-        samples_airquality[i] = a1;
-        samples_humidity[i] = h1;
-        samples_temperature[i] = t2;
-    }
     return 0;
 }
 
 /**
- * @brief udp receiver thread function
+ * @brief Measure air quality using MQ135 via ADC burst
+ *
+ * @param[out] airq air quality in ppm
  *
- * @param[in] arg   unused
+ * @return 0 on success, anything else on error
  */
-static void *sensor_thread(void *arg)
+static int sensor_mq135_measure(int32_t *airq)
+{
+    return mq135_read(0, airq);
+}
+
+#if (MQ135_CHANNELS > 1)
+static int sensor_mq135_measure1(int32_t *airq)
+{
+    return mq135_read(1, airq);
+}
+#endif
+#endif /* SENSOR_MQ135 */
+
+#ifdef BOARD_NATIVE
+static int sensor_sim_init(void)
+{
+    sim_init();
+    return 0;
+}
+
+static int sensor_sim_temperature(int32_t *temp)
+{
+    static const sim_wave_t wave = SIM_WAVE_TEMPERATURE;
+    *temp = sim_sample(&wave);
+    return 0;
+}
+
+static int sensor_sim_humidity(int32_t *hum)
+{
+    static const sim_wave_t wave = SIM_WAVE_HUMIDITY;
+    *hum = sim_sample(&wave);
+    return 0;
+}
+
+static int sensor_sim_airquality(int32_t *airq)
 {
-    (void) arg;
-    int count = 0;
-    msg_init_queue(sensor_thread_msg_queue, SENSOR_MSG_QUEUE_SIZE);
-    xtimer_usleep(SENSOR_TIMEOUT_MS);
-    while(1) {
+    static const sim_wave_t wave = SIM_WAVE_AIRQUALITY;
+    *airq = sim_sample(&wave);
+    return 0;
+}
+#endif /* BOARD_NATIVE */
+
+#if defined(MODULE_TMP006) || defined(MODULE_HDC1000) || \
+    defined(SENSOR_MQ135) || defined(BOARD_NATIVE)
+#define SENSOR_TABLE
+#endif
+
+#ifdef SENSOR_TABLE
+/* MQ135 readings are noisy even after oversampling, smooth them */
+static const filter_cfg_t filter_airquality = {
+    .stages = FILTER_MEDIAN | FILTER_EMA,
+    .median = 5, .ema_shift = 2,
+};
+
+/* sample faster while temperature changes by 0.1 C per sample or more */
+static const sensor_adapt_t adapt_temperature = {
+    .min = SENSOR_PERIOD_MIN, .max = SENSOR_PERIOD_MAX, .threshold = 10,
+};
+
+/* sample faster while humidity changes by 0.5 % per sample or more */
+static const sensor_adapt_t adapt_humidity = {
+    .min = SENSOR_PERIOD_MIN, .max = SENSOR_PERIOD_MAX, .threshold = 50,
+};
+
+#ifdef SENSOR_MQ135
+/* sample faster while air quality changes by 20 ppm per sample or more */
+static const sensor_adapt_t adapt_airquality = {
+    .min = SENSOR_PERIOD_MIN, .max = SENSOR_PERIOD_MAX, .threshold = 20,
+};
+#else
+/* sample faster while air quality changes by 1 % per sample or more */
+static const sensor_adapt_t adapt_airquality = {
+    .min = SENSOR_PERIOD_MIN, .max = SENSOR_PERIOD_MAX, .threshold = 100,
+};
+#endif
+
+static const sensor_reg_t sensors[] = {
 #ifdef MODULE_TMP006
-        sensor_tmp006_measure(&samples_temperature[count%SENSOR_NUM_SAMPLES]);
+    { "temperature", "C", sensor_tmp006_init, sensor_tmp006_measure,
+      100, SENSOR_TIMEOUT_MS, SENSOR_NUM_SAMPLES, &filter_temperature,
+      &adapt_temperature },
 #endif
 #ifdef MODULE_HDC1000
-        int temp_hdc1000;
-        sensor_hdc1000_measure(&temp_hdc1000,
-                               &samples_humidity[count%SENSOR_NUM_SAMPLES]);
+    { "humidity", "%", sensor_hdc1000_init, sensor_hdc1000_measure,
+      100, SENSOR_TIMEOUT_MS, SENSOR_NUM_SAMPLES, &filter_humidity,
+      &adapt_humidity },
 #endif
-#ifndef BOARD_SAMR21_XPRO
-        sensor_mq135_measure(&samples_airquality[count%SENSOR_NUM_SAMPLES]);
+#ifdef SENSOR_MQ135
+    { "airquality", "ppm", sensor_mq135_init, sensor_mq135_measure,
+      1, SENSOR_TIMEOUT_MS, SENSOR_NUM_SAMPLES, &filter_airquality,
+      &adapt_airquality },
+#if (MQ135_CHANNELS > 1)
+    { "airquality1", "ppm", NULL, sensor_mq135_measure1,
+      1, SENSOR_TIMEOUT_MS, SENSOR_NUM_SAMPLES, &filter_airquality,
+      &adapt_airquality },
 #endif
-        count = (count+1)%SENSOR_NUM_SAMPLES;
-        if (count == 0) {
-            printf("[sensors] raw data T: %d, H: %d, A: %d\n",
-                   sensor_get_temperature(),
-                   sensor_get_humidity(),
-                   sensor_get_airquality());
-        }
-        xtimer_usleep(SENSOR_TIMEOUT_MS);
-    }
-    return NULL;
-}
+#endif
+#ifdef BOARD_NATIVE
+    { "temperature", "C", sensor_sim_init, sensor_sim_temperature,
+      100, SENSOR_TIMEOUT_MS, SENSOR_NUM_SAMPLES, &filter_temperature,
+      &adapt_temperature },
+    { "humidity", "%", NULL, sensor_sim_humidity,
+      100, SENSOR_TIMEOUT_MS, SENSOR_NUM_SAMPLES, &filter_humidity,
+      &adapt_humidity },
+    { "airquality", "%", NULL, sensor_sim_airquality,
+      100, SENSOR_TIMEOUT_MS, SENSOR_NUM_SAMPLES, &filter_airquality,
+      &adapt_airquality },
+#endif
+};
+#endif /* SENSOR_TABLE */
 
 /**
- * @brief start udp receiver thread
+ * @brief Intialise all sensors and start periodic measurements
  *
- * @return PID of sensor control thread
+ * @return PID of sensor control thread, 0 if the board has no sensor
  */
 int sensor_start_thread(void)
 {
-    /* init sensors */
-    if (sensor_init() != 0) {
-        return -1;
-    }
-    /* start sensor thread for periodic measurements */
-    return thread_create(sensor_thread_stack, sizeof(sensor_thread_stack),
-                        THREAD_PRIORITY_MAIN, THREAD_CREATE_STACKTEST,
-                        sensor_thread, NULL, "sensor_thread");
+#ifdef SENSOR_TABLE
+    return sensor_reg_init(sensors, sizeof(sensors) / sizeof(sensors[0]));
+#else
+    /* C has no empty arrays, the registry is set up empty without thread,
+     * all sensor resources answer 4.04 */
+    puts("WARN: no sensor on this board");
+    return sensor_reg_setup(NULL, 0);
+#endif
 }
@@ -12,9 +12,18 @@
 #ifndef SENSOR_H_
 #define SENSOR_H_
 
-int sensor_get_airquality(void);
-int sensor_get_humidity(void);
-int sensor_get_temperature(void);
+#include "sensor_reg.h"
+
+#if !defined(BOARD_SAMR21_XPRO) && !defined(BOARD_NATIVE)
+#define SENSOR_MQ135
+/**
+ * @brief number of MQ135 channels, 1 or 2, see MQ135_PARAMS in sensor.c
+ */
+#ifndef MQ135_CHANNELS
+#define MQ135_CHANNELS          (1U)
+#endif
+#endif
+
 int sensor_start_thread(void);
 
 #endif // SENSOR_H_
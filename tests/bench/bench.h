@@ -0,0 +1,39 @@
+/* timing of request handling on the host, only relative numbers between
+ * revisions are meaningful, the MCU is orders of magnitude slower */
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/types.h>
+#include <time.h>
+
+#include "host.h"
+
+#ifndef BENCH_ROUNDS
+#define BENCH_ROUNDS    (200000U)
+#endif
+
+typedef ssize_t (*bench_handler_t)(uint8_t *buf, size_t len, size_t max);
+
+/* handle req BENCH_ROUNDS times, print ns per request */
+static inline void bench_req(const char *name, bench_handler_t handler,
+                             const host_req_t *req, size_t max)
+{
+    uint8_t msg[256], buf[256];
+    size_t len = host_req(req, msg, sizeof(msg));
+    struct timespec t0, t1;
+    ssize_t res = 0;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (unsigned i = 0; i < BENCH_ROUNDS; i++) {
+        memcpy(buf, msg, len);
+        res = handler(buf, len, max);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double ns = ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec)) /
+                BENCH_ROUNDS;
+    printf("%-32s %8.1f ns/req  (%u, %zd bytes)\n", name, ns,
+           (res > 0) ? host_code(buf) : 0, res);
+}
+
+#endif /* BENCH_H */
@@ -0,0 +1,58 @@
+/* linear scan versus binary search of coap_dispatch_find(), the crossover
+ * sets COAP_DISPATCH_LINEAR_MAX */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "../../common/coap_dispatch.c"
+
+#define TABLE_MAX   (128U)
+#define ROUNDS      (2000000U)
+
+typedef struct {
+    const char *path;
+} res_t;
+
+typedef int (*find_t)(const void *table, size_t numof, size_t size,
+                      const coap_dispatch_seg_t *segs, unsigned nsegs);
+
+static char names[TABLE_MAX][16];
+static res_t table[TABLE_MAX];
+static coap_dispatch_seg_t lookups[TABLE_MAX + 1];
+
+static double _bench(find_t find, size_t numof)
+{
+    struct timespec t0, t1;
+    volatile int sink = 0;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (unsigned i = 0; i < ROUNDS; i++) {
+        /* every resource and a miss, in turn */
+        sink += find(table, numof, sizeof(table[0]), &lookups[i % (numof + 1)], 1);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    (void)sink;
+    return ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec)) / ROUNDS;
+}
+
+int main(void)
+{
+    static const size_t sizes[] = { 2, 4, 6, 8, 16, 24, 32, 48, 64, 128 };
+    printf("resources   linear  binary  ns/lookup (COAP_DISPATCH_LINEAR_MAX %u)\n",
+           COAP_DISPATCH_LINEAR_MAX);
+    for (unsigned s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        size_t numof = sizes[s];
+        /* sorted paths with a common prefix, like the mote resources */
+        for (size_t i = 0; i < numof; i++) {
+            snprintf(names[i], sizeof(names[i]), "/sensor%03u", (unsigned)i);
+            table[i].path = names[i];
+            lookups[i].p = (const uint8_t *)names[i] + 1;
+            lookups[i].len = strlen(names[i]) - 1;
+        }
+        lookups[numof].p = (const uint8_t *)"sensorx";
+        lookups[numof].len = 7;
+        printf("%9u %8.1f %7.1f\n", (unsigned)numof,
+               _bench(_find_linear, numof), _bench(_find_binary, numof));
+    }
+    return 0;
+}
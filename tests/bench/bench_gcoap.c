@@ -0,0 +1,22 @@
+/* handler microbenchmarks of a gcoap application, see test_gcoap.c */
+
+#include "bench.h"
+#include "net/gcoap.h"
+
+extern int coap_init(void);
+extern int sensor_init(void);
+
+int main(void)
+{
+    sensor_init();
+    coap_init();
+
+    host_req_t req = { .code = COAP_METHOD_GET, .mid = 1, .token = "tk",
+                       .path = "/" HOST_APP "/climate", .observe = -1 };
+    bench_req("GET climate", host_gcoap_request, &req, GCOAP_PDU_BUF_SIZE);
+    req.path = "/" HOST_APP "/info";
+    bench_req("GET info", host_gcoap_request, &req, GCOAP_PDU_BUF_SIZE);
+    req.path = "/nope";
+    bench_req("GET /nope", host_gcoap_request, &req, GCOAP_PDU_BUF_SIZE);
+    return 0;
+}
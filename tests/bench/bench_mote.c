@@ -0,0 +1,29 @@
+/* handler microbenchmarks of the mote */
+
+#include "../../mote/coap.c"
+
+#include "bench.h"
+
+int main(void)
+{
+    actuator_init();
+    sensor_start_thread();
+    coap_start_thread();
+
+    host_req_t req = { .code = COAP_METHOD_GET, .mid = 1, .token = "tk",
+                       .path = "/temperature", .observe = -1 };
+    bench_req("GET /temperature", coap_process, &req, COAP_BUF_SIZE);
+    req.payload = "json";
+    bench_req("GET /temperature json", coap_process, &req, COAP_BUF_SIZE);
+    req.payload = NULL;
+    req.path = "/led";
+    bench_req("GET /led", coap_process, &req, COAP_BUF_SIZE);
+    req.path = "/.well-known/core";
+    bench_req("GET /.well-known/core", coap_process, &req, COAP_BUF_SIZE);
+    req.query = "rt=temperature";
+    bench_req("GET /.well-known/core?rt=", coap_process, &req, COAP_BUF_SIZE);
+    req.query = NULL;
+    req.path = "/nope";
+    bench_req("GET /nope", coap_process, &req, COAP_BUF_SIZE);
+    return 0;
+}
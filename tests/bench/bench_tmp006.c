@@ -0,0 +1,90 @@
+/* fixed point tmp006_fixed_object() versus the double precision
+ * tmp006_convert() of RIOT, over a sweep of die temperatures and sensor
+ * voltages. On the host the FPU makes float cheap, the ratio only bounds the
+ * gain on MCUs without FPU, where every double operation is a library call */
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "../../common/tmp006_fixed.c"
+
+#define ROUNDS      (20U)
+#define RAWT_MIN    (-40 * 128)     /* -40 C */
+#define RAWT_MAX    (125 * 128)     /* 125 C */
+#define RAWT_STEP   (64)            /* 0.5 C */
+#define RAWV_STEP   (257)
+
+/* constants and calculation of tmp006_convert() in drivers/tmp006 */
+#define TMP006_CCONST_S0        (6.4e-14)
+#define TMP006_CCONST_A1        (1.75e-3)
+#define TMP006_CCONST_A2        (-1.678e-5)
+#define TMP006_CCONST_TREF      (298.15)
+#define TMP006_CCONST_B0        (-2.94e-5)
+#define TMP006_CCONST_B1        (-5.7e-7)
+#define TMP006_CCONST_B2        (4.63e-9)
+#define TMP006_CCONST_C2        (13.4)
+#define TMP006_CCONST_LSB_SIZE  (156.25e-9)
+
+static void tmp006_convert(int16_t rawv, int16_t rawt, float *tamb, float *tobj)
+{
+    *tamb = (double)rawt / 128.0;
+    double tdie_k = *tamb + 273.15;
+    double sens_v = (double)rawv * TMP006_CCONST_LSB_SIZE;
+    double tdiff = tdie_k - TMP006_CCONST_TREF;
+    double tdiff_pow2 = pow(tdiff, 2);
+    double s = TMP006_CCONST_S0 * (1 + TMP006_CCONST_A1 * tdiff
+                                   + TMP006_CCONST_A2 * tdiff_pow2);
+    double v_os = TMP006_CCONST_B0 + TMP006_CCONST_B1 * tdiff
+                  + TMP006_CCONST_B2 * tdiff_pow2;
+    double f_obj = (sens_v - v_os) + TMP006_CCONST_C2 * pow((sens_v - v_os), 2);
+    double t = pow(pow(tdie_k, 4) + (f_obj / s), 0.25);
+    *tobj = (t - 273.15);
+}
+
+static double _elapsed(const struct timespec *t0, const struct timespec *t1)
+{
+    return (t1->tv_sec - t0->tv_sec) * 1e9 + (t1->tv_nsec - t0->tv_nsec);
+}
+
+int main(void)
+{
+    struct timespec t0, t1;
+    volatile int32_t sink_fixed = 0;
+    volatile float sink_float = 0;
+    unsigned points = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (unsigned r = 0; r < ROUNDS; r++) {
+        for (int rawt = RAWT_MIN; rawt <= RAWT_MAX; rawt += RAWT_STEP) {
+            for (int rawv = INT16_MIN; rawv <= INT16_MAX; rawv += RAWV_STEP) {
+                sink_fixed += tmp006_fixed_object(rawv, rawt);
+                points++;
+            }
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double fixed = _elapsed(&t0, &t1) / points;
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (unsigned r = 0; r < ROUNDS; r++) {
+        for (int rawt = RAWT_MIN; rawt <= RAWT_MAX; rawt += RAWT_STEP) {
+            for (int rawv = INT16_MIN; rawv <= INT16_MAX; rawv += RAWV_STEP) {
+                float tamb, tobj;
+                tmp006_convert(rawv, rawt, &tamb, &tobj);
+                sink_float += tobj;
+            }
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double ref = _elapsed(&t0, &t1) / points;
+
+    printf("%-32s %8.1f ns/conv\n", "tmp006_fixed_object", fixed);
+    printf("%-32s %8.1f ns/conv\n", "tmp006_convert (double)", ref);
+    printf("%u conversions each, fixed point takes %.2fx the time of double\n",
+           points, fixed / ref);
+    (void) sink_fixed;
+    (void) sink_float;
+    return 0;
+}
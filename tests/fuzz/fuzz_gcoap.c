@@ -0,0 +1,35 @@
+/* fuzz harness of a gcoap application: the datagram is handled as by the
+ * gcoap listener and, as a decrypted coaps request, by nanocoap */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "host.h"
+#include "net/gcoap.h"
+
+extern int coap_init(void);
+extern int sensor_init(void);
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    static int initialized;
+    uint8_t buf[GCOAP_PDU_BUF_SIZE];
+
+    if (!initialized) {
+        sensor_init();
+        coap_init();
+        initialized = 1;
+    }
+    if (size > sizeof(buf)) {
+        return 0;
+    }
+    memcpy(buf, data, size);
+    host_gcoap_request(buf, size, sizeof(buf));
+
+    coap_pkt_t pdu;
+    memcpy(buf, data, size);
+    if (coap_parse(&pdu, buf, size) == 0) {
+        coap_handle_req(&pdu, buf, sizeof(buf));
+    }
+    return 0;
+}
@@ -0,0 +1,27 @@
+/* fuzz harness of the mote: duplicate detection, microcoap parsing,
+ * dispatch and all handlers, as the CoAP thread runs them for a datagram */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "../../mote/coap.c"
+
+#include "host.h"
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    static int initialized;
+
+    if (!initialized) {
+        actuator_init();
+        sensor_start_thread();
+        coap_start_thread();
+        coap_thread_pid = thread_getpid();
+        initialized = 1;
+    }
+    gnrc_pktsnip_t *pkt = host_udp_dgram("fe80::1", 40000, "fe80::2",
+                                         data, size);
+    coap_input(pkt);
+    gnrc_pktbuf_release(pkt);
+    return 0;
+}
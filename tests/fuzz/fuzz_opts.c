@@ -0,0 +1,35 @@
+/* fuzz harness of the parsers in common/ working on raw packet data: the
+ * ETag option walk, the leisure query and the path dispatch */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "coap_dispatch.h"
+#include "coap_etag.h"
+#include "coap_group.h"
+
+static const char *const paths[] = {
+    "/.well-known/core", "/a", "/a/b", "/lgv/climate", "/monica/climate",
+};
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    static const uint8_t etag[COAP_ETAG_LEN] = { 1, 2, 3, 4 };
+
+    coap_etag_match(data, size, etag, sizeof(etag));
+    coap_leisure_from_query((const char *)data, size);
+
+    /* path segments separated by '/' */
+    coap_dispatch_seg_t segs[4];
+    unsigned n = 0;
+    const uint8_t *end = data + size;
+    for (const uint8_t *p = data; (p < end) && (n < 4); n++) {
+        const uint8_t *sep = memchr(p, '/', end - p);
+        segs[n].p = p;
+        segs[n].len = (sep ? sep : end) - p;
+        p = sep ? sep + 1 : end;
+    }
+    coap_dispatch_find(paths, sizeof(paths) / sizeof(paths[0]),
+                       sizeof(paths[0]), segs, n);
+    return 0;
+}
@@ -0,0 +1,87 @@
+/* driver of the fuzz harnesses for builds without libFuzzer: runs every
+ * file given, directories file by file, or stdin if there is no argument,
+ * e.g., for `afl-fuzz -i corpus/mote -o out -- bin/fuzz_mote` */
+
+#include <dirent.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#define INPUT_MAX   (4096U)
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+static uint8_t input[INPUT_MAX];
+
+static int _run(FILE *f)
+{
+    size_t len = fread(input, 1, sizeof(input), f);
+    /* a copy of exactly the input size, such that ASan sees overreads */
+    uint8_t *data = malloc(len ? len : 1);
+    if (data == NULL) {
+        return -1;
+    }
+    memcpy(data, input, len);
+    LLVMFuzzerTestOneInput(data, len);
+    free(data);
+    return 0;
+}
+
+static int _run_file(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        perror(path);
+        return -1;
+    }
+    int res = _run(f);
+    fclose(f);
+    return res;
+}
+
+static int _run_path(const char *path, unsigned *count)
+{
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        perror(path);
+        return -1;
+    }
+    if (!S_ISDIR(st.st_mode)) {
+        (*count)++;
+        return _run_file(path);
+    }
+    DIR *dir = opendir(path);
+    if (dir == NULL) {
+        perror(path);
+        return -1;
+    }
+    int res = 0;
+    struct dirent *e;
+    while ((res == 0) && ((e = readdir(dir)) != NULL)) {
+        if (e->d_name[0] == '.') {
+            continue;
+        }
+        char file[1024];
+        snprintf(file, sizeof(file), "%s/%s", path, e->d_name);
+        res = _run_path(file, count);
+    }
+    closedir(dir);
+    return res;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        return (_run(stdin) == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    unsigned count = 0;
+    for (int i = 1; i < argc; i++) {
+        if (_run_path(argv[i], &count) != 0) {
+            return EXIT_FAILURE;
+        }
+    }
+    printf("%s: %u inputs\n", argv[0], count);
+    return EXIT_SUCCESS;
+}
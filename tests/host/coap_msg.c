@@ -0,0 +1,170 @@
+/* encoding and decoding of CoAP messages for tests, independent of the
+ * stand-ins such that they do not check themselves */
+
+#include <string.h>
+
+#include "host.h"
+
+#define OPT_ETAG        (4U)
+#define OPT_OBSERVE     (6U)
+#define OPT_URI_PATH    (11U)
+#define OPT_URI_QUERY   (15U)
+
+static size_t _ext(unsigned val, uint8_t *nibble, uint8_t *ext)
+{
+    if (val < 13) {
+        *nibble = val;
+        return 0;
+    }
+    if (val < 269) {
+        *nibble = 13;
+        ext[0] = val - 13;
+        return 1;
+    }
+    *nibble = 14;
+    ext[0] = (val - 269) >> 8;
+    ext[1] = (val - 269) & 0xff;
+    return 2;
+}
+
+static size_t _opt(uint8_t *buf, size_t max, size_t pos, unsigned *last,
+                   unsigned num, const void *val, size_t len)
+{
+    uint8_t ext[4];
+    uint8_t dn, ln;
+    size_t dl = _ext(num - *last, &dn, ext);
+    size_t ll = _ext(len, &ln, ext + dl);
+    if ((pos == 0) || ((pos + 1 + dl + ll + len) > max)) {
+        return 0;
+    }
+    buf[pos++] = (dn << 4) | ln;
+    memcpy(buf + pos, ext, dl + ll);
+    pos += dl + ll;
+    memcpy(buf + pos, val, len);
+    *last = num;
+    return pos + len;
+}
+
+/* add one option per segment of str, separated by sep */
+static size_t _opts(uint8_t *buf, size_t max, size_t pos, unsigned *last,
+                    unsigned num, const char *str, char sep)
+{
+    while ((pos > 0) && (*str != '\0')) {
+        if (*str == sep) {
+            str++;
+        }
+        size_t len = strcspn(str, (char []){ sep, '\0' });
+        pos = _opt(buf, max, pos, last, num, str, len);
+        str += len;
+    }
+    return pos;
+}
+
+size_t host_req(const host_req_t *req, uint8_t *buf, size_t max)
+{
+    size_t tkl = req->token ? strlen(req->token) : 0;
+    unsigned last = 0;
+    if ((tkl > 8) || (max < (4 + tkl))) {
+        return 0;
+    }
+    buf[0] = 0x40 | (req->type << 4) | tkl;
+    buf[1] = req->code;
+    buf[2] = req->mid >> 8;
+    buf[3] = req->mid & 0xff;
+    if (tkl > 0) {
+        memcpy(buf + 4, req->token, tkl);
+    }
+    size_t pos = 4 + tkl;
+    if (req->etag) {
+        pos = _opt(buf, max, pos, &last, OPT_ETAG, req->etag, req->etag_len);
+    }
+    if (req->observe >= 0) {
+        uint8_t val[3];
+        size_t len = 0;
+        for (uint32_t v = req->observe; v > 0; v >>= 8) {
+            len++;
+        }
+        for (size_t i = 0; i < len; i++) {
+            val[i] = req->observe >> (8 * (len - 1 - i));
+        }
+        pos = _opt(buf, max, pos, &last, OPT_OBSERVE, val, len);
+    }
+    if (req->path) {
+        pos = _opts(buf, max, pos, &last, OPT_URI_PATH, req->path, '/');
+    }
+    if (req->query) {
+        pos = _opts(buf, max, pos, &last, OPT_URI_QUERY, req->query, '&');
+    }
+    if (req->payload) {
+        size_t len = strlen(req->payload);
+        if ((pos == 0) || ((pos + 1 + len) > max)) {
+            return 0;
+        }
+        buf[pos++] = 0xff;
+        memcpy(buf + pos, req->payload, len);
+        pos += len;
+    }
+    return pos;
+}
+
+/* walk the options, returns the position of the payload marker or the end */
+static size_t _walk(const uint8_t *msg, size_t len, unsigned want,
+                    const uint8_t **val, size_t *vlen)
+{
+    size_t pos = 4 + (msg[0] & 0x0f);
+    unsigned num = 0;
+    while ((pos < len) && (msg[pos] != 0xff)) {
+        unsigned d = msg[pos] >> 4;
+        unsigned l = msg[pos] & 0x0f;
+        pos++;
+        unsigned *v[] = { &d, &l };
+        for (unsigned i = 0; i < 2; i++) {
+            if ((*v[i] == 13) && (pos < len)) {
+                *v[i] = 13 + msg[pos++];
+            }
+            else if ((*v[i] == 14) && ((pos + 1) < len)) {
+                *v[i] = 269 + ((msg[pos] << 8) | msg[pos + 1]);
+                pos += 2;
+            }
+        }
+        num += d;
+        if ((num == want) && (*val == NULL) && ((pos + l) <= len)) {
+            *val = msg + pos;
+            *vlen = l;
+        }
+        pos += l;
+    }
+    return pos;
+}
+
+const uint8_t *host_opt(const uint8_t *msg, size_t len, unsigned num,
+                        size_t *olen)
+{
+    const uint8_t *val = NULL;
+    if (len >= 4) {
+        _walk(msg, len, num, &val, olen);
+    }
+    return val;
+}
+
+const uint8_t *host_payload(const uint8_t *msg, size_t len, size_t *plen)
+{
+    const uint8_t *val = NULL;
+    size_t vlen;
+    if (len < 4) {
+        return NULL;
+    }
+    size_t pos = _walk(msg, len, UINT32_MAX, &val, &vlen);
+    if ((pos + 1) >= len) {
+        return NULL;
+    }
+    if (plen) {
+        *plen = len - pos - 1;
+    }
+    return msg + pos + 1;
+}
+
+unsigned host_code(const uint8_t *msg)
+{
+    return (msg[1] >> 5) * 100 + (msg[1] & 0x1f);
+}
@@ -0,0 +1,17 @@
+/* host stand-in: LEDs of the mote are counted, nothing is switched */
+#ifndef BOARD_H
+#define BOARD_H
+
+extern unsigned host_led_switched;
+
+#define LED0_ON             (host_led_switched++)
+#define LED0_OFF            (host_led_switched++)
+#define LED1_ON             (host_led_switched++)
+#define LED1_OFF            (host_led_switched++)
+#define LED2_ON             (host_led_switched++)
+#define LED2_OFF            (host_led_switched++)
+
+#define RIOT_BOARD          "host"
+#define RIOT_MCU            "host"
+
+#endif /* BOARD_H */
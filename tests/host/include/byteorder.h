@@ -0,0 +1,24 @@
+/* host stand-in of RIOT's byteorder.h */
+#ifndef BYTEORDER_H
+#define BYTEORDER_H
+
+#include <arpa/inet.h>
+#include <stdint.h>
+
+typedef union {
+    uint16_t u16;
+    uint8_t u8[2];
+} network_uint16_t;
+
+static inline network_uint16_t byteorder_htons(uint16_t v)
+{
+    network_uint16_t res = { .u16 = htons(v) };
+    return res;
+}
+
+static inline uint16_t byteorder_ntohs(network_uint16_t v)
+{
+    return ntohs(v.u16);
+}
+
+#endif /* BYTEORDER_H */
@@ -0,0 +1,132 @@
+/* host stand-in of the microcoap package API used by mote, see microcoap.c */
+#ifndef COAP_H
+#define COAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define MAXOPT              (16)
+#define MAX_SEGMENTS        (2)
+
+typedef struct {
+    uint8_t ver;
+    uint8_t t;
+    uint8_t tkl;
+    uint8_t code;
+    uint8_t id[2];
+} coap_header_t;
+
+typedef struct {
+    const uint8_t *p;
+    size_t len;
+} coap_buffer_t;
+
+typedef struct {
+    uint8_t *p;
+    size_t len;
+} coap_rw_buffer_t;
+
+typedef struct {
+    uint8_t num;
+    coap_buffer_t buf;
+} coap_option_t;
+
+typedef struct {
+    coap_header_t hdr;
+    coap_buffer_t tok;
+    uint8_t numopts;
+    coap_option_t opts[MAXOPT];
+    coap_buffer_t payload;
+} coap_packet_t;
+
+typedef enum {
+    COAP_OPTION_IF_MATCH = 1,
+    COAP_OPTION_URI_HOST = 3,
+    COAP_OPTION_ETAG = 4,
+    COAP_OPTION_IF_NONE_MATCH = 5,
+    COAP_OPTION_OBSERVE = 6,
+    COAP_OPTION_URI_PORT = 7,
+    COAP_OPTION_LOCATION_PATH = 8,
+    COAP_OPTION_URI_PATH = 11,
+    COAP_OPTION_CONTENT_FORMAT = 12,
+    COAP_OPTION_MAX_AGE = 14,
+    COAP_OPTION_URI_QUERY = 15,
+    COAP_OPTION_ACCEPT = 17,
+    COAP_OPTION_LOCATION_QUERY = 20,
+    COAP_OPTION_PROXY_URI = 35,
+    COAP_OPTION_PROXY_SCHEME = 39
+} coap_option_num_t;
+
+typedef enum {
+    COAP_METHOD_GET = 1,
+    COAP_METHOD_POST = 2,
+    COAP_METHOD_PUT = 3,
+    COAP_METHOD_DELETE = 4
+} coap_method_t;
+
+typedef enum {
+    COAP_TYPE_CON = 0,
+    COAP_TYPE_NONCON = 1,
+    COAP_TYPE_ACK = 2,
+    COAP_TYPE_RESET = 3
+} coap_msgtype_t;
+
+#define MAKE_RSPCODE(clas, det) ((clas << 5) | (det))
+typedef enum {
+    COAP_RSPCODE_CONTENT = MAKE_RSPCODE(2, 5),
+    COAP_RSPCODE_NOT_FOUND = MAKE_RSPCODE(4, 4),
+    COAP_RSPCODE_BAD_REQUEST = MAKE_RSPCODE(4, 0),
+    COAP_RSPCODE_CHANGED = MAKE_RSPCODE(2, 4)
+} coap_responsecode_t;
+
+typedef enum {
+    COAP_CONTENTTYPE_NONE = -1,
+    COAP_CONTENTTYPE_TEXT_PLAIN = 0,
+    COAP_CONTENTTYPE_APPLICATION_LINKFORMAT = 40,
+} coap_content_type_t;
+
+typedef enum {
+    COAP_ERR_NONE = 0,
+    COAP_ERR_HEADER_TOO_SHORT = 1,
+    COAP_ERR_VERSION_NOT_1 = 2,
+    COAP_ERR_TOKEN_TOO_SHORT = 3,
+    COAP_ERR_OPTION_TOO_SHORT_FOR_HEADER = 4,
+    COAP_ERR_OPTION_TOO_SHORT = 5,
+    COAP_ERR_OPTION_OVERRUNS_PACKET = 6,
+    COAP_ERR_OPTION_TOO_BIG = 7,
+    COAP_ERR_OPTION_LEN_INVALID = 8,
+    COAP_ERR_BUFFER_TOO_SMALL = 9,
+    COAP_ERR_UNSUPPORTED = 10,
+    COAP_ERR_OPTION_DELTA_INVALID = 11,
+} coap_error_t;
+
+typedef int (*coap_endpoint_func)(coap_rw_buffer_t *scratch,
+                                  const coap_packet_t *inpkt,
+                                  coap_packet_t *outpkt,
+                                  uint8_t id_hi, uint8_t id_lo);
+
+typedef struct {
+    int count;
+    const char *elems[MAX_SEGMENTS];
+} coap_endpoint_path_t;
+
+typedef struct {
+    coap_method_t method;
+    coap_endpoint_func handler;
+    const coap_endpoint_path_t *path;
+    const char *core_attr;
+} coap_endpoint_t;
+
+extern const coap_endpoint_t endpoints[];
+
+int coap_parse(coap_packet_t *pkt, const uint8_t *buf, size_t buflen);
+const coap_option_t *coap_findOptions(const coap_packet_t *pkt, uint8_t num,
+                                      uint8_t *count);
+int coap_build(uint8_t *buf, size_t *buflen, const coap_packet_t *pkt);
+int coap_make_response(coap_rw_buffer_t *scratch, coap_packet_t *pkt,
+                       const uint8_t *content, size_t content_len,
+                       uint8_t msgid_hi, uint8_t msgid_lo,
+                       const coap_buffer_t *tok, coap_responsecode_t rspcode,
+                       coap_content_type_t content_type);
+
+#endif /* COAP_H */
@@ -0,0 +1,23 @@
+/* host stand-in of RIOT's event.h, events are not dispatched */
+#ifndef EVENT_H
+#define EVENT_H
+
+typedef struct event event_t;
+typedef void (*event_handler_t)(event_t *);
+
+struct event {
+    void *list_node;
+    event_handler_t handler;
+};
+
+typedef struct {
+    void *event_list;
+    void *waiter;
+} event_queue_t;
+
+void event_queue_init(event_queue_t *queue);
+void event_post(event_queue_t *queue, event_t *event);
+void event_cancel(event_queue_t *queue, event_t *event);
+void event_loop(event_queue_t *queue);
+
+#endif /* EVENT_H */
@@ -0,0 +1,149 @@
+/* control of the host stand-ins, used by unit tests, fuzz harnesses and
+ * benchmarks. The stand-ins replace RIOT, microcoap and gcoap such that the
+ * shared code and the CoAP handlers of all applications build on the host. */
+#ifndef HOST_H
+#define HOST_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "msg.h"
+#include "net/gnrc/pkt.h"
+#include "net/ipv6/addr.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief PID thread_getpid() returns, i.e., the thread the caller plays
+ */
+extern kernel_pid_t host_pid;
+
+/**
+ * @brief advance the virtual clock of xtimer
+ */
+void host_clock_advance(uint32_t us);
+
+/**
+ * @brief value adc_sample() returns for every line, negative for an error
+ */
+extern int host_adc_value;
+
+/**
+ * @brief number of emcute_discon() calls, see host/emcute.c
+ */
+extern unsigned host_emcute_discons;
+
+/**
+ * @brief number of messages sent since start, see host_msg()
+ */
+extern unsigned host_msgs;
+
+/**
+ * @brief get a recent message sent by msg_send() or msg_try_send()
+ *
+ * @param[in]  back     0 for the last message, 1 for the one before, ...
+ * @param[out] target   PID the message was sent to
+ *
+ * @return the message, NULL if not kept
+ */
+const msg_t *host_msg(unsigned back, kernel_pid_t *target);
+
+/**
+ * @brief handle a datagram like the listener thread of gcoap
+ *
+ * @param[in,out] buf   request, overwritten with the response
+ * @param[in] len       length of request
+ * @param[in] max       size of buf
+ *
+ * @return length of the response, 0 for none, negative if dropped
+ */
+ssize_t host_gcoap_request(uint8_t *buf, size_t len, size_t max);
+
+/**
+ * @brief build a packet like gnrc_udp passes received datagrams
+ *
+ * @param[in] src       source address, e.g., "fe80::1"
+ * @param[in] port      source port
+ * @param[in] dst       destination address, e.g., "ff02::fd"
+ * @param[in] data      UDP payload, copied
+ * @param[in] len       length of data
+ *
+ * @return packet, release with gnrc_pktbuf_release()
+ */
+gnrc_pktsnip_t *host_udp_dgram(const char *src, uint16_t port, const char *dst,
+                               const void *data, size_t len);
+
+/**
+ * @brief number of datagrams sent by gnrc_netapi_dispatch_send() since start
+ */
+extern unsigned host_udp_sends;
+
+/**
+ * @brief get a recent datagram sent by gnrc_netapi_dispatch_send()
+ *
+ * @param[in] back      0 for the last datagram, 1 for the one before, ...
+ * @param[out] dst      destination address, may be NULL
+ * @param[out] port     destination port, may be NULL
+ * @param[out] len      length of the UDP payload
+ *
+ * @return UDP payload, NULL if not kept
+ */
+const uint8_t *host_udp_sent(unsigned back, ipv6_addr_t *dst, uint16_t *port,
+                             size_t *len);
+
+/**
+ * @brief description of a request built by host_req()
+ */
+typedef struct {
+    uint8_t type;               /**< 0 CON, 1 NON */
+    uint8_t code;               /**< method, 1 GET, 2 POST, 3 PUT */
+    uint16_t mid;               /**< message ID */
+    const char *token;          /**< token, NULL for none */
+    const char *path;           /**< path, e.g., "/a/b", NULL for none */
+    const char *query;          /**< query, e.g., "a=1&b=2", NULL for none */
+    const char *etag;           /**< ETag, NULL for none */
+    size_t etag_len;            /**< length of etag */
+    int observe;                /**< Observe value, -1 for none */
+    const char *payload;        /**< payload, NULL for none */
+} host_req_t;
+
+/**
+ * @brief encode a request
+ *
+ * @return length of the request, 0 if buf is too small
+ */
+size_t host_req(const host_req_t *req, uint8_t *buf, size_t max);
+
+/**
+ * @brief get the value of an option of a message
+ *
+ * @param[in]  msg  message
+ * @param[in]  len  length of msg
+ * @param[in]  num  option number
+ * @param[out] olen length of the value
+ *
+ * @return value of the first option with num, NULL if there is none
+ */
+const uint8_t *host_opt(const uint8_t *msg, size_t len, unsigned num,
+                        size_t *olen);
+
+/**
+ * @brief get the payload of a message, plen may be NULL
+ *
+ * @return payload, NULL if there is none
+ */
+const uint8_t *host_payload(const uint8_t *msg, size_t len, size_t *plen);
+
+/**
+ * @brief response code of a message as class * 100 + detail, e.g., 205
+ */
+unsigned host_code(const uint8_t *msg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HOST_H */
@@ -0,0 +1,15 @@
+/* host stand-in: single threaded, interrupts are never masked */
+#ifndef IRQ_H
+#define IRQ_H
+
+static inline unsigned irq_disable(void)
+{
+    return 0;
+}
+
+static inline void irq_restore(unsigned state)
+{
+    (void)state;
+}
+
+#endif /* IRQ_H */
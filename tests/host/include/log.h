@@ -0,0 +1,32 @@
+/* host stand-in of RIOT's log.h, LOG_LEVEL defaults to warnings here such
+ * that fuzzing and benchmarks are not slowed down by printing */
+#ifndef LOG_H
+#define LOG_H
+
+#include <stdio.h>
+
+enum {
+    LOG_NONE,
+    LOG_ERROR,
+    LOG_WARNING,
+    LOG_INFO,
+    LOG_DEBUG,
+    LOG_ALL
+};
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL           LOG_WARNING
+#endif
+
+#define LOG(level, ...)     do { \
+        if ((level) <= LOG_LEVEL) { \
+            printf(__VA_ARGS__); \
+        } \
+    } while (0)
+
+#define LOG_ERROR(...)      LOG(LOG_ERROR, __VA_ARGS__)
+#define LOG_WARNING(...)    LOG(LOG_WARNING, __VA_ARGS__)
+#define LOG_INFO(...)       LOG(LOG_INFO, __VA_ARGS__)
+#define LOG_DEBUG(...)      LOG(LOG_DEBUG, __VA_ARGS__)
+
+#endif /* LOG_H */
@@ -0,0 +1,23 @@
+/* host stand-in of RIOT's msg.h, sent messages are kept in a log */
+#ifndef MSG_H
+#define MSG_H
+
+#include <stdint.h>
+
+typedef int16_t kernel_pid_t;
+
+typedef struct {
+    kernel_pid_t sender_pid;
+    uint16_t type;
+    union {
+        void *ptr;
+        uint32_t value;
+    } content;
+} msg_t;
+
+void msg_init_queue(msg_t *array, int num);
+int msg_receive(msg_t *m);
+int msg_send(msg_t *m, kernel_pid_t target_pid);
+int msg_try_send(msg_t *m, kernel_pid_t target_pid);
+
+#endif /* MSG_H */
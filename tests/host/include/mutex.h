@@ -0,0 +1,14 @@
+/* host stand-in: single threaded, locks are only counted */
+#ifndef MUTEX_H
+#define MUTEX_H
+
+typedef struct {
+    int locked;
+} mutex_t;
+
+#define MUTEX_INIT          { 0 }
+
+void mutex_lock(mutex_t *mutex);
+void mutex_unlock(mutex_t *mutex);
+
+#endif /* MUTEX_H */
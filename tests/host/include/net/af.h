@@ -0,0 +1,7 @@
+/* host stand-in of RIOT's net/af.h */
+#ifndef NET_AF_H
+#define NET_AF_H
+
+#include <sys/socket.h>
+
+#endif /* NET_AF_H */
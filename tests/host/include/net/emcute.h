@@ -0,0 +1,45 @@
+/* host stand-in of RIOT's net/emcute.h, see host/emcute.c */
+#ifndef NET_EMCUTE_H
+#define NET_EMCUTE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "net/sock/udp.h"
+
+enum {
+    EMCUTE_OK       =  0,
+    EMCUTE_NOGW     = -1,
+    EMCUTE_REJECT   = -2,
+    EMCUTE_OVERFLOW = -3,
+    EMCUTE_TIMEOUT  = -4,
+    EMCUTE_NOTSUP   = -5,
+};
+
+#define EMCUTE_QOS_0        (0x00)
+#define EMCUTE_QOS_1        (0x20)
+
+typedef struct {
+    const char *name;
+    uint16_t id;
+} emcute_topic_t;
+
+typedef void (*emcute_cb_t)(const emcute_topic_t *topic, void *data,
+                            size_t len);
+
+typedef struct emcute_sub {
+    struct emcute_sub *next;
+    emcute_topic_t topic;
+    emcute_cb_t cb;
+    void *arg;
+} emcute_sub_t;
+
+int emcute_con(sock_udp_ep_t *remote, bool clean, const char *will_topic,
+               const void *will_msg, size_t will_msg_len, unsigned flags);
+int emcute_discon(void);
+int emcute_sub(emcute_sub_t *sub, unsigned flags);
+int emcute_unsub(emcute_sub_t *sub);
+void emcute_run(uint16_t port, const char *id);
+
+#endif /* NET_EMCUTE_H */
@@ -0,0 +1,174 @@
+/* host stand-in of RIOT's gcoap and nanocoap API, see nanocoap.c. gcoap
+ * handlers get no context before 2018.01 (monica), define
+ * HOST_GCOAP_NO_CTX to build for that API. */
+#ifndef NET_GCOAP_H
+#define NET_GCOAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+
+#include "net/ipv6/addr.h"
+#include "net/sock/udp.h"
+
+#ifndef GCOAP_PDU_BUF_SIZE
+#define GCOAP_PDU_BUF_SIZE      (256)
+#endif
+#define GCOAP_RESP_OPTIONS_BUF  (4)
+#define GCOAP_MEMO_TIMEOUT      (1)
+#define GCOAP_MEMO_ERR          (2)
+#define NANOCOAP_URL_MAX        (64)
+#define NANOCOAP_QS_MAX         (64)
+
+#define COAP_GET                (0x1)
+#define COAP_POST               (0x2)
+#define COAP_PUT                (0x4)
+#define COAP_DELETE             (0x8)
+
+#define COAP_METHOD_GET         (1)
+#define COAP_METHOD_POST        (2)
+#define COAP_METHOD_PUT         (3)
+#define COAP_METHOD_DELETE      (4)
+
+#define COAP_TYPE_CON           (0)
+#define COAP_TYPE_NON           (1)
+#define COAP_TYPE_ACK           (2)
+#define COAP_TYPE_RST           (3)
+
+#define COAP_CLASS_REQ              (0)
+#define COAP_CLASS_SUCCESS          (2)
+#define COAP_CLASS_CLIENT_FAILURE   (4)
+#define COAP_CLASS_SERVER_FAILURE   (5)
+
+#define COAP_CODE_CONTENT           ((2 << 5) | 5)
+#define COAP_CODE_CHANGED           ((2 << 5) | 4)
+#define COAP_CODE_VALID             ((2 << 5) | 3)
+#define COAP_CODE_BAD_REQUEST       ((4 << 5) | 0)
+#define COAP_CODE_404               ((4 << 5) | 4)
+#define COAP_CODE_PATH_NOT_FOUND    COAP_CODE_404
+#define COAP_CODE_METHOD_NOT_ALLOWED ((4 << 5) | 5)
+#define COAP_CODE_INTERNAL_SERVER_ERROR ((5 << 5) | 0)
+
+#define COAP_FORMAT_TEXT        (0)
+#define COAP_FORMAT_LINK        (40)
+#define COAP_FORMAT_JSON        (50)
+#define COAP_FORMAT_NONE        (UINT16_MAX)
+
+#define COAP_OPT_URI_HOST       (3)
+#define COAP_OPT_OBSERVE        (6)
+#define COAP_OPT_URI_PATH       (11)
+#define COAP_OPT_CONTENT_FORMAT (12)
+#define COAP_OPT_URI_QUERY      (15)
+
+typedef struct __attribute__((packed)) {
+    uint8_t ver_t_tkl;
+    uint8_t code;
+    uint16_t id;
+    uint8_t data[];
+} coap_hdr_t;
+
+typedef struct {
+    coap_hdr_t *hdr;
+    uint8_t url[NANOCOAP_URL_MAX];
+    uint8_t qs[NANOCOAP_QS_MAX];
+    uint8_t *token;
+    uint8_t *payload;
+    unsigned payload_len;
+    uint16_t content_type;
+    uint32_t observe_value;
+} coap_pkt_t;
+
+#ifdef HOST_GCOAP_NO_CTX
+typedef ssize_t (*coap_handler_t)(coap_pkt_t *pkt, uint8_t *buf, size_t len);
+
+typedef struct {
+    const char *path;
+    unsigned methods;
+    coap_handler_t handler;
+} coap_resource_t;
+#else
+typedef ssize_t (*coap_handler_t)(coap_pkt_t *pkt, uint8_t *buf, size_t len,
+                                  void *context);
+
+typedef struct {
+    const char *path;
+    unsigned methods;
+    coap_handler_t handler;
+    void *context;
+} coap_resource_t;
+#endif
+
+typedef struct gcoap_listener {
+    coap_resource_t *resources;
+    size_t resources_len;
+    struct gcoap_listener *next;
+} gcoap_listener_t;
+
+typedef void (*gcoap_resp_handler_t)(unsigned req_state, coap_pkt_t *pdu,
+                                     sock_udp_ep_t *remote);
+
+/* the resources nanocoap's coap_handle_req() dispatches to */
+extern const coap_resource_t coap_resources[];
+extern const unsigned coap_resources_numof;
+
+static inline unsigned coap_get_ver(const coap_pkt_t *pkt)
+{
+    return (pkt->hdr->ver_t_tkl & 0xc0) >> 6;
+}
+
+static inline unsigned coap_get_type(const coap_pkt_t *pkt)
+{
+    return (pkt->hdr->ver_t_tkl & 0x30) >> 4;
+}
+
+static inline unsigned coap_get_token_len(const coap_pkt_t *pkt)
+{
+    return pkt->hdr->ver_t_tkl & 0xf;
+}
+
+static inline unsigned coap_get_code_class(const coap_pkt_t *pkt)
+{
+    return pkt->hdr->code >> 5;
+}
+
+static inline unsigned coap_get_code_detail(const coap_pkt_t *pkt)
+{
+    return pkt->hdr->code & 0x1f;
+}
+
+static inline unsigned coap_get_code_raw(const coap_pkt_t *pkt)
+{
+    return pkt->hdr->code;
+}
+
+static inline unsigned coap_get_id(const coap_pkt_t *pkt)
+{
+    const uint8_t *id = (const uint8_t *)&pkt->hdr->id;
+    return (id[0] << 8) | id[1];
+}
+
+static inline unsigned coap_get_total_hdr_len(const coap_pkt_t *pkt)
+{
+    return sizeof(coap_hdr_t) + coap_get_token_len(pkt);
+}
+
+int coap_parse(coap_pkt_t *pkt, uint8_t *buf, size_t len);
+ssize_t coap_handle_req(coap_pkt_t *pkt, uint8_t *resp_buf,
+                        unsigned resp_buf_len);
+
+void gcoap_register_listener(gcoap_listener_t *listener);
+int gcoap_req_init(coap_pkt_t *pdu, uint8_t *buf, size_t len, unsigned code,
+                   const char *path);
+size_t gcoap_req_send2(const uint8_t *buf, size_t len,
+                       const sock_udp_ep_t *remote,
+                       gcoap_resp_handler_t resp_handler);
+int gcoap_resp_init(coap_pkt_t *pdu, uint8_t *buf, size_t len,
+                    unsigned code);
+ssize_t gcoap_finish(coap_pkt_t *pdu, size_t payload_len, unsigned format);
+ssize_t gcoap_response(coap_pkt_t *pdu, uint8_t *buf, size_t len,
+                       unsigned code);
+
+#endif /* NET_GCOAP_H */
@@ -0,0 +1,29 @@
+/* host stand-in of RIOT's net/gnrc/netapi.h, there is no interface */
+#ifndef NET_GNRC_NETAPI_H
+#define NET_GNRC_NETAPI_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "net/gnrc/pkt.h"
+#include "thread.h"
+
+#define GNRC_NETAPI_MSG_TYPE_RCV    (0x0201)
+#define GNRC_NETAPI_MSG_TYPE_SND    (0x0202)
+
+typedef enum {
+    NETOPT_CHANNEL,
+    NETOPT_ADDRESS_LONG,
+    NETOPT_IPV6_ADDR,
+} netopt_t;
+
+int gnrc_netapi_get(kernel_pid_t pid, netopt_t opt, uint16_t context,
+                    void *data, size_t max_len);
+int gnrc_netapi_set(kernel_pid_t pid, netopt_t opt, uint16_t context,
+                    void *data, size_t data_len);
+
+/* sent packets are kept for host_udp_sent() and released */
+int gnrc_netapi_dispatch_send(gnrc_nettype_t type, uint32_t demux_ctx,
+                              gnrc_pktsnip_t *pkt);
+
+#endif /* NET_GNRC_NETAPI_H */
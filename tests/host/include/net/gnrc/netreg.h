@@ -0,0 +1,25 @@
+/* host stand-in of RIOT's net/gnrc/netreg.h, registration only */
+#ifndef NET_GNRC_NETREG_H
+#define NET_GNRC_NETREG_H
+
+#include <stdint.h>
+
+#include "net/gnrc/pkt.h"
+#include "thread.h"
+
+#define GNRC_NETREG_DEMUX_CTX_ALL   (0xffff0000)
+
+typedef struct gnrc_netreg_entry {
+    struct gnrc_netreg_entry *next;
+    uint32_t demux_ctx;
+    union {
+        kernel_pid_t pid;
+    } target;
+} gnrc_netreg_entry_t;
+
+#define GNRC_NETREG_ENTRY_INIT_PID(demux_ctx, pid)  { NULL, demux_ctx, \
+                                                      { pid } }
+
+int gnrc_netreg_register(gnrc_nettype_t type, gnrc_netreg_entry_t *entry);
+
+#endif /* NET_GNRC_NETREG_H */
@@ -0,0 +1,31 @@
+/* host stand-in of RIOT's net/gnrc/pkt.h */
+#ifndef NET_GNRC_PKT_H
+#define NET_GNRC_PKT_H
+
+#include <stddef.h>
+
+typedef enum {
+    GNRC_NETTYPE_UNDEF,
+    GNRC_NETTYPE_NETIF,
+    GNRC_NETTYPE_IPV6,
+    GNRC_NETTYPE_UDP,
+} gnrc_nettype_t;
+
+typedef struct gnrc_pktsnip {
+    struct gnrc_pktsnip *next;
+    void *data;
+    size_t size;
+    unsigned int users;
+    gnrc_nettype_t type;
+} gnrc_pktsnip_t;
+
+static inline gnrc_pktsnip_t *gnrc_pktsnip_search_type(gnrc_pktsnip_t *pkt,
+                                                       gnrc_nettype_t type)
+{
+    while ((pkt != NULL) && (pkt->type != type)) {
+        pkt = pkt->next;
+    }
+    return pkt;
+}
+
+#endif /* NET_GNRC_PKT_H */
@@ -0,0 +1,14 @@
+/* host stand-in of RIOT's net/gnrc/pktbuf.h, snips are allocated on the
+ * heap, see host_udp_dgram() and host_udp_sent() */
+#ifndef NET_GNRC_PKTBUF_H
+#define NET_GNRC_PKTBUF_H
+
+#include <stddef.h>
+
+#include "net/gnrc/pkt.h"
+
+gnrc_pktsnip_t *gnrc_pktbuf_add(gnrc_pktsnip_t *next, void *data, size_t size,
+                                gnrc_nettype_t type);
+void gnrc_pktbuf_release(gnrc_pktsnip_t *pkt);
+
+#endif /* NET_GNRC_PKTBUF_H */
@@ -0,0 +1,29 @@
+/* host stand-in of RIOT's net/ipv6/addr.h */
+#ifndef NET_IPV6_ADDR_H
+#define NET_IPV6_ADDR_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef union {
+    uint8_t u8[16];
+    uint16_t u16[8];
+    uint32_t u32[4];
+    uint64_t u64[2];
+} ipv6_addr_t;
+
+#define IPV6_ADDR_BIT_LEN       (128)
+#define IPV6_ADDR_MAX_STR_LEN   (sizeof("ffff:ffff:ffff:ffff:ffff:ffff:255.255.255.255"))
+
+static inline bool ipv6_addr_is_multicast(const ipv6_addr_t *addr)
+{
+    return (addr->u8[0] == 0xff);
+}
+
+bool ipv6_addr_is_global(const ipv6_addr_t *addr);
+bool ipv6_addr_equal(const ipv6_addr_t *a, const ipv6_addr_t *b);
+char *ipv6_addr_to_str(char *result, const ipv6_addr_t *addr, uint8_t result_len);
+ipv6_addr_t *ipv6_addr_from_str(ipv6_addr_t *result, const char *addr);
+
+#endif /* NET_IPV6_ADDR_H */
@@ -0,0 +1,24 @@
+/* host stand-in of RIOT's net/ipv6/hdr.h */
+#ifndef NET_IPV6_HDR_H
+#define NET_IPV6_HDR_H
+
+#include <stdint.h>
+
+#include "byteorder.h"
+#include "net/ipv6/addr.h"
+
+typedef struct {
+    uint32_t v_tc_fl;
+    network_uint16_t len;
+    uint8_t nh;
+    uint8_t hl;
+    ipv6_addr_t src;
+    ipv6_addr_t dst;
+} ipv6_hdr_t;
+
+static inline void ipv6_hdr_set_version(ipv6_hdr_t *hdr)
+{
+    ((uint8_t *)&hdr->v_tc_fl)[0] = 0x60;
+}
+
+#endif /* NET_IPV6_HDR_H */
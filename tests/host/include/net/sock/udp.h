@@ -0,0 +1,35 @@
+/* host stand-in of RIOT's net/sock/udp.h, nothing is sent or received */
+#ifndef NET_SOCK_UDP_H
+#define NET_SOCK_UDP_H
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "net/af.h"
+
+#define SOCK_ADDR_ANY_NETIF (0)
+#define SOCK_NO_TIMEOUT     (UINT32_MAX)
+#define SOCK_IPV6_EP_ANY    { .family = AF_INET6, \
+                              .netif = SOCK_ADDR_ANY_NETIF }
+
+typedef struct {
+    int family;
+    union {
+        uint8_t ipv6[16];
+    } addr;
+    uint16_t netif;
+    uint16_t port;
+} sock_udp_ep_t;
+
+typedef struct {
+    sock_udp_ep_t local;
+} sock_udp_t;
+
+int sock_udp_create(sock_udp_t *sock, const sock_udp_ep_t *local,
+                    const sock_udp_ep_t *remote, uint16_t flags);
+ssize_t sock_udp_recv(sock_udp_t *sock, void *data, size_t max_len,
+                      uint32_t timeout, sock_udp_ep_t *remote);
+ssize_t sock_udp_send(sock_udp_t *sock, const void *data, size_t len,
+                      const sock_udp_ep_t *remote);
+
+#endif /* NET_SOCK_UDP_H */
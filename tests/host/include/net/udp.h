@@ -0,0 +1,14 @@
+/* host stand-in of RIOT's net/udp.h */
+#ifndef NET_UDP_H
+#define NET_UDP_H
+
+#include "byteorder.h"
+
+typedef struct __attribute__((packed)) {
+    network_uint16_t src_port;
+    network_uint16_t dst_port;
+    network_uint16_t length;
+    network_uint16_t checksum;
+} udp_hdr_t;
+
+#endif /* NET_UDP_H */
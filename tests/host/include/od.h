@@ -0,0 +1,11 @@
+/* host stand-in of RIOT's od.h */
+#ifndef OD_H
+#define OD_H
+
+#include <stddef.h>
+
+#define OD_WIDTH_DEFAULT    (16)
+
+void od_hex_dump(const void *data, size_t data_len, unsigned width);
+
+#endif /* OD_H */
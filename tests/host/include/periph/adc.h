@@ -0,0 +1,19 @@
+/* host stand-in of RIOT's periph/adc.h */
+#ifndef PERIPH_ADC_H
+#define PERIPH_ADC_H
+
+#include <stdint.h>
+
+typedef unsigned adc_t;
+
+typedef enum {
+    ADC_RES_10BIT,
+    ADC_RES_12BIT,
+} adc_res_t;
+
+#define ADC_LINE(x)         (x)
+
+int adc_init(adc_t line);
+int adc_sample(adc_t line, adc_res_t res);
+
+#endif /* PERIPH_ADC_H */
@@ -0,0 +1,13 @@
+/* host stand-in of RIOT's periph/gpio.h */
+#ifndef PERIPH_GPIO_H
+#define PERIPH_GPIO_H
+
+typedef unsigned gpio_t;
+typedef void (*gpio_cb_t)(void *arg);
+
+#define GPIO_IN_PU          (1)
+#define GPIO_FALLING        (1)
+
+int gpio_init_int(gpio_t pin, int mode, int flank, gpio_cb_t cb, void *arg);
+
+#endif /* PERIPH_GPIO_H */
@@ -0,0 +1 @@
+/* host stand-in, sensors are simulated (BOARD_NATIVE) */
@@ -0,0 +1,29 @@
+/* host stand-in: threads are registered but never run, tests call the
+ * functions of a thread directly */
+#ifndef THREAD_H
+#define THREAD_H
+
+#include <stdint.h>
+
+#include "msg.h"
+
+#define THREAD_STACKSIZE_DEFAULT        (1024)
+#define THREAD_STACKSIZE_MAIN           (1024)
+#define THREAD_EXTRA_STACKSIZE_PRINTF   (512)
+#define THREAD_PRIORITY_MAIN            (7)
+#define THREAD_PRIORITY_IDLE            (15)
+#define THREAD_CREATE_STACKTEST         (8)
+
+#define KERNEL_PID_UNDEF                (0)
+#define KERNEL_PID_FIRST                (1)
+#define KERNEL_PID_LAST                 (32)
+
+typedef void *(*thread_task_func_t)(void *arg);
+
+kernel_pid_t thread_create(char *stack, int stacksize, char priority,
+                           int flags, thread_task_func_t task_func,
+                           void *arg, const char *name);
+kernel_pid_t thread_getpid(void);
+void thread_yield(void);
+
+#endif /* THREAD_H */
@@ -0,0 +1,27 @@
+/* host stand-in of RIOT's xtimer.h: a virtual clock, it only advances by
+ * sleeping or host_clock_advance(), see host.h */
+#ifndef XTIMER_H
+#define XTIMER_H
+
+#include <stdint.h>
+
+#include "msg.h"
+
+#define US_PER_SEC          (1000000U)
+#define US_PER_MS           (1000U)
+#define MS_PER_SEC          (1000U)
+
+typedef struct {
+    uint32_t target;
+    int armed;
+} xtimer_t;
+
+uint32_t xtimer_now_usec(void);
+uint64_t xtimer_now_usec64(void);
+void xtimer_usleep(uint32_t us);
+void xtimer_sleep(uint32_t seconds);
+void xtimer_set_msg(xtimer_t *timer, uint32_t offset, msg_t *msg,
+                    kernel_pid_t target_pid);
+void xtimer_remove(xtimer_t *timer);
+
+#endif /* XTIMER_H */
@@ -0,0 +1,213 @@
+/* host stand-in of the microcoap package: same API and semantics, including
+ * the 8 bit option numbers and the ACK type of every response, but bounds
+ * checked, fuzzing targets the application and not the package */
+
+#include <string.h>
+
+#include "coap.h"
+
+static int _parse_opt(coap_option_t *opt, uint16_t *running, const uint8_t **buf,
+                      const uint8_t *end)
+{
+    const uint8_t *p = *buf;
+    if (p >= end) {
+        return COAP_ERR_OPTION_TOO_SHORT_FOR_HEADER;
+    }
+    unsigned delta = p[0] >> 4;
+    unsigned len = p[0] & 0x0f;
+    p++;
+    unsigned *v[] = { &delta, &len };
+    for (unsigned i = 0; i < 2; i++) {
+        if (*v[i] == 13) {
+            if (p >= end) {
+                return COAP_ERR_OPTION_TOO_SHORT_FOR_HEADER;
+            }
+            *v[i] = 13 + p[0];
+            p++;
+        }
+        else if (*v[i] == 14) {
+            if ((end - p) < 2) {
+                return COAP_ERR_OPTION_TOO_SHORT_FOR_HEADER;
+            }
+            *v[i] = 269 + ((p[0] << 8) | p[1]);
+            p += 2;
+        }
+        else if (*v[i] == 15) {
+            return (i == 0) ? COAP_ERR_OPTION_DELTA_INVALID
+                            : COAP_ERR_OPTION_LEN_INVALID;
+        }
+    }
+    if ((size_t)(end - p) < len) {
+        return COAP_ERR_OPTION_TOO_BIG;
+    }
+    /* microcoap keeps option numbers in 8 bit */
+    opt->num = (uint8_t)(delta + *running);
+    opt->buf.p = p;
+    opt->buf.len = len;
+    *running += delta;
+    *buf = p + len;
+    return 0;
+}
+
+int coap_parse(coap_packet_t *pkt, const uint8_t *buf, size_t buflen)
+{
+    if (buflen < 4) {
+        return COAP_ERR_HEADER_TOO_SHORT;
+    }
+    pkt->hdr.ver = buf[0] >> 6;
+    pkt->hdr.t = (buf[0] >> 4) & 0x03;
+    pkt->hdr.tkl = buf[0] & 0x0f;
+    pkt->hdr.code = buf[1];
+    pkt->hdr.id[0] = buf[2];
+    pkt->hdr.id[1] = buf[3];
+    if (pkt->hdr.ver != 1) {
+        return COAP_ERR_VERSION_NOT_1;
+    }
+    if ((pkt->hdr.tkl > 8) || ((4U + pkt->hdr.tkl) > buflen)) {
+        return COAP_ERR_TOKEN_TOO_SHORT;
+    }
+    pkt->tok.p = (pkt->hdr.tkl > 0) ? buf + 4 : NULL;
+    pkt->tok.len = pkt->hdr.tkl;
+
+    const uint8_t *p = buf + 4 + pkt->hdr.tkl;
+    const uint8_t *end = buf + buflen;
+    uint16_t running = 0;
+    pkt->numopts = 0;
+    /* options beyond MAXOPT are ignored, like microcoap does */
+    while ((pkt->numopts < MAXOPT) && (p < end) && (*p != 0xff)) {
+        int rc = _parse_opt(&pkt->opts[pkt->numopts], &running, &p, end);
+        if (rc != 0) {
+            return rc;
+        }
+        pkt->numopts++;
+    }
+    if (((p + 1) < end) && (*p == 0xff)) {
+        pkt->payload.p = p + 1;
+        pkt->payload.len = end - (p + 1);
+    }
+    else {
+        pkt->payload.p = NULL;
+        pkt->payload.len = 0;
+    }
+    return 0;
+}
+
+const coap_option_t *coap_findOptions(const coap_packet_t *pkt, uint8_t num,
+                                      uint8_t *count)
+{
+    const coap_option_t *first = NULL;
+    *count = 0;
+    for (unsigned i = 0; i < pkt->numopts; i++) {
+        if (pkt->opts[i].num == num) {
+            if (first == NULL) {
+                first = &pkt->opts[i];
+            }
+            (*count)++;
+        }
+        else if (first != NULL) {
+            break;
+        }
+    }
+    return first;
+}
+
+static size_t _nibble(uint32_t val, uint8_t *nibble, uint8_t *ext)
+{
+    if (val < 13) {
+        *nibble = val;
+        return 0;
+    }
+    if (val < 269) {
+        *nibble = 13;
+        ext[0] = val - 13;
+        return 1;
+    }
+    *nibble = 14;
+    ext[0] = (val - 269) >> 8;
+    ext[1] = (val - 269) & 0xff;
+    return 2;
+}
+
+int coap_build(uint8_t *buf, size_t *buflen, const coap_packet_t *pkt)
+{
+    size_t max = *buflen;
+    if ((max < (4U + pkt->hdr.tkl)) || (pkt->hdr.tkl > 8)) {
+        return COAP_ERR_BUFFER_TOO_SMALL;
+    }
+    buf[0] = ((pkt->hdr.ver & 0x03) << 6) | ((pkt->hdr.t & 0x03) << 4) |
+             (pkt->hdr.tkl & 0x0f);
+    buf[1] = pkt->hdr.code;
+    buf[2] = pkt->hdr.id[0];
+    buf[3] = pkt->hdr.id[1];
+    if ((pkt->hdr.tkl > 0) && (pkt->hdr.tkl != pkt->tok.len)) {
+        return COAP_ERR_UNSUPPORTED;
+    }
+    size_t pos = 4;
+    if (pkt->hdr.tkl > 0) {
+        /* the token of a response built in place is already there */
+        memmove(buf + pos, pkt->tok.p, pkt->hdr.tkl);
+        pos += pkt->hdr.tkl;
+    }
+    uint16_t running = 0;
+    for (unsigned i = 0; i < pkt->numopts; i++) {
+        const coap_option_t *opt = &pkt->opts[i];
+        uint8_t ext[4];
+        uint8_t dn, ln;
+        if (opt->num < running) {
+            return COAP_ERR_OPTION_DELTA_INVALID;
+        }
+        size_t dl = _nibble(opt->num - running, &dn, ext);
+        size_t ll = _nibble(opt->buf.len, &ln, ext + dl);
+        if ((pos + 1 + dl + ll + opt->buf.len) > max) {
+            return COAP_ERR_BUFFER_TOO_SMALL;
+        }
+        buf[pos++] = (dn << 4) | ln;
+        memcpy(buf + pos, ext, dl + ll);
+        pos += dl + ll;
+        if (opt->buf.len > 0) {
+            memmove(buf + pos, opt->buf.p, opt->buf.len);
+        }
+        pos += opt->buf.len;
+        running = opt->num;
+    }
+    if (pkt->payload.len > 0) {
+        if ((pos + 1 + pkt->payload.len) > max) {
+            return COAP_ERR_BUFFER_TOO_SMALL;
+        }
+        buf[pos++] = 0xff;
+        memmove(buf + pos, pkt->payload.p, pkt->payload.len);
+        pos += pkt->payload.len;
+    }
+    *buflen = pos;
+    return 0;
+}
+
+int coap_make_response(coap_rw_buffer_t *scratch, coap_packet_t *pkt,
+                       const uint8_t *content, size_t content_len,
+                       uint8_t msgid_hi, uint8_t msgid_lo,
+                       const coap_buffer_t *tok, coap_responsecode_t rspcode,
+                       coap_content_type_t content_type)
+{
+    pkt->hdr.ver = 0x01;
+    pkt->hdr.t = COAP_TYPE_ACK;
+    pkt->hdr.tkl = 0;
+    pkt->hdr.code = rspcode;
+    pkt->hdr.id[0] = msgid_hi;
+    pkt->hdr.id[1] = msgid_lo;
+    pkt->numopts = 1;
+    if (tok) {
+        pkt->hdr.tkl = tok->len;
+        pkt->tok = *tok;
+    }
+    pkt->opts[0].num = COAP_OPTION_CONTENT_FORMAT;
+    pkt->opts[0].buf.p = scratch->p;
+    if (scratch->len < 2) {
+        return COAP_ERR_BUFFER_TOO_SMALL;
+    }
+    scratch->p[0] = ((uint16_t)content_type & 0xff00) >> 8;
+    scratch->p[1] = ((uint16_t)content_type & 0x00ff);
+    pkt->opts[0].buf.len = 2;
+    pkt->payload.p = content;
+    pkt->payload.len = content_len;
+    return 0;
+}
@@ -0,0 +1,300 @@
+/* host stand-in of gcoap and nanocoap as of 2017/2018: requests are handled
+ * in place in one buffer, coap_parse() leaves the payload pointer unset if
+ * there is no payload, gcoap writes the payload behind room reserved for
+ * the options and moves it in gcoap_finish() */
+
+#include <errno.h>
+#include <string.h>
+
+#include "host.h"
+#include "net/gcoap.h"
+
+#define REQ_OPTIONS_BUF     (NANOCOAP_URL_MAX + 8)
+
+static gcoap_listener_t *listeners;
+static uint16_t next_mid;
+
+static int _decode(unsigned val, const uint8_t **pos, const uint8_t *end)
+{
+    if (val == 13) {
+        if (*pos >= end) {
+            return -1;
+        }
+        val = 13 + **pos;
+        *pos += 1;
+    }
+    else if (val == 14) {
+        if ((end - *pos) < 2) {
+            return -1;
+        }
+        val = 269 + (((*pos)[0] << 8) | (*pos)[1]);
+        *pos += 2;
+    }
+    else if (val == 15) {
+        return -1;
+    }
+    return (int)val;
+}
+
+/* append a segment with its separator, keeps the string terminated */
+static int _append(uint8_t *str, size_t max, char sep, const uint8_t *seg,
+                   size_t len)
+{
+    size_t pos = strlen((char *)str);
+    if ((pos + 1 + len + 1) > max) {
+        return -1;
+    }
+    str[pos++] = sep;
+    memcpy(str + pos, seg, len);
+    str[pos + len] = '\0';
+    return 0;
+}
+
+int coap_parse(coap_pkt_t *pkt, uint8_t *buf, size_t len)
+{
+    const uint8_t *end = buf + len;
+    pkt->hdr = (coap_hdr_t *)buf;
+    memset(pkt->url, 0, sizeof(pkt->url));
+    memset(pkt->qs, 0, sizeof(pkt->qs));
+    pkt->payload_len = 0;
+    pkt->content_type = COAP_FORMAT_NONE;
+    pkt->observe_value = UINT32_MAX;
+    if ((len < sizeof(coap_hdr_t)) || (coap_get_ver(pkt) != 1) ||
+        (coap_get_token_len(pkt) > 8) ||
+        (len < coap_get_total_hdr_len(pkt))) {
+        return -EBADMSG;
+    }
+    pkt->token = buf + sizeof(coap_hdr_t);
+    const uint8_t *pos = pkt->token + coap_get_token_len(pkt);
+    int num = 0;
+    while (pos < end) {
+        uint8_t byte = *pos++;
+        if (byte == 0xff) {
+            /* only set if there is a payload marker */
+            pkt->payload = (uint8_t *)pos;
+            pkt->payload_len = end - pos;
+            break;
+        }
+        int delta = _decode(byte >> 4, &pos, end);
+        int olen = _decode(byte & 0x0f, &pos, end);
+        if ((delta < 0) || (olen < 0) || ((end - pos) < olen)) {
+            return -EBADMSG;
+        }
+        num += delta;
+        switch (num) {
+            case COAP_OPT_URI_PATH:
+                if (_append(pkt->url, sizeof(pkt->url), '/', pos, olen) < 0) {
+                    return -EBADMSG;
+                }
+                break;
+            case COAP_OPT_URI_QUERY:
+                if (_append(pkt->qs, sizeof(pkt->qs),
+                            (pkt->qs[0] == '\0') ? '?' : '&', pos, olen) < 0) {
+                    return -EBADMSG;
+                }
+                break;
+            case COAP_OPT_CONTENT_FORMAT:
+                pkt->content_type = 0;
+                for (int i = 0; i < olen; i++) {
+                    pkt->content_type = (pkt->content_type << 8) | pos[i];
+                }
+                break;
+            case COAP_OPT_OBSERVE:
+                pkt->observe_value = 0;
+                for (int i = 0; (i < olen) && (i < 3); i++) {
+                    pkt->observe_value = (pkt->observe_value << 8) | pos[i];
+                }
+                break;
+            default:
+                break;
+        }
+        pos += olen;
+    }
+    return 0;
+}
+
+/* write an option, returns the new position */
+static uint8_t *_put_opt(uint8_t *pos, unsigned delta, const uint8_t *val,
+                         size_t len)
+{
+    uint8_t *start = pos++;
+    unsigned dn = delta;
+    if (delta >= 269) {
+        dn = 14;
+        *pos++ = (delta - 269) >> 8;
+        *pos++ = (delta - 269) & 0xff;
+    }
+    else if (delta >= 13) {
+        dn = 13;
+        *pos++ = delta - 13;
+    }
+    unsigned ln = len;
+    if (len >= 13) {
+        ln = 13;
+        *pos++ = len - 13;
+    }
+    *start = (dn << 4) | ln;
+    memcpy(pos, val, len);
+    return pos + len;
+}
+
+int gcoap_resp_init(coap_pkt_t *pdu, uint8_t *buf, size_t len, unsigned code)
+{
+    if (coap_get_type(pdu) == COAP_TYPE_CON) {
+        pdu->hdr->ver_t_tkl = (pdu->hdr->ver_t_tkl & 0xcf) |
+                              (COAP_TYPE_ACK << 4);
+    }
+    pdu->hdr->code = code;
+    unsigned hdr_len = coap_get_total_hdr_len(pdu);
+    pdu->payload = buf + hdr_len + GCOAP_RESP_OPTIONS_BUF;
+    pdu->payload_len = len - hdr_len - GCOAP_RESP_OPTIONS_BUF;
+    pdu->content_type = COAP_FORMAT_NONE;
+    return 0;
+}
+
+int gcoap_req_init(coap_pkt_t *pdu, uint8_t *buf, size_t len, unsigned code,
+                   const char *path)
+{
+    if ((strlen(path) >= sizeof(pdu->url)) ||
+        (len < (sizeof(coap_hdr_t) + REQ_OPTIONS_BUF))) {
+        return -1;
+    }
+    pdu->hdr = (coap_hdr_t *)buf;
+    pdu->hdr->ver_t_tkl = 0x40 | (COAP_TYPE_NON << 4);
+    pdu->hdr->code = code;
+    next_mid++;
+    memcpy(&pdu->hdr->id, (uint8_t []){ next_mid >> 8, next_mid & 0xff }, 2);
+    strcpy((char *)pdu->url, path);
+    pdu->qs[0] = '\0';
+    pdu->token = buf + sizeof(coap_hdr_t);
+    pdu->payload = buf + sizeof(coap_hdr_t) + REQ_OPTIONS_BUF;
+    pdu->payload_len = len - sizeof(coap_hdr_t) - REQ_OPTIONS_BUF;
+    return 0;
+}
+
+ssize_t gcoap_finish(coap_pkt_t *pdu, size_t payload_len, unsigned format)
+{
+    uint8_t *pos = (uint8_t *)pdu->hdr + coap_get_total_hdr_len(pdu);
+    unsigned last = 0;
+    if (coap_get_code_class(pdu) == COAP_CLASS_REQ) {
+        const char *seg = (const char *)pdu->url;
+        while (*seg == '/') {
+            size_t len = strcspn(seg + 1, "/");
+            pos = _put_opt(pos, COAP_OPT_URI_PATH - last,
+                           (const uint8_t *)seg + 1, len);
+            last = COAP_OPT_URI_PATH;
+            seg += 1 + len;
+        }
+    }
+    if (format != COAP_FORMAT_NONE) {
+        uint8_t val[2] = { format >> 8, format & 0xff };
+        size_t len = (format > 0xff) ? 2 : (format > 0) ? 1 : 0;
+        pos = _put_opt(pos, COAP_OPT_CONTENT_FORMAT - last, val + 2 - len, len);
+    }
+    if (payload_len > 0) {
+        *pos++ = 0xff;
+        memmove(pos, pdu->payload, payload_len);
+        pos += payload_len;
+    }
+    return pos - (uint8_t *)pdu->hdr;
+}
+
+ssize_t gcoap_response(coap_pkt_t *pdu, uint8_t *buf, size_t len,
+                       unsigned code)
+{
+    gcoap_resp_init(pdu, buf, len, code);
+    return gcoap_finish(pdu, 0, COAP_FORMAT_NONE);
+}
+
+void gcoap_register_listener(gcoap_listener_t *listener)
+{
+    listener->next = listeners;
+    listeners = listener;
+}
+
+size_t gcoap_req_send2(const uint8_t *buf, size_t len,
+                       const sock_udp_ep_t *remote,
+                       gcoap_resp_handler_t resp_handler)
+{
+    (void)buf;
+    (void)remote;
+    (void)resp_handler;
+    return len;
+}
+
+static ssize_t _call(const coap_resource_t *resource, coap_pkt_t *pkt,
+                     uint8_t *buf, size_t len)
+{
+#ifdef HOST_GCOAP_NO_CTX
+    return resource->handler(pkt, buf, len);
+#else
+    return resource->handler(pkt, buf, len, resource->context);
+#endif
+}
+
+static unsigned _method_flag(const coap_pkt_t *pkt)
+{
+    unsigned detail = coap_get_code_detail(pkt);
+    return ((detail > 0) && (detail <= 4)) ? (1U << (detail - 1)) : 0;
+}
+
+ssize_t coap_handle_req(coap_pkt_t *pkt, uint8_t *resp_buf,
+                        unsigned resp_buf_len)
+{
+    if (coap_get_code_class(pkt) != COAP_CLASS_REQ) {
+        return -EBADMSG;
+    }
+    unsigned flag = _method_flag(pkt);
+    for (unsigned i = 0; i < coap_resources_numof; i++) {
+        if (!(coap_resources[i].methods & flag)) {
+            continue;
+        }
+        int res = strcmp((char *)pkt->url, coap_resources[i].path);
+        if (res > 0) {
+            continue;
+        }
+        else if (res < 0) {
+            break;
+        }
+        return _call(&coap_resources[i], pkt, resp_buf, resp_buf_len);
+    }
+    return gcoap_response(pkt, resp_buf, resp_buf_len, COAP_CODE_404);
+}
+
+ssize_t host_gcoap_request(uint8_t *buf, size_t len, size_t max)
+{
+    coap_pkt_t pdu;
+    /* gcoap keeps the packet on its stack, uninitialized */
+    memset(&pdu, 0xa5, sizeof(pdu));
+    if ((coap_parse(&pdu, buf, len) < 0) ||
+        (coap_get_code_class(&pdu) != COAP_CLASS_REQ)) {
+        return -1;
+    }
+    const coap_resource_t *resource = NULL;
+    int path_found = 0;
+    for (gcoap_listener_t *l = listeners; l && !resource; l = l->next) {
+        for (size_t i = 0; i < l->resources_len; i++) {
+            int res = strcmp((char *)pdu.url, l->resources[i].path);
+            if (res > 0) {
+                continue;
+            }
+            else if (res < 0) {
+                break;
+            }
+            path_found = 1;
+            if (l->resources[i].methods & _method_flag(&pdu)) {
+                resource = &l->resources[i];
+                break;
+            }
+        }
+    }
+    if (resource == NULL) {
+        return gcoap_response(&pdu, buf, max, path_found
+                              ? COAP_CODE_METHOD_NOT_ALLOWED : COAP_CODE_404);
+    }
+    ssize_t res = _call(resource, &pdu, buf, max);
+    if (res < 0) {
+        res = gcoap_response(&pdu, buf, max, COAP_CODE_INTERNAL_SERVER_ERROR);
+    }
+    return res;
+}
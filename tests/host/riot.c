@@ -0,0 +1,361 @@
+/* host stand-ins of the RIOT kernel and system modules */
+
+#include <arpa/inet.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "event.h"
+#include "host.h"
+#include "mutex.h"
+#include "od.h"
+#include "periph/adc.h"
+#include "periph/gpio.h"
+#include "thread.h"
+#include "xtimer.h"
+#include "net/gnrc/netapi.h"
+#include "net/gnrc/netreg.h"
+#include "net/gnrc/pktbuf.h"
+#include "net/ipv6/addr.h"
+#include "net/ipv6/hdr.h"
+#include "net/udp.h"
+#include "net/sock/udp.h"
+
+#define HOST_MSG_LOG    (16U)
+#define HOST_UDP_LOG    (8U)
+#define HOST_UDP_MAX    (512U)
+
+kernel_pid_t host_pid = KERNEL_PID_FIRST;
+unsigned host_msgs;
+unsigned host_led_switched;
+int host_adc_value;
+unsigned host_udp_sends;
+
+/* starts at 1 s, code treating 0 as unset must not see it */
+static uint64_t clock_us = US_PER_SEC;
+static kernel_pid_t next_pid = KERNEL_PID_FIRST + 1;
+static struct {
+    msg_t msg;
+    kernel_pid_t target;
+} msg_log[HOST_MSG_LOG];
+static struct {
+    ipv6_addr_t dst;
+    uint16_t port;
+    size_t len;
+    uint8_t data[HOST_UDP_MAX];
+} udp_log[HOST_UDP_LOG];
+
+void host_clock_advance(uint32_t us)
+{
+    clock_us += us;
+}
+
+uint32_t xtimer_now_usec(void)
+{
+    return (uint32_t)clock_us;
+}
+
+uint64_t xtimer_now_usec64(void)
+{
+    return clock_us;
+}
+
+void xtimer_usleep(uint32_t us)
+{
+    clock_us += us;
+}
+
+void xtimer_sleep(uint32_t seconds)
+{
+    clock_us += (uint64_t)seconds * US_PER_SEC;
+}
+
+void xtimer_set_msg(xtimer_t *timer, uint32_t offset, msg_t *msg,
+                    kernel_pid_t target_pid)
+{
+    (void)msg;
+    (void)target_pid;
+    timer->target = (uint32_t)clock_us + offset;
+    timer->armed = 1;
+}
+
+void xtimer_remove(xtimer_t *timer)
+{
+    timer->armed = 0;
+}
+
+kernel_pid_t thread_create(char *stack, int stacksize, char priority,
+                           int flags, thread_task_func_t task_func,
+                           void *arg, const char *name)
+{
+    (void)stack;
+    (void)stacksize;
+    (void)priority;
+    (void)flags;
+    (void)task_func;
+    (void)arg;
+    (void)name;
+    return (next_pid <= KERNEL_PID_LAST) ? next_pid++ : -1;
+}
+
+kernel_pid_t thread_getpid(void)
+{
+    return host_pid;
+}
+
+void thread_yield(void)
+{
+}
+
+void mutex_lock(mutex_t *mutex)
+{
+    mutex->locked++;
+}
+
+void mutex_unlock(mutex_t *mutex)
+{
+    mutex->locked--;
+}
+
+void msg_init_queue(msg_t *array, int num)
+{
+    (void)array;
+    (void)num;
+}
+
+int msg_receive(msg_t *m)
+{
+    (void)m;
+    return -1;
+}
+
+int msg_send(msg_t *m, kernel_pid_t target_pid)
+{
+    unsigned idx = host_msgs++ % HOST_MSG_LOG;
+    msg_log[idx].msg = *m;
+    msg_log[idx].msg.sender_pid = host_pid;
+    msg_log[idx].target = target_pid;
+    return 1;
+}
+
+int msg_try_send(msg_t *m, kernel_pid_t target_pid)
+{
+    return msg_send(m, target_pid);
+}
+
+void event_post(event_queue_t *queue, event_t *event)
+{
+    (void)queue;
+    (void)event;
+}
+
+const msg_t *host_msg(unsigned back, kernel_pid_t *target)
+{
+    if ((back >= host_msgs) || (back >= HOST_MSG_LOG)) {
+        return NULL;
+    }
+    unsigned idx = (host_msgs - 1 - back) % HOST_MSG_LOG;
+    if (target) {
+        *target = msg_log[idx].target;
+    }
+    return &msg_log[idx].msg;
+}
+
+void od_hex_dump(const void *data, size_t data_len, unsigned width)
+{
+    (void)data;
+    (void)data_len;
+    (void)width;
+}
+
+int gpio_init_int(gpio_t pin, int mode, int flank, gpio_cb_t cb, void *arg)
+{
+    (void)pin;
+    (void)mode;
+    (void)flank;
+    (void)cb;
+    (void)arg;
+    return 0;
+}
+
+int adc_init(adc_t line)
+{
+    (void)line;
+    return 0;
+}
+
+int adc_sample(adc_t line, adc_res_t res)
+{
+    (void)line;
+    (void)res;
+    return host_adc_value;
+}
+
+int gnrc_netapi_get(kernel_pid_t pid, netopt_t opt, uint16_t context,
+                    void *data, size_t max_len)
+{
+    (void)pid;
+    (void)opt;
+    (void)context;
+    (void)data;
+    (void)max_len;
+    return -1;
+}
+
+int gnrc_netapi_set(kernel_pid_t pid, netopt_t opt, uint16_t context,
+                    void *data, size_t data_len)
+{
+    (void)pid;
+    (void)opt;
+    (void)context;
+    (void)data;
+    (void)data_len;
+    return -1;
+}
+
+bool ipv6_addr_is_global(const ipv6_addr_t *addr)
+{
+    return ((addr->u8[0] & 0xe0) == 0x20) || ((addr->u8[0] & 0xfe) == 0xfc);
+}
+
+bool ipv6_addr_equal(const ipv6_addr_t *a, const ipv6_addr_t *b)
+{
+    return memcmp(a, b, sizeof(*a)) == 0;
+}
+
+char *ipv6_addr_to_str(char *result, const ipv6_addr_t *addr,
+                       uint8_t result_len)
+{
+    return (char *)inet_ntop(AF_INET6, addr, result, result_len);
+}
+
+ipv6_addr_t *ipv6_addr_from_str(ipv6_addr_t *result, const char *addr)
+{
+    return (inet_pton(AF_INET6, addr, result) == 1) ? result : NULL;
+}
+
+gnrc_pktsnip_t *gnrc_pktbuf_add(gnrc_pktsnip_t *next, void *data, size_t size,
+                                gnrc_nettype_t type)
+{
+    gnrc_pktsnip_t *snip = calloc(1, sizeof(*snip) + size);
+    if (snip == NULL) {
+        return NULL;
+    }
+    snip->next = next;
+    snip->data = (size > 0) ? (snip + 1) : NULL;
+    snip->size = size;
+    snip->users = 1;
+    snip->type = type;
+    if ((data != NULL) && (size > 0)) {
+        memcpy(snip->data, data, size);
+    }
+    return snip;
+}
+
+/* the whole packet goes with its head, snips are not shared */
+void gnrc_pktbuf_release(gnrc_pktsnip_t *pkt)
+{
+    if ((pkt == NULL) || (--pkt->users > 0)) {
+        return;
+    }
+    while (pkt != NULL) {
+        gnrc_pktsnip_t *next = pkt->next;
+        free(pkt);
+        pkt = next;
+    }
+}
+
+int gnrc_netreg_register(gnrc_nettype_t type, gnrc_netreg_entry_t *entry)
+{
+    (void)type;
+    (void)entry;
+    return 0;
+}
+
+int gnrc_netapi_dispatch_send(gnrc_nettype_t type, uint32_t demux_ctx,
+                              gnrc_pktsnip_t *pkt)
+{
+    (void)type;
+    (void)demux_ctx;
+    gnrc_pktsnip_t *ip = gnrc_pktsnip_search_type(pkt, GNRC_NETTYPE_IPV6);
+    gnrc_pktsnip_t *udp = gnrc_pktsnip_search_type(pkt, GNRC_NETTYPE_UDP);
+    if ((ip == NULL) || (udp == NULL)) {
+        return 0;
+    }
+    unsigned idx = host_udp_sends++ % HOST_UDP_LOG;
+    memcpy(&udp_log[idx].dst, &((ipv6_hdr_t *)ip->data)->dst,
+           sizeof(udp_log[idx].dst));
+    udp_log[idx].port = byteorder_ntohs(((udp_hdr_t *)udp->data)->dst_port);
+    udp_log[idx].len = 0;
+    for (gnrc_pktsnip_t *s = udp->next; s != NULL; s = s->next) {
+        if ((udp_log[idx].len + s->size) <= HOST_UDP_MAX) {
+            memcpy(udp_log[idx].data + udp_log[idx].len, s->data, s->size);
+            udp_log[idx].len += s->size;
+        }
+    }
+    gnrc_pktbuf_release(pkt);
+    return 1;
+}
+
+gnrc_pktsnip_t *host_udp_dgram(const char *src, uint16_t port, const char *dst,
+                               const void *data, size_t len)
+{
+    /* like gnrc_udp passes it: payload, UDP header, IPv6 header */
+    gnrc_pktsnip_t *ip = gnrc_pktbuf_add(NULL, NULL, sizeof(ipv6_hdr_t),
+                                         GNRC_NETTYPE_IPV6);
+    gnrc_pktsnip_t *udp = gnrc_pktbuf_add(ip, NULL, sizeof(udp_hdr_t),
+                                          GNRC_NETTYPE_UDP);
+    gnrc_pktsnip_t *pkt = gnrc_pktbuf_add(udp, (void *)data, len,
+                                          GNRC_NETTYPE_UNDEF);
+    ipv6_addr_from_str(&((ipv6_hdr_t *)ip->data)->src, src);
+    ipv6_addr_from_str(&((ipv6_hdr_t *)ip->data)->dst, dst);
+    ((udp_hdr_t *)udp->data)->src_port = byteorder_htons(port);
+    ((udp_hdr_t *)udp->data)->dst_port = byteorder_htons(5683);
+    return pkt;
+}
+
+const uint8_t *host_udp_sent(unsigned back, ipv6_addr_t *dst, uint16_t *port,
+                             size_t *len)
+{
+    if ((back >= host_udp_sends) || (back >= HOST_UDP_LOG)) {
+        return NULL;
+    }
+    unsigned idx = (host_udp_sends - 1 - back) % HOST_UDP_LOG;
+    if (dst) {
+        *dst = udp_log[idx].dst;
+    }
+    if (port) {
+        *port = udp_log[idx].port;
+    }
+    *len = udp_log[idx].len;
+    return udp_log[idx].data;
+}
+
+int sock_udp_create(sock_udp_t *sock, const sock_udp_ep_t *local,
+                    const sock_udp_ep_t *remote, uint16_t flags)
+{
+    (void)sock;
+    (void)local;
+    (void)remote;
+    (void)flags;
+    return -1;
+}
+
+ssize_t sock_udp_recv(sock_udp_t *sock, void *data, size_t max_len,
+                      uint32_t timeout, sock_udp_ep_t *remote)
+{
+    (void)sock;
+    (void)data;
+    (void)max_len;
+    (void)timeout;
+    (void)remote;
+    return -1;
+}
+
+ssize_t sock_udp_send(sock_udp_t *sock, const void *data, size_t len,
+                      const sock_udp_ep_t *remote)
+{
+    (void)sock;
+    (void)data;
+    (void)remote;
+    return len;
+}
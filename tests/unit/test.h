@@ -0,0 +1,43 @@
+/* minimal test harness of the host tests, a test binary runs all TEST()s
+ * listed in its main() and exits non-zero if any assertion failed */
+#ifndef TEST_H
+#define TEST_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+extern unsigned test_failed;
+
+#define TEST_ASSERT(cond) do { \
+        if (!(cond)) { \
+            printf("%s:%d: %s: assertion '%s' failed\n", \
+                   __FILE__, __LINE__, __func__, #cond); \
+            test_failed++; \
+            return; \
+        } \
+    } while (0)
+
+#define TEST_ASSERT_EQ(a, b) do { \
+        long long _a = (long long)(a), _b = (long long)(b); \
+        if (_a != _b) { \
+            printf("%s:%d: %s: %s == %lld, expected %lld\n", \
+                   __FILE__, __LINE__, __func__, #a, _a, _b); \
+            test_failed++; \
+            return; \
+        } \
+    } while (0)
+
+#define TEST(fn) do { \
+        unsigned _failed = test_failed; \
+        fn(); \
+        printf("%-40s %s\n", #fn, (test_failed == _failed) ? "ok" : "FAIL"); \
+    } while (0)
+
+#define TEST_DEFINE_MAIN_STATE  unsigned test_failed
+
+#define TEST_EXIT() do { \
+        printf("%s\n", test_failed ? "FAILED" : "PASSED"); \
+        return test_failed ? EXIT_FAILURE : EXIT_SUCCESS; \
+    } while (0)
+
+#endif /* TEST_H */
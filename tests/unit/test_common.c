@@ -0,0 +1,377 @@
+/* tests of the shared code in common/ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "host.h"
+#include "test.h"
+#include "xtimer.h"
+
+#include "coap_dispatch.h"
+#include "coap_etag.h"
+#include "coap_group.h"
+#include "coap_udp.h"
+#include "dlog.h"
+#include "net/gnrc/pktbuf.h"
+#include "node_info.h"
+#include "sensor_reg.h"
+#include "timesync.h"
+
+TEST_DEFINE_MAIN_STATE;
+
+typedef struct {
+    const char *path;
+    int id;
+} res_t;
+
+static const res_t table[] = {
+    { "/.well-known/core", 0 },
+    { "/a", 1 },
+    { "/a/b", 2 },
+    { "/b", 3 },
+    { "/b", 4 },
+    { "/ba", 5 },
+};
+
+#define TABLE_NUMOF (sizeof(table) / sizeof(table[0]))
+
+static int _find(const char *p1, const char *p2)
+{
+    coap_dispatch_seg_t segs[2];
+    unsigned n = 0;
+    if (p1) {
+        segs[n].p = (const uint8_t *)p1;
+        segs[n++].len = strlen(p1);
+    }
+    if (p2) {
+        segs[n].p = (const uint8_t *)p2;
+        segs[n++].len = strlen(p2);
+    }
+    return coap_dispatch_find(table, TABLE_NUMOF, sizeof(table[0]), segs, n);
+}
+
+static void test_dispatch(void)
+{
+    TEST_ASSERT_EQ(coap_dispatch_check(table, TABLE_NUMOF, sizeof(table[0])), 0);
+    TEST_ASSERT_EQ(_find(".well-known", "core"), 0);
+    TEST_ASSERT_EQ(_find("a", NULL), 1);
+    TEST_ASSERT_EQ(_find("a", "b"), 2);
+    /* first of adjacent entries with the same path */
+    TEST_ASSERT_EQ(_find("b", NULL), 3);
+    TEST_ASSERT_EQ(_find("ba", NULL), 5);
+    TEST_ASSERT_EQ(_find("c", NULL), -1);
+    TEST_ASSERT_EQ(_find("a", "c"), -1);
+    TEST_ASSERT_EQ(_find(NULL, NULL), -1);
+    /* larger tables are searched binary */
+    static char names[4 * COAP_DISPATCH_LINEAR_MAX][8];
+    static res_t big[4 * COAP_DISPATCH_LINEAR_MAX];
+    for (unsigned i = 0; i < 4 * COAP_DISPATCH_LINEAR_MAX; i++) {
+        /* duplicates in pairs */
+        snprintf(names[i], sizeof(names[i]), "/r%03u", i / 2);
+        big[i].path = names[i];
+    }
+    for (unsigned i = 0; i < 4 * COAP_DISPATCH_LINEAR_MAX; i++) {
+        coap_dispatch_seg_t seg = { (const uint8_t *)names[i] + 1, 4 };
+        TEST_ASSERT_EQ(coap_dispatch_find(big, i + 1, sizeof(big[0]), &seg, 1),
+                       i & ~1U);
+    }
+    coap_dispatch_seg_t miss = { (const uint8_t *)"r0005", 5 };
+    TEST_ASSERT_EQ(coap_dispatch_find(big, 4 * COAP_DISPATCH_LINEAR_MAX,
+                                      sizeof(big[0]), &miss, 1), -1);
+    static const res_t unsorted[] = { { "/b", 0 }, { "/a", 1 } };
+    TEST_ASSERT_EQ(coap_dispatch_check(unsorted, 2, sizeof(unsorted[0])), 1);
+}
+
+static void test_etag(void)
+{
+    uint8_t etag[COAP_ETAG_LEN], other[COAP_ETAG_LEN];
+    coap_etag_from_gen(1, etag);
+    coap_etag_from_gen(2, other);
+    TEST_ASSERT(memcmp(etag, other, sizeof(etag)) != 0);
+
+    /* second of two tags, then Uri-Path */
+    uint8_t opts[] = { 0x44, 0, 0, 0, 0, 0x04, 0, 0, 0, 0, 0x71, 'x', 0xff };
+    memcpy(opts + 6, etag, sizeof(etag));
+    TEST_ASSERT_EQ(coap_etag_match(opts, sizeof(opts), etag, sizeof(etag)), 1);
+    TEST_ASSERT_EQ(coap_etag_match(opts, sizeof(opts), other, sizeof(other)), 0);
+    /* truncated option */
+    TEST_ASSERT_EQ(coap_etag_match(opts, 8, etag, sizeof(etag)), 0);
+    /* Uri-Path before a tag ends the walk */
+    uint8_t late[] = { 0xb1, 'x', 0x04, 0, 0, 0, 0 };
+    memcpy(late + 3, etag, sizeof(etag));
+    TEST_ASSERT_EQ(coap_etag_match(late, sizeof(late), etag, sizeof(etag)), 0);
+
+    /* response with token, Content-Format 50 and payload */
+    uint8_t msg[24] = { 0x62, 0x45, 0, 1, 't', 'k', 0xc1, 50, 0xff, 'x' };
+    TEST_ASSERT_EQ(coap_etag_insert(msg, 10, sizeof(msg), etag, 4), 15);
+    static const uint8_t expect[] = { 0x44, 0, 0, 0, 0, 0x81, 50, 0xff, 'x' };
+    TEST_ASSERT(memcmp(msg + 6, expect, 1) == 0);
+    TEST_ASSERT(memcmp(msg + 7, etag, 4) == 0);
+    TEST_ASSERT(memcmp(msg + 11, expect + 5, 4) == 0);
+    /* no option, no payload */
+    uint8_t valid[9] = { 0x60, 0x43, 0, 1 };
+    TEST_ASSERT_EQ(coap_etag_insert(valid, 4, sizeof(valid), etag, 4), 9);
+    TEST_ASSERT_EQ(coap_etag_insert(valid, 4, 8, etag, 4), -1);
+    /* an option before the tag cannot be kept in order */
+    uint8_t host[8] = { 0x60, 0x45, 0, 1, 0x31, 'h' };
+    TEST_ASSERT_EQ(coap_etag_insert(host, 6, sizeof(host), etag, 1), -1);
+    /* extended delta shrinks, Uri-Query 15 becomes 11 */
+    uint8_t query[12] = { 0x60, 0x45, 0, 1, 0xd1, 2, 'q' };
+    TEST_ASSERT_EQ(coap_etag_insert(query, 7, sizeof(query), etag, 1), 8);
+    TEST_ASSERT_EQ(query[6], 0xb1);
+    TEST_ASSERT_EQ(query[7], 'q');
+}
+
+static void test_leisure_query(void)
+{
+#define Q(s)    coap_leisure_from_query(s, strlen(s))
+    TEST_ASSERT_EQ(Q(""), 0);
+    TEST_ASSERT_EQ(Q("?leisure=2000"), 2000);
+    TEST_ASSERT_EQ(Q("?a=1&leisure=30&b"), 30);
+    TEST_ASSERT_EQ(Q("leisure=99999999999"), COAP_LEISURE_MAX_MS);
+    TEST_ASSERT_EQ(Q("?leisure="), 0);
+    TEST_ASSERT_EQ(Q("?xleisure=5"), 0);
+    /* need not be null terminated */
+    TEST_ASSERT_EQ(coap_leisure_from_query("leisure=123", 10), 12);
+#undef Q
+}
+
+static int32_t sample;
+
+static int _read(int32_t *val)
+{
+    *val = sample;
+    return 0;
+}
+
+static const sensor_adapt_t adapt = { 500, 60000, 10 };
+
+static const sensor_reg_t sensors[] = {
+    { "temperature", "C", NULL, _read, 100, 1000, 2, NULL, NULL },
+    { "humidity", "%", NULL, _read, 100, 1000, 2, NULL, &adapt },
+};
+
+/* pass a request to the group thread, as if sent to dst */
+static void _group_input(const char *dst, const uint8_t *req, size_t len)
+{
+    gnrc_pktsnip_t *pkt = host_udp_dgram("fe80::1", 40000, dst, req, len);
+    coap_udp_dgram_t dgram;
+    TEST_ASSERT_EQ(coap_udp_read(pkt, &dgram), 0);
+    coap_group_input(&dgram);
+    gnrc_pktbuf_release(pkt);
+}
+
+static void test_group(void)
+{
+    uint8_t req[16];
+    host_req_t r = { .type = 1, .code = 1, .mid = 0x1234, .token = "ab",
+                     .path = "/x", .observe = -1 };
+    size_t len = host_req(&r, req, sizeof(req));
+    /* the response echoes message ID and token */
+    uint8_t rsp[] = { 0x52, 0x45, 0x12, 0x34, 'a', 'b', 0xff, '4', '2' };
+    TEST_ASSERT(coap_group_init() > 0);
+
+    /* unicast requests are answered at once */
+    _group_input("fe80::2", req, len);
+    TEST_ASSERT_EQ(coap_group_defer(rsp, sizeof(rsp), 1000), -1);
+
+    /* group requests after the leisure */
+    _group_input("ff02::fd", req, len);
+    TEST_ASSERT_EQ(coap_group_defer(rsp, sizeof(rsp), 0), -1);
+    TEST_ASSERT_EQ(coap_group_defer(rsp, sizeof(rsp), 1000), 0);
+    unsigned sends = host_udp_sends;
+    host_clock_advance(1000 * US_PER_MS);
+    coap_group_flush();
+    TEST_ASSERT_EQ(host_udp_sends, sends + 1);
+    ipv6_addr_t dst, src;
+    uint16_t port;
+    size_t slen;
+    const uint8_t *sent = host_udp_sent(0, &dst, &port, &slen);
+    ipv6_addr_from_str(&src, "fe80::1");
+    TEST_ASSERT(ipv6_addr_equal(&dst, &src) && (port == 40000));
+    TEST_ASSERT((slen == sizeof(rsp)) && (memcmp(sent, rsp, slen) == 0));
+    /* once only */
+    TEST_ASSERT_EQ(coap_group_defer(rsp, sizeof(rsp), 1000), -1);
+
+    /* records of other requests or too old ones do not match */
+    _group_input("ff02::fd", req, len);
+    rsp[3] ^= 1;
+    TEST_ASSERT_EQ(coap_group_defer(rsp, sizeof(rsp), 1000), -1);
+    rsp[3] ^= 1;
+    host_clock_advance(2 * US_PER_SEC);
+    TEST_ASSERT_EQ(coap_group_defer(rsp, sizeof(rsp), 1000), -1);
+}
+
+static void test_sensor_reg(void)
+{
+    sensor_reg_snapshot_t snap;
+    sample = 2150;
+    TEST_ASSERT_EQ(sensor_reg_setup(sensors, 1), 0);
+    TEST_ASSERT_EQ(sensor_reg_find("temperature", 11), 0);
+    TEST_ASSERT_EQ(sensor_reg_find("temp", 4), -1);
+    sensor_reg_snapshot(&snap);
+    TEST_ASSERT(snap.gen != 0);
+    TEST_ASSERT_EQ(snap.value[0], 2150);
+    uint32_t gen = snap.gen;
+
+    /* not due yet */
+    TEST_ASSERT_EQ(sensor_reg_tick(), 1000 * US_PER_MS);
+    sample = 2250;
+    host_clock_advance(1000 * US_PER_MS);
+    sensor_reg_tick();
+    sensor_reg_snapshot(&snap);
+    TEST_ASSERT_EQ(snap.value[0], 2200);
+    TEST_ASSERT(snap.gen != gen);
+    /* unchanged averages keep the generation */
+    host_clock_advance(1000 * US_PER_MS);
+    sensor_reg_tick();
+    host_clock_advance(1000 * US_PER_MS);
+    sensor_reg_tick();
+    sensor_reg_snapshot(&snap);
+    TEST_ASSERT_EQ(snap.value[0], 2250);
+    gen = snap.gen;
+    host_clock_advance(1000 * US_PER_MS);
+    sensor_reg_tick();
+    sensor_reg_snapshot(&snap);
+    TEST_ASSERT_EQ(snap.gen, gen);
+
+    char buf[64];
+    TEST_ASSERT_EQ(sensor_reg_fmt(0, -5, buf, sizeof(buf)), 5);
+    TEST_ASSERT(strcmp(buf, "-0.05") == 0);
+    sensor_reg_json(&snap, buf, sizeof(buf));
+    TEST_ASSERT(strcmp(buf, "{'temperature': 2250}") == 0);
+    /* truncated, but terminated */
+    TEST_ASSERT(sensor_reg_json(&snap, buf, 8) < 8);
+    TEST_ASSERT_EQ(strlen(buf), 7);
+
+    /* fixed periods are clamped, such that the timer in us cannot wrap */
+    TEST_ASSERT_EQ(sensor_reg_setup(sensors, 2), 0);
+    sensor_reg_set_period(0, UINT32_MAX);
+    TEST_ASSERT_EQ(sensor_reg_period(0), SENSOR_REG_PERIOD_MAX);
+    sensor_reg_set_period(1, 100);
+    TEST_ASSERT_EQ(sensor_reg_period(1), 500);
+    sensor_reg_set_period(1, UINT32_MAX);
+    TEST_ASSERT_EQ(sensor_reg_period(1), 60000);
+    sensor_reg_set_period(1, 0);
+    TEST_ASSERT_EQ(sensor_reg_period(1), 1000);
+
+    /* boards without sensors set up an empty registry */
+    TEST_ASSERT_EQ(sensor_reg_setup(NULL, 0), 0);
+    TEST_ASSERT_EQ(sensor_reg_numof(), 0);
+    TEST_ASSERT_EQ(sensor_reg_find("temperature", 11), -1);
+    sensor_reg_snapshot(&snap);
+    sensor_reg_json(&snap, buf, sizeof(buf));
+    TEST_ASSERT(strncmp(buf, "{}", 2) == 0);
+}
+
+static void test_dlog(void)
+{
+    static const char fmt[] = "[TEST] from peer %u\n";
+    dlog_stats_t stats;
+    dlog_put(fmt, 1, 0, 0, 0);
+    dlog_put(fmt, 2, 0, 0, 0);
+    dlog_put(fmt, 2, 0, 0, 0);
+    dlog_stats(&stats);
+    /* only the line with the same arguments is a repeat */
+    TEST_ASSERT_EQ(stats.lines, 2);
+    TEST_ASSERT_EQ(stats.repeated, 1);
+    dlog_put(fmt, 1, 0, 0, 0);
+    dlog_stats(&stats);
+    TEST_ASSERT_EQ(stats.lines, 3);
+    TEST_ASSERT_EQ(stats.repeated, 1);
+}
+
+static const char *node_addr = "";
+static unsigned node_addr_reads;
+
+static size_t _node_addr(char *buf, size_t len)
+{
+    node_addr_reads++;
+    snprintf(buf, len, "%s", node_addr);
+    return strlen(buf);
+}
+
+static void test_node_info(void)
+{
+    char buf[NODE_INFO_LEN];
+    node_info_init(KERNEL_PID_UNDEF, _node_addr);
+    TEST_ASSERT(node_info_get(buf, sizeof(buf)) > 0);
+    TEST_ASSERT(strstr(buf, "\"addr\":\"\"") != NULL);
+    /* the address is read at most every NODE_INFO_REFRESH */
+    node_addr = "fd17:cafe:cafe:3::1";
+    unsigned reads = node_addr_reads;
+    node_info_get(buf, sizeof(buf));
+    TEST_ASSERT_EQ(node_addr_reads, reads);
+    TEST_ASSERT(strstr(buf, "\"addr\":\"\"") != NULL);
+    host_clock_advance(NODE_INFO_REFRESH);
+    node_info_get(buf, sizeof(buf));
+    TEST_ASSERT(strstr(buf, "\"addr\":\"fd17:cafe:cafe:3::1\"") != NULL);
+    /* and changes are picked up the same way */
+    node_addr = "fd17:cafe:cafe:3::2";
+    host_clock_advance(NODE_INFO_REFRESH);
+    node_info_get(buf, sizeof(buf));
+    TEST_ASSERT(strstr(buf, "\"addr\":\"fd17:cafe:cafe:3::2\"") != NULL);
+}
+
+/* pass an answer to the timesync thread */
+static int _timesync_input(const uint8_t *rsp, size_t len)
+{
+    gnrc_pktsnip_t *pkt = host_udp_dgram("fd17:cafe:cafe:2::1", TIMESYNC_PORT,
+                                         "fe80::2", rsp, len);
+    coap_udp_dgram_t dgram;
+    int res = (coap_udp_read(pkt, &dgram) == 0) ? timesync_input(&dgram) : -2;
+    gnrc_pktbuf_release(pkt);
+    return res;
+}
+
+static void test_timesync(void)
+{
+    uint8_t rsp[48];
+    size_t len;
+    uint16_t port;
+    TEST_ASSERT_EQ(timesync_now(), 0);
+    TEST_ASSERT_EQ(timesync_request(), 0);
+    const uint8_t *req = host_udp_sent(0, NULL, &port, &len);
+    TEST_ASSERT((len == sizeof(rsp)) && (port == TIMESYNC_PORT));
+    TEST_ASSERT_EQ(req[0], (4 << 3) | 3);
+
+    /* server answer at 2017-07-14T02:40:00Z, transmit echoed as originate */
+    memset(rsp, 0, sizeof(rsp));
+    rsp[0] = (4 << 3) | 4;
+    rsp[1] = 1;
+    memcpy(&rsp[24], &req[40], 8);
+    uint32_t secs = 1500000000U + 2208988800U;
+    for (unsigned i = 0; i < 4; i++) {
+        rsp[40 + i] = secs >> (24 - 8 * i);
+    }
+    host_clock_advance(10 * US_PER_MS);
+    /* kiss-o'-death and other nonces are ignored */
+    rsp[1] = 0;
+    TEST_ASSERT_EQ(_timesync_input(rsp, sizeof(rsp)), -1);
+    rsp[1] = 1;
+    rsp[24] ^= 1;
+    TEST_ASSERT_EQ(_timesync_input(rsp, sizeof(rsp)), -1);
+    rsp[24] ^= 1;
+    TEST_ASSERT_EQ(timesync_now(), 0);
+    TEST_ASSERT_EQ(_timesync_input(rsp, sizeof(rsp)), 0);
+    TEST_ASSERT_EQ(timesync_now(), 1500000000U);
+    /* once only, then extrapolated */
+    TEST_ASSERT_EQ(_timesync_input(rsp, sizeof(rsp)), -1);
+    host_clock_advance(2 * US_PER_SEC);
+    TEST_ASSERT_EQ(timesync_now(), 1500000002U);
+}
+
+int main(void)
+{
+    /* first, before other tests queue lines */
+    TEST(test_dlog);
+    TEST(test_dispatch);
+    TEST(test_etag);
+    TEST(test_leisure_query);
+    TEST(test_group);
+    TEST(test_sensor_reg);
+    TEST(test_node_info);
+    /* last, the other tests expect unsynchronized time */
+    TEST(test_timesync);
+    TEST_EXIT();
+}
@@ -0,0 +1,219 @@
+/* tests of the CoAP handlers of the gcoap applications, built once per
+ * application with HOST_APP set to its name, e.g., "monica" */
+
+#include <string.h>
+
+#include "host.h"
+#include "test.h"
+#include "net/gcoap.h"
+#include "xtimer.h"
+
+#include "coap_etag.h"
+#include "coap_group.h"
+#include "net/gnrc/pktbuf.h"
+#include "sensor_reg.h"
+#include "timesync.h"
+
+#define PATH_CLIMATE    "/" HOST_APP "/climate"
+#define PATH_INFO       "/" HOST_APP "/info"
+
+extern int coap_init(void);
+extern int sensor_init(void);
+
+TEST_DEFINE_MAIN_STATE;
+
+static uint8_t buf[GCOAP_PDU_BUF_SIZE];
+
+static ssize_t _request(const host_req_t *req)
+{
+    size_t len = host_req(req, buf, sizeof(buf));
+    if (len == 0) {
+        return -1;
+    }
+    return host_gcoap_request(buf, len, sizeof(buf));
+}
+
+static void test_not_found(void)
+{
+    host_req_t req = { .code = COAP_METHOD_GET, .mid = 1, .token = "ab",
+                       .path = "/" HOST_APP, .observe = -1 };
+    TEST_ASSERT(_request(&req) > 0);
+    TEST_ASSERT_EQ(host_code(buf), 404);
+    req.code = COAP_METHOD_PUT;
+    req.path = PATH_CLIMATE;
+    TEST_ASSERT(_request(&req) > 0);
+    TEST_ASSERT_EQ(host_code(buf), 405);
+}
+
+static void test_info(void)
+{
+    host_req_t req = { .code = COAP_METHOD_GET, .mid = 2, .path = PATH_INFO,
+                       .observe = -1 };
+    ssize_t len = _request(&req);
+    TEST_ASSERT(len > 0);
+    TEST_ASSERT_EQ(host_code(buf), 205);
+    size_t plen;
+    const uint8_t *p = host_payload(buf, len, &plen);
+    TEST_ASSERT(p && (plen > 2) && (p[0] == '{') && (p[plen - 1] == '}'));
+}
+
+static void test_climate(void)
+{
+    host_req_t req = { .type = COAP_TYPE_CON, .code = COAP_METHOD_GET,
+                       .mid = 3, .token = "tok", .path = PATH_CLIMATE,
+                       .observe = -1 };
+    ssize_t len = _request(&req);
+    TEST_ASSERT(len > 0);
+    TEST_ASSERT_EQ(host_code(buf), 205);
+    TEST_ASSERT_EQ((buf[0] >> 4) & 3, COAP_TYPE_ACK);
+    TEST_ASSERT(memcmp(buf + 4, "tok", 3) == 0);
+    size_t plen;
+    const uint8_t *p = host_payload(buf, len, &plen);
+    char json[128];
+    sensor_reg_snapshot_t snap;
+    sensor_reg_snapshot(&snap);
+    sensor_reg_json(&snap, json, sizeof(json));
+    TEST_ASSERT(p && (plen == strlen(json)) && (memcmp(p, json, plen) == 0));
+
+    size_t olen;
+    const uint8_t *etag = host_opt(buf, len, 4, &olen);
+    TEST_ASSERT(etag && (olen == COAP_ETAG_LEN));
+    char tag[COAP_ETAG_LEN];
+    memcpy(tag, etag, sizeof(tag));
+    req.etag = tag;
+    req.etag_len = sizeof(tag);
+    len = _request(&req);
+    TEST_ASSERT_EQ(host_code(buf), 203);
+    TEST_ASSERT(host_payload(buf, len, NULL) == NULL);
+
+    /* a stale tag gets the representation */
+    tag[0] ^= 1;
+    len = _request(&req);
+    TEST_ASSERT_EQ(host_code(buf), 205);
+}
+
+static void test_group(void)
+{
+    host_req_t req = { .type = COAP_TYPE_NON, .code = COAP_METHOD_GET,
+                       .mid = 4, .token = "g", .path = PATH_CLIMATE,
+                       .query = "leisure=500", .observe = -1 };
+    /* unicast, the leisure is ignored */
+    TEST_ASSERT(_request(&req) > 0);
+    TEST_ASSERT_EQ(host_code(buf), 205);
+
+    /* to a group, the group thread sends it later */
+    size_t len = host_req(&req, buf, sizeof(buf));
+    gnrc_pktsnip_t *pkt = host_udp_dgram("fe80::1", 40000, "ff02::fd", buf, len);
+    coap_udp_dgram_t dgram;
+    coap_udp_read(pkt, &dgram);
+    coap_group_input(&dgram);
+    gnrc_pktbuf_release(pkt);
+    TEST_ASSERT_EQ(_request(&req), 0);
+    unsigned sends = host_udp_sends;
+    host_clock_advance(500 * US_PER_MS);
+    coap_group_flush();
+    TEST_ASSERT_EQ(host_udp_sends, sends + 1);
+    const uint8_t *rsp = host_udp_sent(0, NULL, NULL, &len);
+    TEST_ASSERT_EQ(host_code(rsp), 205);
+    TEST_ASSERT(host_payload(rsp, len, NULL) != NULL);
+}
+
+static void test_coaps(void)
+{
+    /* decrypted requests take nanocoap's coap_handle_req() */
+    host_req_t req = { .code = COAP_METHOD_GET, .mid = 4, .path = PATH_INFO,
+                       .observe = -1 };
+    size_t len = host_req(&req, buf, sizeof(buf));
+    coap_pkt_t pdu;
+    TEST_ASSERT_EQ(coap_parse(&pdu, buf, len), 0);
+    ssize_t res = coap_handle_req(&pdu, buf, sizeof(buf));
+    TEST_ASSERT(res > 0);
+    TEST_ASSERT_EQ(host_code(buf), 205);
+}
+
+static int _read_const(int32_t *val)
+{
+    *val = 2150;
+    return 0;
+}
+
+static const sensor_reg_t sensors_const[] = {
+    { "temperature", "C", NULL, _read_const, 100, 1000, 2, NULL, NULL },
+};
+
+/* answer the pending SNTP request with 2018-01-31T12:00:00Z */
+static int _timesync(void)
+{
+    size_t len;
+    const uint8_t *req = host_udp_sent(0, NULL, NULL, &len);
+    uint8_t rsp[48] = { (4 << 3) | 4, 1 };
+    memcpy(&rsp[24], &req[40], 8);
+    uint32_t secs = 1517400000U + 2208988800U;
+    for (unsigned i = 0; i < 4; i++) {
+        rsp[40 + i] = secs >> (24 - 8 * i);
+    }
+    gnrc_pktsnip_t *pkt = host_udp_dgram("fd17:cafe:cafe:2::1", TIMESYNC_PORT,
+                                         "fe80::2", rsp, sizeof(rsp));
+    coap_udp_dgram_t dgram;
+    int res = (coap_udp_read(pkt, &dgram) == 0) ? timesync_input(&dgram) : -1;
+    gnrc_pktbuf_release(pkt);
+    return res;
+}
+
+static void test_climate_valid(void)
+{
+    host_req_t req = { .type = COAP_TYPE_CON, .code = COAP_METHOD_GET,
+                       .mid = 5, .path = PATH_CLIMATE, .observe = -1 };
+    TEST_ASSERT_EQ(sensor_reg_setup(sensors_const, 1), 0);
+    TEST_ASSERT_EQ(timesync_request(), 0);
+    TEST_ASSERT_EQ(_timesync(), 0);
+    /* the first synchronization stamps the averages once */
+    host_clock_advance(US_PER_SEC);
+    sensor_reg_tick();
+    ssize_t len = _request(&req);
+    TEST_ASSERT_EQ(host_code(buf), 205);
+    size_t plen, olen;
+    const uint8_t *p = host_payload(buf, len, &plen);
+    TEST_ASSERT(p && (plen < 64));
+    char json[64];
+    memcpy(json, p, plen);
+    json[plen] = '\0';
+    TEST_ASSERT(strstr(json, "'time': 1517400001") != NULL);
+    const uint8_t *etag = host_opt(buf, len, 4, &olen);
+    TEST_ASSERT(etag && (olen == COAP_ETAG_LEN));
+    char tag[COAP_ETAG_LEN];
+    memcpy(tag, etag, sizeof(tag));
+
+    /* unchanged values, neither time nor tag move with the clock */
+    req.etag = tag;
+    req.etag_len = sizeof(tag);
+    for (unsigned i = 0; i < 3; i++) {
+        host_clock_advance(10 * US_PER_SEC);
+        sensor_reg_tick();
+        req.mid++;
+        len = _request(&req);
+        TEST_ASSERT_EQ(host_code(buf), 203);
+    }
+    req.etag = NULL;
+    req.etag_len = 0;
+    len = _request(&req);
+    TEST_ASSERT_EQ(host_code(buf), 205);
+    p = host_payload(buf, len, &plen);
+    TEST_ASSERT(p && (plen == strlen(json)) && (memcmp(p, json, plen) == 0));
+}
+
+int main(void)
+{
+    if ((sensor_init() < 0) || (coap_init() != 0) || (coap_group_init() < 0)) {
+        puts("init failed");
+        return EXIT_FAILURE;
+    }
+    TEST(test_not_found);
+    TEST(test_info);
+    TEST(test_climate);
+    TEST(test_group);
+    TEST(test_coaps);
+    /* last, replaces the sensors */
+    TEST(test_climate_valid);
+    TEST_EXIT();
+}
@@ -0,0 +1,271 @@
+/* tests of the CoAP handlers of the mote, the file is included to call its
+ * static request processing directly */
+
+#include "../../mote/coap.c"
+
+#include "host.h"
+#include "net/gnrc/pktbuf.h"
+#include "test.h"
+
+TEST_DEFINE_MAIN_STATE;
+
+static uint8_t buf[COAP_BUF_SIZE];
+
+/* send req and get the response in buf, its length or -1 */
+static ssize_t _request(const host_req_t *req)
+{
+    size_t len = host_req(req, buf, sizeof(buf));
+    if (len == 0) {
+        return -1;
+    }
+    return coap_process(buf, len, sizeof(buf));
+}
+
+static int _payload_is(ssize_t len, const char *str)
+{
+    size_t plen;
+    const uint8_t *p = host_payload(buf, len, &plen);
+    return p && (plen == strlen(str)) && (memcmp(p, str, plen) == 0);
+}
+
+static void test_not_found(void)
+{
+    host_req_t req = { .code = COAP_METHOD_GET, .mid = 1, .token = "ab",
+                       .path = "/nope", .observe = -1 };
+    ssize_t len = _request(&req);
+    TEST_ASSERT(len > 0);
+    TEST_ASSERT_EQ(host_code(buf), 404);
+    /* mid and token are echoed */
+    TEST_ASSERT_EQ((buf[2] << 8) | buf[3], 1);
+    TEST_ASSERT_EQ(buf[0] & 0x0f, 2);
+    TEST_ASSERT(memcmp(buf + 4, "ab", 2) == 0);
+    /* POST to an existing path */
+    req.code = COAP_METHOD_POST;
+    req.path = "/led";
+    TEST_ASSERT(_request(&req) > 0);
+    TEST_ASSERT_EQ(host_code(buf), 404);
+    /* too many segments */
+    req.code = COAP_METHOD_GET;
+    req.path = "/a/b/c";
+    TEST_ASSERT(_request(&req) > 0);
+    TEST_ASSERT_EQ(host_code(buf), 404);
+}
+
+static void test_well_known_core(void)
+{
+    host_req_t req = { .code = COAP_METHOD_GET, .mid = 2,
+                       .path = "/.well-known/core", .observe = -1 };
+    ssize_t len = _request(&req);
+    TEST_ASSERT(len > 0);
+    TEST_ASSERT_EQ(host_code(buf), 205);
+    TEST_ASSERT(_payload_is(len, links_all + 1));
+    req.query = "rt=led";
+    len = _request(&req);
+    TEST_ASSERT(_payload_is(len, "</led>;ct=0;rt=\"led\";if=\"actuator\";obs"));
+    req.query = "if=sens*&rt=hum*";
+    len = _request(&req);
+    TEST_ASSERT(_payload_is(len, "</humidity>;ct=0;rt=\"humidity\";if=\"sensor\""));
+    req.query = "rt=none";
+    len = _request(&req);
+    TEST_ASSERT_EQ(host_code(buf), 205);
+    TEST_ASSERT(host_payload(buf, len, NULL) == NULL);
+}
+
+static void test_sensor(void)
+{
+    host_req_t req = { .code = COAP_METHOD_GET, .mid = 3, .token = "t",
+                       .path = "/temperature", .observe = -1 };
+    ssize_t len = _request(&req);
+    TEST_ASSERT(len > 0);
+    TEST_ASSERT_EQ(host_code(buf), 205);
+    char value[16];
+    sensor_reg_fmt(sensor_reg_find("temperature", 11),
+                   sensor_reg_value(sensor_reg_find("temperature", 11)),
+                   value, sizeof(value));
+    TEST_ASSERT(_payload_is(len, value));
+
+    /* revalidate with the tag of the response */
+    size_t olen;
+    const uint8_t *etag = host_opt(buf, len, COAP_OPTION_ETAG, &olen);
+    TEST_ASSERT(etag && (olen == COAP_ETAG_LEN));
+    char tag[COAP_ETAG_LEN];
+    memcpy(tag, etag, sizeof(tag));
+    req.etag = tag;
+    req.etag_len = sizeof(tag);
+    len = _request(&req);
+    TEST_ASSERT_EQ(host_code(buf), 203);
+    TEST_ASSERT(host_payload(buf, len, NULL) == NULL);
+    TEST_ASSERT(host_opt(buf, len, COAP_OPTION_ETAG, &olen) && (olen == 4));
+
+    /* the JSON representation has its own tag */
+    req.payload = "json";
+    len = _request(&req);
+    TEST_ASSERT_EQ(host_code(buf), 205);
+    TEST_ASSERT(host_opt(buf, len, COAP_OPTION_ETAG, &olen) && (olen == 5));
+}
+
+/* pass a datagram from [fe80::1]:40000 to dst to the CoAP thread */
+static void _input(const char *dst, const uint8_t *msg, size_t len)
+{
+    gnrc_pktsnip_t *pkt = host_udp_dgram("fe80::1", 40000, dst, msg, len);
+    coap_input(pkt);
+    gnrc_pktbuf_release(pkt);
+}
+
+/* the last datagram sent, NULL if none since sends */
+static const uint8_t *_sent(unsigned sends, size_t *len)
+{
+    return (host_udp_sends > sends) ? host_udp_sent(0, NULL, NULL, len) : NULL;
+}
+
+static void test_group(void)
+{
+    host_req_t req = { .type = COAP_TYPE_NONCON, .code = COAP_METHOD_GET,
+                       .mid = 7, .token = "g", .path = "/temperature",
+                       .query = "leisure=500", .observe = -1 };
+    size_t len = host_req(&req, buf, sizeof(buf));
+    const uint8_t *rsp;
+    /* unicast, the leisure is ignored */
+    unsigned sends = host_udp_sends;
+    _input("fe80::2", buf, len);
+    TEST_ASSERT((rsp = _sent(sends, &len)) && (host_code(rsp) == 205));
+
+    /* to a group, the group thread sends it later */
+    req.mid++;
+    len = host_req(&req, buf, sizeof(buf));
+    gnrc_pktsnip_t *pkt = host_udp_dgram("fe80::1", 40000, "ff02::fd", buf, len);
+    coap_udp_dgram_t dgram;
+    coap_udp_read(pkt, &dgram);
+    coap_group_input(&dgram);
+    gnrc_pktbuf_release(pkt);
+    sends = host_udp_sends;
+    _input("ff02::fd", buf, len);
+    TEST_ASSERT(_sent(sends, &len) == NULL);
+    host_clock_advance(500 * US_PER_MS);
+    coap_group_flush();
+    TEST_ASSERT((rsp = _sent(sends, &len)) && (host_code(rsp) == 205));
+}
+
+static void test_led(void)
+{
+    extern unsigned host_led_switched;
+    host_req_t req = { .code = COAP_METHOD_PUT, .mid = 4, .path = "/led",
+                       .payload = "r1", .observe = -1 };
+    unsigned switched = host_led_switched;
+    TEST_ASSERT(_request(&req) > 0);
+    TEST_ASSERT_EQ(host_code(buf), 204);
+    TEST_ASSERT(host_led_switched != switched);
+    req.payload = "x9";
+    TEST_ASSERT(_request(&req) > 0);
+    TEST_ASSERT_EQ(host_code(buf), 400);
+    req.payload = NULL;
+    TEST_ASSERT(_request(&req) > 0);
+    TEST_ASSERT_EQ(host_code(buf), 400);
+
+    req.code = COAP_METHOD_GET;
+    ssize_t len = _request(&req);
+    TEST_ASSERT_EQ(host_code(buf), 205);
+    TEST_ASSERT(_payload_is(len, "r1g0b0"));
+}
+
+static void test_observe(void)
+{
+    host_req_t req = { .code = COAP_METHOD_GET, .mid = 5, .token = "obs",
+                       .path = "/led", .observe = 0 };
+    size_t len = host_req(&req, buf, sizeof(buf));
+    size_t olen;
+    unsigned sends = host_udp_sends;
+    _input("fe80::2", buf, len);
+    const uint8_t *rsp = _sent(sends, &len);
+    TEST_ASSERT(rsp && (host_code(rsp) == 205));
+    TEST_ASSERT(host_opt(rsp, len, COAP_OPTION_OBSERVE, &olen) != NULL);
+    TEST_ASSERT_EQ(observers[0].used, 1);
+
+    /* a change in another thread is posted to the CoAP thread */
+    kernel_pid_t target;
+    actuator_set("g1", 2);
+    const msg_t *m = host_msg(0, &target);
+    TEST_ASSERT(m && (m->type == COAP_MSG_NOTIFY) && (target == coap_thread_pid));
+    sends = host_udp_sends;
+    led_notify();
+    TEST_ASSERT((rsp = _sent(sends, &len)) && (host_code(rsp) == 205));
+    TEST_ASSERT_EQ((rsp[0] >> 4) & 3, COAP_TYPE_NONCON);
+
+    /* a confirmable notification now and then, acknowledged */
+    host_clock_advance(COAP_OBSERVE_REFRESH);
+    sends = host_udp_sends;
+    observe_timeout();
+    TEST_ASSERT((rsp = _sent(sends, &len)) && ((rsp[0] >> 4) & 3) == COAP_TYPE_CON);
+    uint8_t ack[4] = { 0x60, 0, rsp[2], rsp[3] };
+    _input("fe80::2", ack, sizeof(ack));
+    TEST_ASSERT_EQ(observers[0].pending, 0);
+
+    /* retransmitted, then the observer is dropped */
+    host_clock_advance(COAP_OBSERVE_REFRESH);
+    sends = host_udp_sends;
+    observe_timeout();
+    for (unsigned i = 0; i <= COAP_MAX_RETRANSMIT; i++) {
+        host_clock_advance(COAP_ACK_TIMEOUT << i);
+        observe_timeout();
+    }
+    TEST_ASSERT_EQ(host_udp_sends, sends + 1 + COAP_MAX_RETRANSMIT);
+    TEST_ASSERT_EQ(observers[0].used, 0);
+
+    /* a reset of a notification drops it */
+    req.mid++;
+    len = host_req(&req, buf, sizeof(buf));
+    _input("fe80::2", buf, len);
+    TEST_ASSERT_EQ(observers[0].used, 1);
+    sends = host_udp_sends;
+    led_notify();
+    TEST_ASSERT((rsp = _sent(sends, &len)) != NULL);
+    uint8_t rst[4] = { 0x70, 0, rsp[2], rsp[3] };
+    _input("fe80::2", rst, sizeof(rst));
+    TEST_ASSERT_EQ(observers[0].used, 0);
+
+    /* a GET without Observe deregisters, new message IDs are no duplicates */
+    req.mid++;
+    len = host_req(&req, buf, sizeof(buf));
+    _input("fe80::2", buf, len);
+    TEST_ASSERT_EQ(observers[0].used, 1);
+    req.mid++;
+    req.observe = -1;
+    len = host_req(&req, buf, sizeof(buf));
+    sends = host_udp_sends;
+    _input("fe80::2", buf, len);
+    TEST_ASSERT((rsp = _sent(sends, &len)) &&
+                (host_opt(rsp, len, COAP_OPTION_OBSERVE, &olen) == NULL));
+    TEST_ASSERT_EQ(observers[0].used, 0);
+}
+
+static void test_malformed(void)
+{
+    /* version 0, truncated token, bad option */
+    static const uint8_t bad[][6] = {
+        { 0x00, 0x01, 0, 1 },
+        { 0x48, 0x01, 0, 1, 'a', 'b' },
+        { 0x40, 0x01, 0, 1, 0xf0, 0 },
+    };
+    for (unsigned i = 0; i < 3; i++) {
+        memcpy(buf, bad[i], sizeof(bad[i]));
+        TEST_ASSERT_EQ(coap_process(buf, sizeof(bad[i]), sizeof(buf)), -1);
+    }
+}
+
+int main(void)
+{
+    actuator_init();
+    sensor_start_thread();
+    coap_start_thread();
+    coap_group_init();
+    /* the tests play the CoAP thread */
+    coap_thread_pid = host_pid;
+    TEST(test_not_found);
+    TEST(test_well_known_core);
+    TEST(test_sensor);
+    TEST(test_group);
+    TEST(test_led);
+    TEST(test_observe);
+    TEST(test_malformed);
+    TEST_EXIT();
+}
@@ -0,0 +1,81 @@
+/* sweep of the fixed point MQ135 conversion against the float power law
+ * over the full oversampled range */
+
+#include <math.h>
+#include <stdint.h>
+
+#include "host.h"
+#include "test.h"
+
+#include "mq135.h"
+
+/* 0.97 % and 0.5 ppm measured, ppm of at least REL_MIN are compared relative */
+#define MAX_ERR_REL     (0.01)
+#define MAX_ERR_ABS     (1.0)
+#define REL_MIN         (50.0)
+
+TEST_DEFINE_MAIN_STATE;
+
+static const mq135_params_t params[] = {
+    { .line = 0, .r_load = 10000, .r0 = 76630, MQ135_CURVE_CO2 },
+};
+
+static double _ref_ppm(const mq135_params_t *p, uint32_t raw)
+{
+    double full = 1UL << MQ135_BITS;
+    double rs = p->r_load * (full - raw) / raw;
+    double ppm = p->a / 100.0 * pow(rs / p->r0, p->b / 1000.0);
+    return (ppm < MQ135_PPM_MAX) ? ppm : MQ135_PPM_MAX;
+}
+
+static void test_ppm(void)
+{
+    double max_rel = 0, max_abs = 0;
+    for (uint32_t raw = 1; raw < (1UL << MQ135_BITS); raw++) {
+        double ref = _ref_ppm(&params[0], raw);
+        double err = fabs(mq135_ppm(&params[0], raw) - ref);
+        if ((ref >= REL_MIN) && ((err / ref) > max_rel)) {
+            max_rel = err / ref;
+        }
+        else if ((ref < REL_MIN) && (err > max_abs)) {
+            max_abs = err;
+        }
+    }
+    printf("ppm: max error %.2f %% from %.0f ppm, %.2f ppm below\n",
+           max_rel * 100, REL_MIN, max_abs);
+    TEST_ASSERT(max_rel <= MAX_ERR_REL);
+    TEST_ASSERT(max_abs <= MAX_ERR_ABS);
+    /* ends of the range */
+    TEST_ASSERT_EQ(mq135_ppm(&params[0], 0), 0);
+    TEST_ASSERT_EQ(mq135_ppm(&params[0], 1UL << MQ135_BITS), MQ135_PPM_MAX);
+}
+
+static void test_read(void)
+{
+    uint32_t raw;
+    int32_t ppm;
+    TEST_ASSERT_EQ(mq135_init(params, 1), 0);
+    TEST_ASSERT_EQ(mq135_read_raw(1, &raw), -1);
+    /* a burst of equal conversions gains MQ135_BURST_SHIFT zero bits */
+    host_adc_value = 2048;
+    TEST_ASSERT_EQ(mq135_read_raw(0, &raw), 0);
+    TEST_ASSERT_EQ(raw, 2048U << MQ135_BURST_SHIFT);
+    /* and serves further reads while it is young */
+    host_adc_value = 1024;
+    TEST_ASSERT_EQ(mq135_read(0, &ppm), 0);
+    TEST_ASSERT_EQ((uint32_t)ppm, mq135_ppm(&params[0], raw));
+    host_clock_advance(MQ135_BURST_AGE + 1);
+    TEST_ASSERT_EQ(mq135_read_raw(0, &raw), 0);
+    TEST_ASSERT_EQ(raw, 1024U << MQ135_BURST_SHIFT);
+    /* failed conversions invalidate the burst */
+    host_adc_value = -1;
+    host_clock_advance(MQ135_BURST_AGE + 1);
+    TEST_ASSERT_EQ(mq135_read_raw(0, &raw), -1);
+}
+
+int main(void)
+{
+    TEST(test_ppm);
+    TEST(test_read);
+    TEST_EXIT();
+}
@@ -0,0 +1,308 @@
+/* tests of the MQTT-SN publisher session of monica against a broker played
+ * by the test: window, retransmissions and loss of the broker */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "host.h"
+#include "test.h"
+#include "xtimer.h"
+
+#include "coap_udp.h"
+#include "monica.h"
+#include "net/gnrc/pktbuf.h"
+
+TEST_DEFINE_MAIN_STATE;
+
+#define SN_CONNECT      (0x04)
+#define SN_CONNACK      (0x05)
+#define SN_REGISTER     (0x0a)
+#define SN_REGACK       (0x0b)
+#define SN_PUBLISH      (0x0c)
+#define SN_PUBACK       (0x0d)
+#define SN_PINGREQ      (0x16)
+#define SN_PINGRESP     (0x17)
+#define SN_DISCONNECT   (0x18)
+
+static event_queue_t queue;
+static event_t on_cmd;
+
+static uint16_t _u16(const uint8_t *buf)
+{
+    return ((uint16_t)buf[0] << 8) | buf[1];
+}
+
+/* datagram sent back packets ago to the broker, NULL if of another type */
+static const uint8_t *_sent(unsigned back, uint8_t type, size_t *len)
+{
+    ipv6_addr_t dst, broker;
+    uint16_t port;
+    const uint8_t *p = host_udp_sent(back, &dst, &port, len);
+    ipv6_addr_from_str(&broker, MONICA_MQTT_ADDR);
+    if ((p == NULL) || (port != MONICA_MQTT_PORT) ||
+        !ipv6_addr_equal(&dst, &broker) || (*len < 2) || (p[1] != type)) {
+        return NULL;
+    }
+    return p;
+}
+
+/* answer of the broker, body after length and type */
+static void _answer(uint16_t port, uint8_t type, const uint8_t *body, size_t len)
+{
+    uint8_t pkt[16] = { len + 2, type };
+    if (len > 0) {
+        memcpy(&pkt[2], body, len);
+    }
+    gnrc_pktsnip_t *snip = host_udp_dgram(MONICA_MQTT_ADDR, port, "fe80::2",
+                                          pkt, len + 2);
+    coap_udp_dgram_t dgram;
+    TEST_ASSERT_EQ(coap_udp_read(snip, &dgram), 0);
+    mqtt_input(&dgram);
+    gnrc_pktbuf_release(snip);
+}
+
+static void _connack(void)
+{
+    uint8_t body[] = { 0 };
+    _answer(MONICA_MQTT_PORT, SN_CONNACK, body, sizeof(body));
+}
+
+/* REGACK of the last REGISTER, assigns topic ID id */
+static void _regack(uint16_t id)
+{
+    size_t len;
+    const uint8_t *reg = _sent(0, SN_REGISTER, &len);
+    TEST_ASSERT(reg != NULL);
+    uint8_t body[] = { id >> 8, id & 0xff, reg[4], reg[5], 0 };
+    _answer(MONICA_MQTT_PORT, SN_REGACK, body, sizeof(body));
+}
+
+static void _puback(uint16_t topic, uint16_t id, uint8_t rc)
+{
+    uint8_t body[] = { topic >> 8, topic & 0xff, id >> 8, id & 0xff, rc };
+    _answer(MONICA_MQTT_PORT, SN_PUBACK, body, sizeof(body));
+}
+
+/* check PUBLISH sent back packets ago, id gets its message ID */
+static void _publish(unsigned back, uint8_t flags, uint16_t topic,
+                     const char *data, uint16_t *id)
+{
+    size_t len;
+    const uint8_t *p = _sent(back, SN_PUBLISH, &len);
+    *id = 0;
+    TEST_ASSERT(p != NULL);
+    TEST_ASSERT_EQ(p[2], flags);
+    TEST_ASSERT_EQ(_u16(&p[3]), topic);
+    TEST_ASSERT_EQ(len, 7 + strlen(data));
+    TEST_ASSERT(memcmp(&p[7], data, strlen(data)) == 0);
+    *id = _u16(&p[5]);
+}
+
+static void _connect(void)
+{
+    size_t len;
+    mqtt_session_start();
+    const uint8_t *p = _sent(0, SN_CONNECT, &len);
+    TEST_ASSERT(p != NULL);
+    /* clean session, protocol ID, keepalive, own client ID */
+    TEST_ASSERT_EQ(p[2], 0x04);
+    TEST_ASSERT_EQ(p[3], 0x01);
+    TEST_ASSERT_EQ(_u16(&p[4]), MONICA_MQTT_KEEPALIVE);
+    TEST_ASSERT_EQ(len, 6 + strlen("monica-0-pub"));
+    TEST_ASSERT(memcmp(&p[6], "monica-0-pub", len - 6) == 0);
+    _connack();
+    TEST_ASSERT_EQ(mqtt_state(), MQTT_CONNECTED);
+}
+
+static void test_connect(void)
+{
+    mqtt_stats_t stats;
+    TEST_ASSERT_EQ(mqtt_init(&queue, &on_cmd), 0);
+    TEST_ASSERT_EQ(mqtt_state(), MQTT_DISCONNECTED);
+    mqtt_session_start();
+    TEST_ASSERT(_sent(0, SN_CONNECT, &(size_t){ 0 }) != NULL);
+    /* not from the broker port */
+    uint8_t body[] = { 0 };
+    _answer(MONICA_MQTT_PORT + 1, SN_CONNACK, body, sizeof(body));
+    TEST_ASSERT_EQ(mqtt_state(), MQTT_DISCONNECTED);
+    /* CONNECT sent again when due */
+    unsigned sends = host_udp_sends;
+    host_clock_advance(MONICA_MQTT_RETRY);
+    mqtt_tick();
+    TEST_ASSERT_EQ(host_udp_sends, sends + 1);
+    TEST_ASSERT(_sent(0, SN_CONNECT, &(size_t){ 0 }) != NULL);
+    _connack();
+    TEST_ASSERT_EQ(mqtt_state(), MQTT_CONNECTED);
+    mqtt_stats(&stats);
+    TEST_ASSERT_EQ(stats.connects, 1);
+}
+
+static void test_window(void)
+{
+    mqtt_stats_t before, stats;
+    const char *data[] = { "c0", "c1", "c2", "c3", "c4" };
+    uint16_t ids[MONICA_MQTT_WINDOW];
+    mqtt_stats(&before);
+    for (unsigned i = 0; i < MONICA_MQTT_WINDOW; i++) {
+        TEST_ASSERT_EQ(mqtt_pub(MONICA_TOPIC_CLIMATE, data[i], 1), 0);
+    }
+    /* registered once, then all sent without waiting for a PUBACK */
+    mqtt_tick();
+    _regack(7);
+    for (unsigned i = 0; i < MONICA_MQTT_WINDOW; i++) {
+        _publish(MONICA_MQTT_WINDOW - 1 - i, 0x20, 7, data[i], &ids[i]);
+        TEST_ASSERT(ids[i] != 0);
+        TEST_ASSERT((i == 0) || (ids[i] != ids[i - 1]));
+    }
+    /* window full, the next one waits */
+    unsigned sends = host_udp_sends;
+    TEST_ASSERT_EQ(mqtt_pub(MONICA_TOPIC_CLIMATE, data[4], 1), 0);
+    mqtt_tick();
+    TEST_ASSERT_EQ(host_udp_sends, sends);
+    /* acknowledged out of order, frees a slot */
+    _puback(7, ids[1], 0);
+    TEST_ASSERT_EQ(host_udp_sends, sends + 1);
+    uint16_t id4;
+    _publish(0, 0x20, 7, data[4], &id4);
+    /* unknown IDs and congestion change nothing */
+    _puback(7, ids[1], 0);
+    _puback(7, ids[2], 1);
+    mqtt_stats(&stats);
+    TEST_ASSERT_EQ(stats.delivered - before.delivered, 1);
+    TEST_ASSERT_EQ(host_udp_sends, sends + 1);
+    /* not acknowledged in time, sent again with DUP and the same ID, c4
+     * took the slot of c1 */
+    host_clock_advance(MONICA_MQTT_RETRY);
+    mqtt_tick();
+    TEST_ASSERT_EQ(host_udp_sends, sends + 1 + MONICA_MQTT_WINDOW);
+    uint16_t dups[] = { ids[0], id4, ids[2], ids[3] };
+    const char *dup_data[] = { data[0], data[4], data[2], data[3] };
+    for (unsigned i = 0; i < MONICA_MQTT_WINDOW; i++) {
+        uint16_t id;
+        _publish(MONICA_MQTT_WINDOW - 1 - i, 0xa0, 7, dup_data[i], &id);
+        TEST_ASSERT_EQ(id, dups[i]);
+    }
+    for (unsigned i = 0; i < MONICA_MQTT_WINDOW; i++) {
+        _puback(7, dups[i], 0);
+    }
+    mqtt_stats(&stats);
+    TEST_ASSERT_EQ(stats.delivered - before.delivered, 5);
+    TEST_ASSERT_EQ(stats.retried - before.retried, MONICA_MQTT_WINDOW);
+    TEST_ASSERT_EQ(stats.dropped, before.dropped);
+    /* nothing in flight, nothing due */
+    sends = host_udp_sends;
+    host_clock_advance(MONICA_MQTT_RETRY);
+    mqtt_tick();
+    TEST_ASSERT_EQ(host_udp_sends, sends);
+}
+
+static void test_qos0(void)
+{
+    mqtt_stats_t before, stats;
+    uint16_t id;
+    mqtt_stats(&before);
+    TEST_ASSERT_EQ(mqtt_pub(MONICA_TOPIC_INFO, "i0", 0), 0);
+    mqtt_tick();
+    _regack(8);
+    _publish(0, 0x00, 8, "i0", &id);
+    TEST_ASSERT_EQ(id, 0);
+    TEST_ASSERT_EQ(mqtt_pub(MONICA_TOPIC_INFO, "i1", 0), 0);
+    mqtt_tick();
+    _publish(0, 0x00, 8, "i1", &id);
+    mqtt_stats(&stats);
+    TEST_ASSERT_EQ(stats.published - before.published, 2);
+    TEST_ASSERT_EQ(stats.delivered, before.delivered);
+}
+
+static void test_lost(void)
+{
+    mqtt_stats_t before, stats;
+    mqtt_stats(&before);
+    unsigned discons = host_emcute_discons;
+    uint16_t id0, id;
+    /* the second is sent half a timeout after the first */
+    TEST_ASSERT_EQ(mqtt_pub(MONICA_TOPIC_CLIMATE, "l0", 1), 0);
+    mqtt_tick();
+    _publish(0, 0x20, 7, "l0", &id0);
+    host_clock_advance(MONICA_MQTT_RETRY / 2);
+    TEST_ASSERT_EQ(mqtt_pub(MONICA_TOPIC_CLIMATE, "l1", 1), 0);
+    mqtt_tick();
+    _publish(0, 0x20, 7, "l1", &id);
+    for (unsigned i = 1; i < MONICA_MQTT_TRIES; i++) {
+        host_clock_advance(MONICA_MQTT_RETRY / 2);
+        mqtt_tick();
+        _publish(0, 0xa0, 7, "l0", &id);
+        TEST_ASSERT_EQ(id, id0);
+        host_clock_advance(MONICA_MQTT_RETRY / 2);
+        mqtt_tick();
+        _publish(0, 0xa0, 7, "l1", &id);
+    }
+    TEST_ASSERT_EQ(mqtt_state(), MQTT_CONNECTED);
+    /* no answer to the last try of l0, the session is given up */
+    host_clock_advance(MONICA_MQTT_RETRY / 2);
+    mqtt_tick();
+    TEST_ASSERT(_sent(0, SN_DISCONNECT, &(size_t){ 0 }) != NULL);
+    TEST_ASSERT_EQ(mqtt_state(), MQTT_DISCONNECTED);
+    TEST_ASSERT_EQ(host_emcute_discons, discons + 1);
+    mqtt_stats(&stats);
+    TEST_ASSERT_EQ(stats.dropped - before.dropped, 1);
+    TEST_ASSERT_EQ(stats.retried - before.retried, 2 * (MONICA_MQTT_TRIES - 1));
+    /* l1 is kept but was sent as often as allowed, a new session drops it
+     * and registers the topic again for the next message */
+    _connect();
+    mqtt_stats(&stats);
+    TEST_ASSERT_EQ(stats.dropped - before.dropped, 2);
+    TEST_ASSERT_EQ(stats.connects - before.connects, 1);
+    TEST_ASSERT_EQ(mqtt_pub(MONICA_TOPIC_CLIMATE, "l2", 1), 0);
+    mqtt_tick();
+    _regack(9);
+    _publish(0, 0x20, 9, "l2", &id);
+    _puback(9, id, 0);
+    mqtt_stats(&stats);
+    TEST_ASSERT_EQ(stats.delivered - before.delivered, 1);
+}
+
+static void test_keepalive(void)
+{
+    size_t len;
+    unsigned discons = host_emcute_discons;
+    /* quiet, but not long enough */
+    unsigned sends = host_udp_sends;
+    host_clock_advance(MONICA_MQTT_PING - US_PER_MS);
+    mqtt_tick();
+    TEST_ASSERT_EQ(host_udp_sends, sends);
+    host_clock_advance(US_PER_MS);
+    mqtt_tick();
+    TEST_ASSERT_EQ(host_udp_sends, sends + 1);
+    TEST_ASSERT(_sent(0, SN_PINGREQ, &len) != NULL);
+    TEST_ASSERT_EQ(len, 2);
+    _answer(MONICA_MQTT_PORT, SN_PINGRESP, NULL, 0);
+    host_clock_advance(MONICA_MQTT_RETRY);
+    mqtt_tick();
+    TEST_ASSERT_EQ(host_udp_sends, sends + 1);
+    /* the broker may ask too */
+    _answer(MONICA_MQTT_PORT, SN_PINGREQ, NULL, 0);
+    TEST_ASSERT(_sent(0, SN_PINGRESP, &len) != NULL);
+    /* no PINGRESP, the session is lost without any message to publish */
+    host_clock_advance(MONICA_MQTT_PING);
+    for (unsigned i = 0; i < MONICA_MQTT_TRIES; i++) {
+        mqtt_tick();
+        TEST_ASSERT(_sent(0, SN_PINGREQ, &len) != NULL);
+        host_clock_advance(MONICA_MQTT_RETRY);
+    }
+    TEST_ASSERT_EQ(mqtt_state(), MQTT_CONNECTED);
+    mqtt_tick();
+    TEST_ASSERT(_sent(0, SN_DISCONNECT, &len) != NULL);
+    TEST_ASSERT_EQ(mqtt_state(), MQTT_DISCONNECTED);
+    TEST_ASSERT_EQ(host_emcute_discons, discons + 1);
+}
+
+int main(void)
+{
+    TEST(test_connect);
+    TEST(test_window);
+    TEST(test_qos0);
+    TEST(test_lost);
+    TEST(test_keepalive);
+    TEST_EXIT();
+}
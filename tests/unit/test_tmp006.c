@@ -0,0 +1,71 @@
+/* sweep of the fixed point TMP006 conversion against the float reference,
+ * tmp006_convert() of RIOT in double precision */
+
+#include <math.h>
+#include <stdint.h>
+
+#include "test.h"
+
+#include "tmp006_fixed.h"
+
+/* 1.16 cK measured, tmp006_fixed.h documents 2 cK */
+#define MAX_ERR_CK      (1.2)
+#define AMB_MIN_C       (-40.0)
+#define AMB_MAX_C       (125.0)
+#define OBJ_MIN_C       (-40.0)
+#define OBJ_MAX_C       (200.0)
+
+TEST_DEFINE_MAIN_STATE;
+
+static double _ref_object(int16_t rawv, int16_t rawt)
+{
+    double tdie = rawt / 128.0 + 273.15;
+    double v = rawv * 156.25e-9;
+    double td = tdie - 298.15;
+    double s = 6.4e-14 * (1 + 1.75e-3 * td - 1.678e-5 * td * td);
+    double vos = -2.94e-5 - 5.7e-7 * td + 4.63e-9 * td * td;
+    double f = (v - vos) + 13.4 * (v - vos) * (v - vos);
+    double t4 = pow(tdie, 4) + f / s;
+    return (t4 > 0) ? pow(t4, 0.25) - 273.15 : NAN;
+}
+
+static void test_ambient(void)
+{
+    double max = 0;
+    for (int rawt = AMB_MIN_C * 128; rawt <= AMB_MAX_C * 128; rawt++) {
+        double err = fabs(tmp006_fixed_ambient(rawt) - rawt / 1.28);
+        max = (err > max) ? err : max;
+    }
+    printf("ambient: max error %.2f cK\n", max);
+    /* rounding only */
+    TEST_ASSERT(max <= 0.5);
+}
+
+static void test_object(void)
+{
+    double max = 0;
+    unsigned points = 0;
+    for (int rawt = AMB_MIN_C * 128; rawt <= AMB_MAX_C * 128; rawt += 16) {
+        for (int rawv = INT16_MIN; rawv <= INT16_MAX; rawv += 7) {
+            double ref = _ref_object(rawv, rawt);
+            if (!(ref >= OBJ_MIN_C) || (ref > OBJ_MAX_C)) {
+                continue;
+            }
+            double err = fabs(tmp006_fixed_object(rawv, rawt) - ref * 100);
+            if (err > max) {
+                max = err;
+            }
+            points++;
+        }
+    }
+    printf("object: max error %.2f cK over %u points\n", max, points);
+    TEST_ASSERT(points > 100000);
+    TEST_ASSERT(max <= MAX_ERR_CK);
+}
+
+int main(void)
+{
+    TEST(test_ambient);
+    TEST(test_object);
+    TEST_EXIT();
+}